@@ -5,13 +5,14 @@ import org.junit.Test
 import org.junit.runner.RunWith
 import org.junit.Assert.assertArrayEquals
 import org.junit.Assert.assertEquals
+import org.junit.Assert.assertThrows
 import org.junit.Assert.assertTrue
 
 @RunWith(AndroidJUnit4::class)
 class WSPREncoderTest {
 
     @Test
-    fun testBasicEncodingMatchesJNI() {
+    fun testBasicEncodingMatchesReference() {
         val callsign = "W1ABC"
         val locator = "FN20"
         val power = 30
@@ -23,15 +24,15 @@ class WSPREncoderTest {
             WSPREncoder.WSPRMessage(callsign, locator, power, offset, lsb)
         )
 
-        // JNI implementation
-        val jniResult = CJarInterface.WSPREncodeToFrequencies(
+        // Bit-by-bit reference implementation
+        val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
             callsign, locator, power, offset, lsb
         )
 
         // Should produce identical results
         assertEquals(162, kotlinResult.size)
-        assertEquals(162, jniResult.size)
-        assertArrayEquals(jniResult, kotlinResult)
+        assertEquals(162, referenceResult.size)
+        assertArrayEquals(referenceResult, kotlinResult)
     }
 
     @Test
@@ -46,11 +47,11 @@ class WSPREncoderTest {
             WSPREncoder.WSPRMessage(callsign, locator, power, offset, lsb)
         )
 
-        val jniResult = CJarInterface.WSPREncodeToFrequencies(
+        val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
             callsign, locator, power, offset, lsb
         )
 
-        assertArrayEquals(jniResult, kotlinResult)
+        assertArrayEquals(referenceResult, kotlinResult)
     }
 
     @Test
@@ -65,11 +66,11 @@ class WSPREncoderTest {
             WSPREncoder.WSPRMessage(callsign, locator, power, offset, lsb)
         )
 
-        val jniResult = CJarInterface.WSPREncodeToFrequencies(
+        val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
             callsign, locator, power, offset, lsb
         )
 
-        assertArrayEquals(jniResult, kotlinResult)
+        assertArrayEquals(referenceResult, kotlinResult)
     }
 
     @Test
@@ -92,13 +93,13 @@ class WSPREncoderTest {
                 WSPREncoder.WSPRMessage(callsign, locator, power)
             )
 
-            val jniResult = CJarInterface.WSPREncodeToFrequencies(
+            val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
                 callsign, locator, power, 0, false
             )
 
             assertArrayEquals(
                 "Failed for callsign: $callsign",
-                jniResult,
+                referenceResult,
                 kotlinResult
             )
         }
@@ -124,13 +125,13 @@ class WSPREncoderTest {
                 WSPREncoder.WSPRMessage(callsign, locator, power)
             )
 
-            val jniResult = CJarInterface.WSPREncodeToFrequencies(
+            val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
                 callsign, locator, power, 0, false
             )
 
             assertArrayEquals(
                 "Failed for locator: $locator",
-                jniResult,
+                referenceResult,
                 kotlinResult
             )
         }
@@ -147,13 +148,13 @@ class WSPREncoderTest {
                 WSPREncoder.WSPRMessage(callsign, locator, power)
             )
 
-            val jniResult = CJarInterface.WSPREncodeToFrequencies(
+            val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
                 callsign, locator, power, 0, false
             )
 
             assertArrayEquals(
                 "Failed for power: $power dBm",
-                jniResult,
+                referenceResult,
                 kotlinResult
             )
         }
@@ -170,13 +171,13 @@ class WSPREncoderTest {
                 WSPREncoder.WSPRMessage(callsign, locator, inputPower)
             )
 
-            val jniResult = CJarInterface.WSPREncodeToFrequencies(
+            val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
                 callsign, locator, inputPower, 0, false
             )
 
             assertArrayEquals(
                 "Failed for power correction: $inputPower dBm",
-                jniResult,
+                referenceResult,
                 kotlinResult
             )
         }
@@ -249,6 +250,49 @@ class WSPREncoderTest {
         }
     }
 
+    @Test
+    fun testType2AndType3MatchReference() {
+        val messages = listOf(
+            WSPREncoder.WSPRMessage("PJ4/K1ABC", "", 37),
+            WSPREncoder.WSPRMessage("K1ABC/P", "FN42", 37),
+            WSPREncoder.WSPRMessage("W1AW/12", "", 30),
+            WSPREncoder.WSPRMessage("K1ABC", "FN42ab", 37),
+            WSPREncoder.WSPRMessage("PJ4/K1ABC", "FN42AB", 23, 100, true)
+        )
+
+        for (message in messages) {
+            assertArrayEquals(
+                "Failed: $message",
+                WSPRReferenceEncoder.encodeToFrequencies(
+                    message.callsign, message.locator, message.powerDbm, message.offsetHz, message.lsbMode
+                ),
+                WSPREncoder.encodeToFrequencies(message)
+            )
+        }
+    }
+
+    @Test
+    fun testRejectsMessagesWSPRCannotCarry() {
+        val invalid = listOf(
+            WSPREncoder.WSPRMessage("ABCD", "FN20", 30),      // no digit in position 2 or 3
+            WSPREncoder.WSPRMessage("W1ABCD", "FN20", 30),    // 4-letter suffix
+            WSPREncoder.WSPRMessage("K1ABC/123", "", 30),     // 3-character suffix
+            WSPREncoder.WSPRMessage("K/15", "", 30),          // two characters after '/' are a suffix
+            WSPREncoder.WSPRMessage("W1ABC", "FN2", 30),      // short locator
+            WSPREncoder.WSPRMessage("W1ABC", "", 30),         // Type 1 needs a locator
+            WSPREncoder.WSPRMessage("W1ABC", "SN20", 30),     // field beyond R
+            WSPREncoder.WSPRMessage("W1ABC", "FN20ZZ", 30),   // subsquare beyond X
+            WSPREncoder.WSPRMessage("W1ABC", "FN20", 61),     // power above 60 dBm
+            WSPREncoder.WSPRMessage("W1ABC", "FN20", -1)      // negative power
+        )
+
+        for (message in invalid) {
+            assertThrows("Accepted: $message", IllegalArgumentException::class.java) {
+                WSPREncoder.encodeToFrequencies(message)
+            }
+        }
+    }
+
     @Test
     fun testComprehensiveComparison() {
         val callsigns = listOf("W1ABC", "K1JT", "VE3XYZ")
@@ -267,15 +311,20 @@ class WSPREncoderTest {
                                 WSPREncoder.WSPRMessage(callsign, locator, power, offset, lsb)
                             )
 
-                            val jniResult = CJarInterface.WSPREncodeToFrequencies(
+                            val referenceResult = WSPRReferenceEncoder.encodeToFrequencies(
                                 callsign, locator, power, offset, lsb
                             )
 
                             assertArrayEquals(
                                 "Failed: $callsign $locator ${power}dBm offset=${offset}Hz lsb=$lsb",
-                                jniResult,
+                                referenceResult,
                                 kotlinResult
                             )
+                            assertArrayEquals(
+                                "JNI failed: $callsign $locator ${power}dBm offset=${offset}Hz lsb=$lsb",
+                                referenceResult,
+                                CJarInterface.WSPREncodeToFrequencies(callsign, locator, power, offset, lsb)
+                            )
                             testCount++
                         }
                     }
@@ -0,0 +1,61 @@
+package org.operatorfoundation.audiocoder
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+
+@RunWith(AndroidJUnit4::class)
+class WSPRLocatorPathsTest {
+
+    private val heard = arrayOf("JO65", "IO91wm", "PM95", "FN20", "QF22", "RR99xx99")
+
+    @Test
+    fun testBatchMatchesSingleDistance() {
+        val km = DoubleArray(heard.size)
+        val azimuth = DoubleArray(heard.size)
+
+        assertEquals(heard.size, CJarInterface.WSPRGetLocatorPathsFrom("FN20", heard, km, azimuth))
+        for (i in heard.indices) {
+            val expected = CJarInterface.WSPRGetDistanceBetweenLocators("FN20", heard[i])
+            assertEquals("Failed for ${heard[i]}", expected, km[i], 1e-6)
+            assertTrue(azimuth[i] >= 0.0 && azimuth[i] < 360.0)
+        }
+    }
+
+    @Test
+    fun testPairsMatchOrigin() {
+        val from = Array(heard.size) { "FN20" }
+        val fromKm = DoubleArray(heard.size)
+        val pairKm = DoubleArray(heard.size)
+
+        CJarInterface.WSPRGetLocatorPathsFrom("FN20", heard, fromKm, null)
+        assertEquals(heard.size, CJarInterface.WSPRGetLocatorPaths(from, heard, pairKm, null))
+        for (i in heard.indices) {
+            assertEquals(fromKm[i], pairKm[i], 0.0)
+        }
+    }
+
+    @Test
+    fun testBearings() {
+        val km = DoubleArray(2)
+        val azimuth = DoubleArray(2)
+
+        // Due north and due east of the centre of JJ00
+        CJarInterface.WSPRGetLocatorPathsFrom("JJ00", arrayOf("JJ05", "JJ50"), km, azimuth)
+        assertEquals(0.0, minOf(azimuth[0], 360.0 - azimuth[0]), 1e-6)
+        assertEquals(90.0, azimuth[1], 0.1)
+    }
+
+    @Test
+    fun testMalformedLocators() {
+        val km = DoubleArray(3)
+
+        assertEquals(3, CJarInterface.WSPRGetLocatorPathsFrom("FN20", arrayOf("FN2", "ZZ00", "JO65"), km, null))
+        assertTrue(km[0].isNaN())
+        assertTrue(km[1].isNaN())
+        assertTrue(!km[2].isNaN())
+        assertEquals(-1, CJarInterface.WSPRGetLocatorPaths(arrayOf("FN20"), heard, DoubleArray(heard.size), null))
+    }
+}
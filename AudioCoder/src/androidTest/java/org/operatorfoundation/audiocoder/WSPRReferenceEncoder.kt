@@ -0,0 +1,164 @@
+package org.operatorfoundation.audiocoder
+
+/**
+ * WSPR encoder for the tests, written from the protocol rather than from
+ * the native code: the Type 1 packing and parity loop follow BD1ES's
+ * wspr_enc.c one bit at a time, Type 2 and 3 packing and the callsign
+ * hash follow WSJT's wsprsim and lookup3.
+ */
+object WSPRReferenceEncoder {
+
+    const val SYMBOL_COUNT = 162
+
+    private const val BASE_FREQUENCY_HZ = 1500.0
+    private const val SYMBOL_SPACING_HZ = 12000.0 / 8192
+
+    private val INTERLEAVE = IntArray(SYMBOL_COUNT).also { table ->
+        var p = 0
+        for (i in 0 until 256) {
+            val j = Integer.reverse(i) ushr 24
+            if (j < SYMBOL_COUNT) table[p++] = j
+        }
+    }
+
+    private val SYNC = intArrayOf(
+        1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1,
+        1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0,
+        1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1, 0, 0, 0, 0, 1, 1, 0, 1, 0,
+        1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0,
+        0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1,
+        0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0,
+        0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0
+    )
+
+    private val POWER_CORRECTION = intArrayOf(0, -1, 1, 0, -1, 2, 1, 0, -1, 1)
+
+    private fun charCode(c: Char): Int = when (c) {
+        in '0'..'9' -> c - '0'
+        in 'A'..'Z' -> c - 'A' + 10
+        else -> 36
+    }
+
+    /**
+     * 28-bit value of a callsign with its digit in position 2 or 3
+     */
+    private fun packCallsign(call: String): Long {
+        val digitPos = if (call.length > 2 && call[2].isDigit()) 2 else 1
+        val suffixLen = call.length - digitPos - 1
+
+        var n = (if (digitPos >= 2) charCode(call[digitPos - 2]) else 36).toLong()
+        n = 36 * n + charCode(call[digitPos - 1])
+        n = 10 * n + charCode(call[digitPos])
+        n = 27 * n + (if (suffixLen >= 1) charCode(call[digitPos + 1]) - 10 else 26)
+        n = 27 * n + (if (suffixLen >= 2) charCode(call[digitPos + 2]) - 10 else 26)
+        n = 27 * n + (if (suffixLen >= 3) charCode(call[digitPos + 3]) - 10 else 26)
+        return n
+    }
+
+    private fun packGridLocator(grid: String): Long =
+        180L * (179 - 10 * (charCode(grid[0]) - 10) - charCode(grid[2])) +
+                10 * (charCode(grid[1]) - 10) + charCode(grid[3])
+
+    /**
+     * Bob Jenkins' lookup3 hashlittle() of an ASCII call of up to 12
+     * characters with initval 146, cut to 15 bits, as WSPR hashes calls
+     */
+    fun nhash(call: String): Int {
+        val k = call.toByteArray(Charsets.US_ASCII)
+        require(k.size in 1..12)
+        fun byte(i: Int) = if (i < k.size) k[i].toInt() and 0xFF else 0
+        fun word(i: Int) = byte(i) or (byte(i + 1) shl 8) or (byte(i + 2) shl 16) or (byte(i + 3) shl 24)
+
+        var a = 0xdeadbeef.toInt() + k.size + 146
+        var b = a
+        var c = a
+        a += word(0)
+        b += word(4)
+        c += word(8)
+
+        c = c xor b; c -= Integer.rotateLeft(b, 14)
+        a = a xor c; a -= Integer.rotateLeft(c, 11)
+        b = b xor a; b -= Integer.rotateLeft(a, 25)
+        c = c xor b; c -= Integer.rotateLeft(b, 16)
+        a = a xor c; a -= Integer.rotateLeft(c, 4)
+        b = b xor a; b -= Integer.rotateLeft(a, 14)
+        c = c xor b; c -= Integer.rotateLeft(b, 24)
+        return c and 32767
+    }
+
+    /**
+     * The 28-bit n1 and 22-bit ng fields: Type 1 for a plain call and
+     * 4-character grid, Type 2 for a call with a '/', Type 3 for a
+     * 6-character grid
+     */
+    private fun packMessage(callsign: String, locator: String, powerDbm: Int): Pair<Long, Long> {
+        val call = callsign.uppercase()
+        val grid = locator.uppercase()
+        val clamped = powerDbm.coerceIn(0, 60)
+        val power = clamped + POWER_CORRECTION[clamped % 10]
+
+        if (grid.length == 6) {
+            // Grid rotated left by one is packed as the call; the call is sent as its hash
+            val n1 = packCallsign(grid.substring(1) + grid[0])
+            return Pair(n1, 128L * nhash(call) - (power + 1) + 64)
+        }
+
+        val slash = call.indexOf('/')
+        if (slash < 0) {
+            return Pair(packCallsign(call), 128L * packGridLocator(grid) + power + 64)
+        }
+
+        val after = call.length - slash - 1
+        val n1: Long
+        var m: Long
+        var nadd = 2
+        if (after > 2) {
+            // Prefix of up to 3 characters, right aligned, base 37
+            n1 = packCallsign(call.substring(slash + 1))
+            m = 0
+            for (k in 3 downTo 1) m = 37 * m + (if (slash >= k) charCode(call[slash - k]) else 36)
+            if (m < 32768) nadd = 1 else m -= 32768
+        } else {
+            // Suffix /A to /Z, /0 to /9, or /10 to /99
+            n1 = packCallsign(call.substring(0, slash))
+            m = if (after == 1) {
+                60000L - 32768 + charCode(call[slash + 1])
+            } else {
+                60000L + 26 + 10 * charCode(call[slash + 1]) + charCode(call[slash + 2])
+            }
+        }
+        return Pair(n1, 128 * m + power + nadd + 64)
+    }
+
+    /**
+     * The 162 channel symbols (values 0-3) of a message
+     */
+    fun encode(callsign: String, locator: String, powerDbm: Int): ByteArray {
+        val (n1, ng) = packMessage(callsign, locator, powerDbm)
+
+        // 28 + 22 message bits, then the 31 zero bits that flush the encoder
+        val bits = IntArray(81)
+        for (i in 0 until 28) bits[i] = ((n1 shr (27 - i)) and 1).toInt()
+        for (i in 0 until 22) bits[28 + i] = ((ng shr (21 - i)) and 1).toInt()
+
+        val symbols = ByteArray(SYMBOL_COUNT)
+        var reg = 0L
+        for (i in bits.indices) {
+            reg = ((reg shl 1) or bits[i].toLong()) and 0xFFFFFFFFL
+            val k0 = INTERLEAVE[2 * i]
+            val k1 = INTERLEAVE[2 * i + 1]
+            symbols[k0] = (SYNC[k0] + 2 * (java.lang.Long.bitCount(reg and 0xF2D05351L) % 2)).toByte()
+            symbols[k1] = (SYNC[k1] + 2 * (java.lang.Long.bitCount(reg and 0xE4613C47L) % 2)).toByte()
+        }
+        return symbols
+    }
+
+    /**
+     * Frequencies in centihertz as WSPREncodeToFrequencies gives them
+     */
+    fun encodeToFrequencies(callsign: String, locator: String, powerDbm: Int, offsetHz: Int, lsb: Boolean): LongArray =
+        encode(callsign, locator, powerDbm).map { symbol ->
+            val tone = if (lsb) 3 - symbol else symbol.toInt()
+            ((BASE_FREQUENCY_HZ + offsetHz + tone * SYMBOL_SPACING_HZ) * 100.0).toLong()
+        }.toLongArray()
+}
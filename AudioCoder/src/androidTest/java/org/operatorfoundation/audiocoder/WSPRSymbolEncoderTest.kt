@@ -0,0 +1,150 @@
+package org.operatorfoundation.audiocoder
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.operatorfoundation.audiocoder.WSPRReferenceEncoder.SYMBOL_COUNT
+
+/**
+ * Checks the native table-driven encoder against the bit-by-bit
+ * WSPRReferenceEncoder across the message space: for Type 1 every power,
+ * every 4-character grid and callsigns of every shape; for Type 2 every
+ * 1- and 2-character prefix and every suffix; for Type 3 every subsquare
+ * and field. Messages WSPR cannot carry must be refused by every encode call.
+ */
+@RunWith(AndroidJUnit4::class)
+class WSPRSymbolEncoderTest {
+
+    @Test
+    fun testEveryPowerMatchesReference() {
+        val powers = (0..60).toList()
+        assertBatchMatchesReference(powers.map { "W1ABC" }, powers.map { "FN20" }, powers)
+    }
+
+    @Test
+    fun testEveryGridMatchesReference() {
+        val grids = ArrayList<String>()
+        for (field1 in 'A'..'R')
+            for (field2 in 'A'..'R')
+                for (square1 in '0'..'9')
+                    for (square2 in '0'..'9')
+                        grids.add("$field1$field2$square1$square2")
+
+        assertEquals(32400, grids.size)
+        assertBatchMatchesReference(grids.map { "K1JT" }, grids, grids.map { 37 })
+    }
+
+    @Test
+    fun testCallsignShapesMatchReference() {
+        val calls = ArrayList<String>()
+        for (prefix in listOf("K", "Q", "W", "0", "9", "AA", "VE", "ZZ", "3D", "9Z"))
+            for (digit in listOf('0', '1', '5', '9'))
+                for (suffix in listOf("", "A", "Z", "AB", "ZZ", "ABC", "XYZ", "ZZZ")) {
+                    val call = "$prefix$digit$suffix"
+                    if (call.length <= 6) calls.add(call)
+                }
+
+        assertBatchMatchesReference(calls, calls.map { "JO22" }, calls.map { 23 })
+    }
+
+    @Test
+    fun testLowerCaseMatchesReference() {
+        val calls = listOf("w1abc", "k1jt", "ve3xyz", "ja1abc")
+        assertBatchMatchesReference(calls, calls.map { "io91" }, calls.map { 30 })
+    }
+
+    @Test
+    fun testType2PrefixesMatchReference() {
+        val symbols = ('A'..'Z') + ('0'..'9')
+        val calls = ArrayList<String>()
+        for (first in symbols) {
+            calls.add("$first/K1ABC")
+            for (second in symbols) calls.add("$first$second/K1ABC")
+        }
+        calls.addAll(listOf("PJ4/K1ABC", "EA8/G4XYZ", "3DA/ZZ9ZZZ", "ZZZ/W1AW", "999/K1JT", "pj4/k1abc"))
+
+        assertBatchMatchesReference(calls, calls.map { "FN42" }, calls.map { 37 })
+    }
+
+    @Test
+    fun testType2SuffixesMatchReference() {
+        val calls = ArrayList<String>()
+        for (suffix in ('A'..'Z') + ('0'..'9')) calls.add("K1ABC/$suffix")
+        for (suffix in 10..99) calls.add("W1AW/$suffix")
+
+        assertBatchMatchesReference(calls, calls.map { "" }, calls.map { 30 })
+    }
+
+    @Test
+    fun testType3MatchesReference() {
+        val calls = ArrayList<String>()
+        val grids = ArrayList<String>()
+        val powers = ArrayList<Int>()
+        fun add(call: String, grid: String, power: Int) {
+            calls.add(call)
+            grids.add(grid)
+            powers.add(power)
+        }
+
+        for (sub1 in 'A'..'X')
+            for (sub2 in 'A'..'X')
+                add("K1ABC", "FN42$sub1$sub2", 37)
+        for (field1 in 'A'..'R')
+            for (field2 in 'A'..'R')
+                add("G4XYZ", "$field1${field2}00LL", 37)
+        for (power in 0..60) add("PJ4/K1ABC", "FN42ab", power)
+        for (call in listOf("ZZ9ZZZ", "K1ABC/P", "K1ABC/12", "3DA/ZZ9ZZZ", "w1aw")) add(call, "io91wm", 30)
+
+        assertBatchMatchesReference(calls, grids, powers)
+    }
+
+    @Test
+    fun testUnsendableMessagesAreRejected() {
+        val invalid = listOf(
+            "0A" to "FN42",          // digit in position 1
+            "W1ABCD" to "FN42",      // 4-letter suffix
+            "W1AB!" to "FN42",       // not a letter or digit
+            "PJ4/" to "FN42",        // nothing after the prefix
+            "/K1ABC" to "",          // empty prefix
+            "ABCD/K1ABC" to "",      // 4-character prefix
+            "K/15" to "",            // two characters after '/' are a suffix, not a call
+            "K1ABC/AB" to "",        // 2-character suffix that is not a number
+            "K1ABC/" to "",          // empty suffix
+            "W1ABC" to "",           // Type 1 needs a locator
+            "W1ABC" to "FN4",        // short locator
+            "W1ABC" to "FN42A",      // 5-character locator
+            "W1ABC" to "SN42",       // field beyond R
+            "W1ABC" to "F442",       // digit for a field
+            "W1ABC" to "FN42YA",     // subsquare beyond X
+            "0A" to "FN42AB"         // Type 3 still needs a call Type 1 or 2 could send
+        )
+
+        for ((call, grid) in invalid) {
+            val message = "$call '$grid'"
+            assertNull(message, CJarInterface.WSPREncodeBatch(arrayOf(call), arrayOf(grid), intArrayOf(30)))
+            assertNull(message, CJarInterface.WSPREncodeToFrequencies(call, grid, 30, 0, false))
+            assertNull(message, CJarInterface.WSPREncodeToPCM(call, grid, 30, 0, false))
+            assertEquals(message, 0L, CJarInterface.WSPRTxOpen(call, grid, 30, 0, false, 12000, 0L))
+            assertFalse(message, CJarInterface.WSPREncodeToTuningWords(call, grid, 30, 14095600.0, 0, 25e6, 0.0, WSPRTuningWords()))
+        }
+
+        // One bad message fails the whole batch
+        assertNull(CJarInterface.WSPREncodeBatch(arrayOf("K1ABC", "W1ABCD"), arrayOf("FN42", "FN42"), intArrayOf(37, 37)))
+    }
+
+    private fun assertBatchMatchesReference(calls: List<String>, locators: List<String>, powers: List<Int>) {
+        val symbols = CJarInterface.WSPREncodeBatch(calls.toTypedArray(), locators.toTypedArray(), powers.toIntArray())
+
+        assertEquals(calls.size * SYMBOL_COUNT, symbols.size)
+        for (i in calls.indices) {
+            val expected = WSPRReferenceEncoder.encode(calls[i], locators[i], powers[i])
+            val actual = symbols.copyOfRange(i * SYMBOL_COUNT, (i + 1) * SYMBOL_COUNT)
+
+            assertArrayEquals("Failed: ${calls[i]} ${locators[i]} ${powers[i]}dBm", expected, actual)
+        }
+    }
+}
@@ -0,0 +1,99 @@
+package org.operatorfoundation.audiocoder
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * The streamed transmission: its length at several sample rates, the
+ * silence before the first symbol, and that the waveform does not depend
+ * on how it is read.
+ */
+@RunWith(AndroidJUnit4::class)
+class WSPRTransmitStreamTest {
+
+    @Test
+    fun testSampleCountAt12kHz() {
+        // 162 symbols of 8192 samples
+        assertEquals(1327104L, readAll(12000, 0L).size.toLong())
+    }
+
+    @Test
+    fun testSampleCountAt48kHz() {
+        assertEquals(4 * 1327104L, readAll(48000, 0L).size.toLong())
+    }
+
+    @Test
+    fun testSampleCountAt44100Hz() {
+        // ceil(162 * 8192 * 44100 / 12000): the last symbol ends on the next whole sample
+        assertEquals(4877108L, readAll(44100, 0L).size.toLong())
+    }
+
+    @Test
+    fun testStartDelayIsSilence() {
+        val delay = 4800L
+        val samples = readAll(48000, delay)
+
+        assertEquals(4 * 1327104L + delay, samples.size.toLong())
+        for (i in 0 until delay.toInt()) assertEquals("Sample $i", 0.toShort(), samples[i])
+        assertArrayEquals(readAll(48000, 0L), samples.copyOfRange(delay.toInt(), samples.size))
+    }
+
+    @Test
+    fun testChunkedReadsMatchOneRead() {
+        val expected = readAll(48000, 1234L)
+        val chunks = intArrayOf(1, 7, 333, 4096, 1001, 8191)
+        val actual = ShortArray(expected.size)
+
+        WSPRTransmitStream.open("K1ABC", "FN42", 37, 48000, 1234L).use { stream ->
+            var position = 0
+            var k = 0
+            while (true) {
+                val count = stream.read(actual, position, minOf(chunks[k++ % chunks.size], actual.size - position))
+                if (count <= 0) break
+                position += count
+            }
+            assertEquals(expected.size, position)
+            assertEquals(0L, stream.remainingSamples)
+        }
+        assertArrayEquals(expected, actual)
+    }
+
+    @Test
+    fun testStreamAt12kHzMatchesPcm() {
+        val pcm = CJarInterface.WSPREncodeToPCM("K1ABC", "FN42", 37, 0, false)
+        val expected = ShortArray(pcm.size / 2)
+        ByteBuffer.wrap(pcm).order(ByteOrder.nativeOrder()).asShortBuffer().get(expected)
+
+        assertArrayEquals(expected, readAll(12000, 0L))
+    }
+
+    @Test
+    fun testReadRejectsBadArguments() {
+        val handle = CJarInterface.WSPRTxOpen("K1ABC", "FN42", 37, 0, false, 12000, 0L)
+        try {
+            assertEquals(-1, CJarInterface.WSPRTxRead(handle, null, 0, 0))
+            assertEquals(-1, CJarInterface.WSPRTxRead(handle, ShortArray(10), 5, 6))
+            assertEquals(-1, CJarInterface.WSPRTxRead(0L, ShortArray(10), 0, 10))
+        } finally {
+            CJarInterface.WSPRTxClose(handle)
+        }
+    }
+
+    private fun readAll(sampleRate: Int, startDelaySamples: Long): ShortArray =
+        WSPRTransmitStream.open("K1ABC", "FN42", 37, sampleRate, startDelaySamples).use { stream ->
+            val samples = ShortArray(stream.remainingSamples.toInt())
+            var position = 0
+            while (position < samples.size) {
+                val count = stream.read(samples, position)
+                if (count <= 0) break
+                position += count
+            }
+            assertEquals(0, stream.read(ShortArray(16)))
+            samples
+        }
+}
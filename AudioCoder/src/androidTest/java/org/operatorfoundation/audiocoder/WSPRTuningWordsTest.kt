@@ -0,0 +1,114 @@
+package org.operatorfoundation.audiocoder
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Si5351 settings for 14.0956 MHz USB (tone 0 at 14 097 100 Hz) from a
+ * 25 MHz reference, checked against the AN619 divider and register
+ * formulas worked by hand.
+ *
+ * The output multisynth divides by 62, the largest even divider keeping
+ * the top tone's VCO under 900 MHz, so tone 0 needs a PLL ratio of
+ * 14097100 * 62 / 25 MHz = 34 + 120101/125000 exactly. The other tones are
+ * the closest fractions with a 20-bit denominator.
+ */
+@RunWith(AndroidJUnit4::class)
+class WSPRTuningWordsTest {
+
+    private val dialHz = 14095600.0
+    private val xtalHz = 25e6
+
+    // a, b, c of each tone's PLL feedback divider
+    private val pll = arrayOf(
+        longArrayOf(34, 120101, 125000),
+        longArrayOf(34, 799255, 831854),
+        longArrayOf(34, 151559, 157740),
+        longArrayOf(34, 680377, 708122)
+    )
+
+    @Test
+    fun testOutputDivider() {
+        val words = tuningWords()
+
+        assertEquals(62, words.multisynthDivider)
+        assertEquals(1, words.rDivider)
+        // P1 = 128 * 62 - 512 = 7424, P2 = 0, P3 = 1
+        assertArrayEquals(bytes(0x00, 0x01, 0x00, 0x1D, 0x00, 0x00, 0x00, 0x00), words.multisynthRegisters)
+    }
+
+    @Test
+    fun testPllParametersFollowAN619() {
+        val words = tuningWords()
+
+        for (k in 0 until WSPRTuningWords.TONE_COUNT) {
+            val (a, b, c) = pll[k].toList()
+            val floor128 = 128 * b / c
+            val registers = words.pllRegisters.copyOfRange(8 * k, 8 * k + 8)
+
+            assertEquals("P1 of tone $k", 128 * a + floor128 - 512, p1(registers))
+            assertEquals("P2 of tone $k", 128 * b - c * floor128, p2(registers))
+            assertEquals("P3 of tone $k", c, p3(registers))
+        }
+    }
+
+    @Test
+    fun testPllRegisterBytes() {
+        val expected = bytes(
+            0xE8, 0x48, 0x00, 0x0F, 0x7A, 0x11, 0xE0, 0x30,
+            0xB1, 0x6E, 0x00, 0x0F, 0x7A, 0xCC, 0x7D, 0x14,
+            0x68, 0x2C, 0x00, 0x0F, 0x7A, 0x22, 0x5E, 0x88,
+            0xCE, 0x1A, 0x00, 0x0F, 0x7A, 0xAA, 0xA4, 0x1C
+        )
+
+        assertArrayEquals(expected, tuningWords().pllRegisters)
+    }
+
+    @Test
+    fun testToneFrequencies() {
+        val words = tuningWords()
+
+        for (k in 0 until WSPRTuningWords.TONE_COUNT) {
+            val expected = dialHz + 1500.0 + k * 12000.0 / 8192
+            assertEquals("Tone $k", expected, words.toneFrequencies[k], 1e-3)
+        }
+    }
+
+    @Test
+    fun testTonesAreTheChannelSymbols() {
+        val words = tuningWords()
+        val symbols = CJarInterface.WSPREncodeBatch(arrayOf("K1ABC"), arrayOf("FN42"), intArrayOf(37))
+
+        assertArrayEquals(symbols, words.tones)
+    }
+
+    @Test
+    fun testUnreachableFrequency() {
+        val words = WSPRTuningWords()
+
+        assertFalse(CJarInterface.WSPREncodeToTuningWords("K1ABC", "FN42", 37, 0.0, 0, xtalHz, 0.0, words))
+        assertFalse(CJarInterface.WSPREncodeToTuningWords("K1ABC", "FN42", 37, 500e6, 0, xtalHz, 0.0, words))
+    }
+
+    private fun tuningWords(): WSPRTuningWords {
+        val words = WSPRTuningWords()
+        assertTrue(CJarInterface.WSPREncodeToTuningWords("K1ABC", "FN42", 37, dialHz, 0, xtalHz, 0.0, words))
+        return words
+    }
+
+    private fun bytes(vararg values: Int) = ByteArray(values.size) { values[it].toByte() }
+
+    private fun u(registers: ByteArray, i: Int) = registers[i].toLong() and 0xFF
+
+    // Parameter block layout of AN619: P3[15:0], P1[17:0], P3[19:16] | P2[19:16], P2[15:0]
+    private fun p1(r: ByteArray) = ((u(r, 2) and 0x03) shl 16) or (u(r, 3) shl 8) or u(r, 4)
+
+    private fun p2(r: ByteArray) = ((u(r, 5) and 0x0F) shl 16) or (u(r, 6) shl 8) or u(r, 7)
+
+    private fun p3(r: ByteArray) = ((u(r, 5) and 0xF0) shl 12) or (u(r, 0) shl 8) or u(r, 1)
+}
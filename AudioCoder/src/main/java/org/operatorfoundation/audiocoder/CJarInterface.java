@@ -8,24 +8,190 @@ public class CJarInterface {
 
     /**
      * Encodes WSPR messages into frequency data for direct radio hardware control.
+     * The encode calls return null (0 or false for the generator and tuning
+     * words) for a message WSPR cannot carry: a callsign of another shape, a
+     * Type 1 message without a 4-character locator, or a locator outside
+     * AA00-RR99 (AA00aa-RR99xx for 6 characters). {@link WSPREncoder} says
+     * which part is wrong.
      *
      * @param callsign Amateur radio callsign
      * @param locator Maidenhead grid square locator
      * @param power Power level in dBm (0-60)
      * @param offset Frequency offset in Hz (added to 1500 Hz base)
      * @param lsb LSB mode - inverts symbol order if true
-     * @return long array containing 162 frequencies (Hz * 100 for 0.01 Hz precision)
+     * @return long array containing 162 frequencies (Hz * 100 for 0.01 Hz precision),
+     *         or null if the message cannot be sent
      */
     public static native long[] WSPREncodeToFrequencies(String callsign, String locator, int power, int offset, boolean lsb);
 
+    /** 12 kHz 16-bit audio of a message, or null if it cannot be sent. */
     public static native byte[] WSPREncodeToPCM(String callsign, String locator, int power, int offset, boolean lsb);
 
+    /**
+     * Encodes many messages at once into their channel symbols, for a beacon
+     * that rotates through a set of messages (Type 2 and Type 3 halves
+     * included). Recently encoded messages come from a cache instead of
+     * being encoded again; the encode calls above share it.
+     *
+     * @param powers Power level of each message in dBm (0-60)
+     * @return 162 symbols (values 0-3) per message, message i at byte 162 * i,
+     *         or null if the arrays differ in length or hold a null entry or a
+     *         message that cannot be sent
+     */
+    public static native byte[] WSPREncodeBatch(String[] callsigns, String[] locators, int[] powers);
+
+    /**
+     * Frequencies of message index of symbols from {@link #WSPREncodeBatch},
+     * as {@link #WSPREncodeToFrequencies} returns them.
+     *
+     * @return null if symbols has no message index
+     */
+    public static native long[] WSPRSymbolsToFrequencies(byte[] symbols, int index, int offset, boolean lsb);
+
+    /**
+     * Encodes a WSPR message into Si5351 register values for transmitters
+     * that key the synthesizer directly: one output divider setting, four PLL
+     * settings and the tone of each symbol, in place of 162 frequencies.
+     *
+     * @param dialHz USB dial frequency; tone 0 is at dialHz + 1500 + offset
+     * @param xtalHz Synthesizer reference frequency, typically 25 or 27 MHz
+     * @param correctionPpb Measured reference error in parts per billion, positive if fast
+     * @param words Overwritten with the register values
+     * @return false if the message cannot be sent or the synthesizer cannot reach the frequency
+     */
+    public static native boolean WSPREncodeToTuningWords(String callsign, String locator, int power, double dialHz, int offset, double xtalHz, double correctionPpb, WSPRTuningWords words);
+
+    /**
+     * Register values like {@link #WSPREncodeToTuningWords} for message index
+     * of symbols from {@link #WSPREncodeBatch}.
+     *
+     * @return false if symbols has no message index or the synthesizer cannot reach the frequency
+     */
+    public static native boolean WSPRSymbolsToTuningWords(byte[] symbols, int index, double dialHz, int offset, double xtalHz, double correctionPpb, WSPRTuningWords words);
+
+    /**
+     * Audio of message index of symbols from {@link #WSPREncodeBatch},
+     * as {@link #WSPREncodeToPCM} returns it.
+     *
+     * @return null if symbols has no message index
+     */
+    public static native byte[] WSPRSymbolsToPCM(byte[] symbols, int index, int offset, boolean lsb);
+
+    /** Symbol cache hits and misses since the library was loaded, as {hits, misses}. */
+    public static native long[] WSPRGetSymbolCacheCounts();
+
+    /**
+     * Opens a generator of the audio of a WSPR transmission, which
+     * {@link #WSPRTxRead} hands out a block at a time at any sample rate;
+     * free it with {@link #WSPRTxClose}. Tones and levels are those of
+     * {@link #WSPREncodeToPCM}.
+     *
+     * @param sampleRate Output sample rate in Hz
+     * @param startDelaySamples Silence before the first symbol; if negative, the audio starts that many samples into the transmission
+     * @return Generator handle, or 0 if the message cannot be sent or it could not be created
+     */
+    public static native long WSPRTxOpen(String callsign, String locator, int power, int offset, boolean lsb, int sampleRate, long startDelaySamples);
+
+    /**
+     * Opens a generator like {@link #WSPRTxOpen} for message index of
+     * symbols from {@link #WSPREncodeBatch}.
+     *
+     * @return Generator handle, or 0 if symbols has no message index or it could not be created
+     */
+    public static native long WSPRTxOpenSymbols(byte[] symbols, int index, int offset, boolean lsb, int sampleRate, long startDelaySamples);
+
+    /**
+     * Writes the next samples of a transmission into buffer.
+     *
+     * @return Number of samples written, at most count; 0 once the transmission is over, -1 for a bad handle or range
+     */
+    public static native int WSPRTxRead(long handle, short[] buffer, int offset, int count);
+
+    /** Samples {@link #WSPRTxRead} will still produce, including the silence before the start. */
+    public static native long WSPRTxRemaining(long handle);
+
+    public static native void WSPRTxClose(long handle);
+
     public static native WSPRMessage[] WSPRDecodeFromPcm(byte[] sound, double dialfreq, boolean lsb);
 
+    /**
+     * Decodes WSPR messages like {@link #WSPRDecodeFromPcm}, with decoder tuning options.
+     *
+     * @param options Decoder options, or null for the defaults
+     */
+    public static native WSPRMessage[] WSPRDecodeFromPcmWithOptions(byte[] sound, double dialfreq, boolean lsb, WSPRDecoderOptions options);
+
+    /**
+     * Decodes WSPR messages like {@link #WSPRDecodeFromPcmWithOptions} and
+     * reports where the decode spent its time and memory.
+     *
+     * @param options Decoder options, or null for the defaults
+     * @param stats Overwritten with the statistics of this decode
+     */
+    public static native WSPRMessage[] WSPRDecodeFromPcmWithStats(byte[] sound, double dialfreq, boolean lsb, WSPRDecoderOptions options, WSPRDecodeStats stats);
+
+    /**
+     * Keeps the callsigns behind WSPR's hashed calls in a file, so Type 3
+     * messages decode as "&lt;CALL&gt; GRID6 POWER" once the call has been heard,
+     * across decodes and app restarts. It may be changed while decodes run:
+     * they finish with the store they started with.
+     *
+     * @param path Store file in app storage (created if missing), or null to stop using one
+     * @return false if the file could not be opened; the previous store stays in use
+     */
+    public static native boolean WSPRSetCallsignStore(String path);
+
+    /**
+     * Records a span timeline (passes, candidates, sync searches, Fano
+     * attempts, subtractions) of every following decode and writes it to
+     * path as Chrome trace JSON, replacing the previous decode's. Open it in
+     * ui.perfetto.dev or chrome://tracing. A decode that starts while
+     * another is being traced is not traced.
+     *
+     * @param path Trace file in app storage, or null to stop tracing
+     * @return false if the trace buffer could not be allocated
+     */
+    public static native boolean WSPRSetDecodeTrace(String path);
+
     public static native int WSPRNhash(String call);
 
+    /**
+     * Hashes many callsigns in one call, as {@link #WSPRNhash} does one.
+     *
+     * @return hash of each call, or -1 for a null, empty or over-long entry
+     */
+    public static native int[] WSPRNhashBatch(String[] calls);
+
+    /**
+     * Seeds the callsign store opened by {@link #WSPRSetCallsignStore} with
+     * known calls, so their hashed (Type 3) messages resolve before they
+     * are heard as Type 1. Calls already heard keep their hash slot; calls
+     * longer than 10 characters, which WSPR cannot send, are skipped.
+     *
+     * @return number of calls added, or -1 if no store is open
+     */
+    public static native int WSPRPreloadCallsigns(String[] calls);
+
     public static native double WSPRGetDistanceBetweenLocators(String a, String b);
 
+    /**
+     * Great-circle distance and bearing for many pairs of locators at once,
+     * from[i] to to[i], without allocating. Locators are 2 to 10 characters,
+     * taken at the centre of their square.
+     *
+     * @param km Overwritten with the distance of each path in km
+     * @param azimuth Overwritten with the bearing of each path at its start, degrees east of north; null to skip
+     * @return number of paths, or -1 if from and to differ in length or an output array is too short.
+     *         A path with a null or malformed locator is NaN.
+     */
+    public static native int WSPRGetLocatorPaths(String[] from, String[] to, double[] km, double[] azimuth);
+
+    /**
+     * Paths like {@link #WSPRGetLocatorPaths} from one origin, such as our
+     * own station, to each of to.
+     */
+    public static native int WSPRGetLocatorPathsFrom(String origin, String[] to, double[] km, double[] azimuth);
+
     public static native String WSPRLatLonToGSQ(double lat, double lon);
 
     public static native int radioCheck(int testvar);
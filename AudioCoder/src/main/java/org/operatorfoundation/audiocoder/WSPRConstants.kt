@@ -30,6 +30,9 @@ object WSPRTimingConstants
     /** WSPR transmission duration: approximately 110.g seconds */
     const val WSPR_TRANSMISSION_DURATION_SECONDS = 111L
 
+    /** Transmissions start one second after the even minute */
+    const val WSPR_TRANSMISSION_START_OFFSET_MILLISECONDS = 1000L
+
     /** Native decoder audio collection requirement: exactly 114 seconds */
     const val AUDIO_COLLECTION_DURATION_SECONDS = 114L
     const val AUDIO_COLLECTION_DURATION_MILLISECONDS = AUDIO_COLLECTION_DURATION_SECONDS * 1000L
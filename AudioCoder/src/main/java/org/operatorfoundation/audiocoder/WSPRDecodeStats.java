@@ -0,0 +1,50 @@
+package org.operatorfoundation.audiocoder;
+
+/**
+ * Where one native WSPR decode spent its time and memory, filled in by
+ * {@link CJarInterface#WSPRDecodeFromPcmWithStats}.
+ *
+ * CPU time is that of the decoding thread plus, in the decode stage, that
+ * of the {@link WSPRDecoderOptions#decodeThreads} workers. Fields are
+ * written by name from native code, so keep them in sync with
+ * write_decode_stats() in libloud.cpp.
+ */
+public class WSPRDecodeStats
+{
+    /** Indices into {@link #stageWallMillis} and {@link #stageCpuMillis}, in decode order. */
+    public static final int STAGE_READ_WAV = 0;     // PCM to 375 Hz baseband
+    public static final int STAGE_SPECTRUM = 1;     // spectrogram and spectral peaks
+    public static final int STAGE_CANDIDATES = 2;   // coarse time/frequency/drift search
+    public static final int STAGE_SYNC0 = 3;        // lag searches
+    public static final int STAGE_SYNC1 = 4;        // frequency and drift refinement
+    public static final int STAGE_SYNC2 = 5;        // symbol correlation
+    public static final int STAGE_DECODE = 6;       // demodulation, Fano/Jelinek and OSD
+    public static final int STAGE_SUBTRACT = 7;     // subtraction of decoded signals
+    public static final int STAGE_COUNT = 8;
+
+    public double[] stageWallMillis = new double[STAGE_COUNT];
+    public double[] stageCpuMillis = new double[STAGE_COUNT];
+    public double totalWallMillis;
+    public double totalCpuMillis;
+
+    /** Spectral peaks tried in each pass; the length is the number of passes run. */
+    public int[] candidatesPerPass = new int[0];
+
+    /** Messages decoded in each pass. */
+    public int[] decodesPerPass = new int[0];
+
+    /** Fano (or Jelinek) runs, and those that ran out of cycles. */
+    public long decoderAttempts;
+    public long decoderTimeouts;
+    public long decoderCycles;
+
+    /** Ordered-statistics fallbacks tried, and those that decoded. */
+    public long osdAttempts;
+    public long osdDecodes;
+
+    /** Decoded signals subtracted from the audio for later passes. */
+    public int subtractions;
+
+    /** Largest native working set during the decode, excluding the PCM input. */
+    public long peakScratchBytes;
+}
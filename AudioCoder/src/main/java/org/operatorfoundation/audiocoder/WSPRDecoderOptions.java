@@ -0,0 +1,67 @@
+package org.operatorfoundation.audiocoder;
+
+/**
+ * Tuning options for the native WSPR decoder.
+ *
+ * A default-constructed instance decodes exactly like
+ * {@link CJarInterface#WSPRDecodeFromPcm(byte[], double, boolean)}.
+ * Fields are read by name from native code, so keep them in sync with
+ * read_decoder_options() in libloud.cpp.
+ */
+public class WSPRDecoderOptions
+{
+    /**
+     * Adds a final pass that also demodulates 6- and 9-symbol blocks.
+     * Slower; finds a few more weak signals on stable channels.
+     */
+    public boolean deepSearch = false;
+
+    /**
+     * Upper bound on decoding passes. Passes beyond the first two (three
+     * with {@link #deepSearch}) run on the residual audio only while the
+     * previous pass found a new message. Capped at 8 natively.
+     */
+    public int maxPasses = 2;
+
+    /**
+     * Wall-clock budget in milliseconds after which no further pass or
+     * candidate is started; 0 means no limit. The first pass always completes.
+     */
+    public int deadlineMillis = 0;
+
+    /**
+     * Depth (0-5) of the ordered-statistics decoder tried on candidates the
+     * Fano decoder gives up on; -1 disables it. OSD results are only accepted
+     * for standard messages from callsigns the decoder has already seen.
+     */
+    public int osdDepth = -1;
+
+    /**
+     * Uses the Jelinek stack-bucket decoder instead of Fano. It keeps a
+     * ~4.8 MB stack for the whole decode and trades memory for fewer
+     * timeouts on weak signals; worth comparing per band.
+     */
+    public boolean stackDecoder = false;
+
+    /**
+     * Threads, including the calling one, used to try each candidate's
+     * time-jitter and block-size hypotheses speculatively. Decodes are the
+     * same for any value; more threads lower the latency of hard signals.
+     * Capped at 8 natively; 1 decodes sequentially.
+     */
+    public int decodeThreads = 1;
+
+    /**
+     * Give decoder attempts on poor-quality soft symbols a smaller cycle
+     * budget instead of the full 10000 cycles per bit. Saves most of the
+     * time spent on candidates that time out; strong signals are unaffected.
+     */
+    public boolean adaptiveCycles = false;
+
+    /**
+     * Fano metric bias. Lower values dig deeper for weak signals at more
+     * CPU and more false decodes. The table for each value is built once
+     * per process, so changing it costs nothing per decode.
+     */
+    public float metricBias = 0.45f;
+}
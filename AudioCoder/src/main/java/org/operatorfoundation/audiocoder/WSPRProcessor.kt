@@ -42,6 +42,13 @@ class WSPRProcessor
 
     val audioBuffer = mutableListOf<Short>()
 
+    /**
+     * Native decoder statistics from the last [decodeBufferedWSPR] call,
+     * one entry per decode window that reached the decoder.
+     */
+    var lastDecodeStatistics: List<WSPRDecodeStats> = emptyList()
+        private set
+
     /**
      * Adds audio samples to the WSPR processing buffer.
      * Automatically manages buffer size to prevent memory issues.
@@ -83,12 +90,14 @@ class WSPRProcessor
      * @param dialFrequencyMHz Radio dial frequency in MHz
      * @param useLowerSideband Whether to use LSB mode (inverts symbol order)
      * @param useTimeAlignment Use time-aligned windows (true) or sliding windows (false)
+     * @param decoderOptions Native decoder tuning options, or null for the defaults
      * @return Array of decoded WSPR messages, or null if insufficient data
      */
     fun decodeBufferedWSPR(
         dialFrequencyMHz: Double = getDefaultFrequency(),
         useLowerSideband: Boolean = false,
-        useTimeAlignment: Boolean = false
+        useTimeAlignment: Boolean = false,
+        decoderOptions: WSPRDecoderOptions? = null
     ): Array<WSPRMessage>?
     {
         if (!isReadyForDecode()) return null
@@ -102,7 +111,7 @@ class WSPRProcessor
             generateSlidingWindows()
         }
 
-        return processDecodeWindows(decodeWindows, dialFrequencyMHz, useLowerSideband)
+        return processDecodeWindows(decodeWindows, dialFrequencyMHz, useLowerSideband, decoderOptions)
     }
 
     /**
@@ -207,10 +216,12 @@ class WSPRProcessor
     private fun processDecodeWindows(
         windows: List<DecodeWindow>,
         dialFrequencyMHz: Double,
-        useLowerSideband: Boolean
+        useLowerSideband: Boolean,
+        decoderOptions: WSPRDecoderOptions?
     ): Array<WSPRMessage>?
     {
         val allMessages = mutableListOf<WSPRMessage>()
+        val allStatistics = mutableListOf<WSPRDecodeStats>()
 
         Timber.d("=== Starting decode with ${windows.size} windows ===")
         Timber.d("Buffer has ${audioBuffer.size} samples (${getBufferDurationSeconds()}s)")
@@ -233,9 +244,13 @@ class WSPRProcessor
                 val audioQuality = analyzeAudioQuality(windowSamples)
                 Timber.d("  Audio quality: $audioQuality")
 
-                val messages = CJarInterface.WSPRDecodeFromPcm(audioBytes, dialFrequencyMHz, useLowerSideband)
+                // Null options decode with the defaults, as WSPRDecodeFromPcm does
+                val statistics = WSPRDecodeStats()
+                val messages = CJarInterface.WSPRDecodeFromPcmWithStats(audioBytes, dialFrequencyMHz, useLowerSideband, decoderOptions, statistics)
+                allStatistics.add(statistics)
 
                 Timber.d("Native decoder returned: ${messages?.size ?: "null"} messages")
+                Timber.d("  Decode took ${statistics.totalWallMillis.toInt()}ms (${statistics.totalCpuMillis.toInt()}ms CPU), ${statistics.peakScratchBytes / 1024}KB scratch")
 
                 messages?.let {
                     allMessages.addAll(it.toList())
@@ -250,6 +265,8 @@ class WSPRProcessor
 
         Timber.d("=== Decode complete: ${allMessages.size} total messages ===")
 
+        lastDecodeStatistics = allStatistics
+
         return if (allMessages.isNotEmpty())
         {
             removeDuplicateMessages(allMessages).toTypedArray()
@@ -84,6 +84,14 @@ class WSPRStation(
     private val _decodeResults = MutableStateFlow<List<WSPRDecodeResult>>(emptyList())
     val decodeResults: StateFlow<List<WSPRDecodeResult>> = _decodeResults.asStateFlow()
 
+    /**
+     * Native decoder statistics of the most recent decode cycle, one entry
+     * per decode window: time and CPU per decoder stage, candidates, Fano
+     * work and peak memory. Intended for field telemetry of decode cost.
+     */
+    private val _decodeStatistics = MutableStateFlow<List<WSPRDecodeStats>>(emptyList())
+    val decodeStatistics: StateFlow<List<WSPRDecodeStats>> = _decodeStatistics.asStateFlow()
+
     /**
      * Real-time WSPR cycle information for UI display.
      * Updates every second with current position in the 2-minute WSPR cycle.
@@ -126,6 +134,14 @@ class WSPRStation(
                 return  audioInitializationResult
             }
 
+            // Hashed calls resolve from callsigns heard in earlier cycles
+            configuration.callsignStorePath?.let { path ->
+                if (!CJarInterface.WSPRSetCallsignStore(path))
+                {
+                    Timber.w("Could not open callsign store at $path")
+                }
+            }
+
             // Start the main station operation loop
             stationOperationJob = CoroutineScope(Dispatchers.IO + SupervisorJob()).launch {
                 executeStationOperationLoop()
@@ -338,10 +354,12 @@ class WSPRStation(
         val nativeDecodeResults = signalProcessor.decodeBufferedWSPR(
             dialFrequencyMHz = configuration.operatingFrequencyMHz,
             useLowerSideband = configuration.useLowerSidebandMode,
-            useTimeAlignment = configuration.useTimeAlignedDecoding
+            useTimeAlignment = configuration.useTimeAlignedDecoding,
+            decoderOptions = configuration.decoderOptions
         )
 
         Timber.d("Native decode returned: ${nativeDecodeResults?.size ?: "null"}")
+        _decodeStatistics.value = signalProcessor.lastDecodeStatistics
 
         // Phase 4: Convert and store results
         val processedResults = convertNativeResultsToApplicationFormat(nativeDecodeResults)
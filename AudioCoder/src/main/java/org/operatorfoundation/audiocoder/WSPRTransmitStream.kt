@@ -0,0 +1,129 @@
+package org.operatorfoundation.audiocoder
+
+import org.operatorfoundation.audiocoder.WSPRTimingConstants.WSPR_CYCLE_DURATION_SECONDS
+import org.operatorfoundation.audiocoder.WSPRTimingConstants.WSPR_TRANSMISSION_START_OFFSET_MILLISECONDS
+
+/**
+ * Audio of a WSPR transmission generated while it plays, a buffer at a time.
+ *
+ * The native generator works at the output device's sample rate, so no
+ * resampling is needed, and holds only its oscillator state: memory stays
+ * flat however long the transmission. Symbol boundaries are placed on the
+ * exact sample at any rate, so the symbol clock does not drift.
+ *
+ * Example Usage:
+ * WSPRTransmitStream.forNextTransmission("K1ABC", "FN42", 37, sampleRate = 48000, outputLatencyMillis = 40).use { stream ->
+ *     val buffer = ShortArray(4800)
+ *     while (true)
+ *     {
+ *         val count = stream.read(buffer)
+ *         if (count <= 0) break
+ *         audioTrack.write(buffer, 0, count)
+ *     }
+ * }
+ */
+class WSPRTransmitStream private constructor(private var handle: Long, val sampleRate: Int) : AutoCloseable
+{
+    companion object
+    {
+        /**
+         * Opens a stream whose first symbol comes after startDelaySamples of silence.
+         *
+         * @param startDelaySamples Silence before the first symbol; if negative, the stream joins the transmission that far in
+         * @throws IllegalStateException if the message cannot be sent or the native generator could not be created
+         */
+        fun open(
+            callsign: String,
+            locator: String,
+            powerDbm: Int,
+            sampleRate: Int,
+            startDelaySamples: Long = 0L,
+            offsetHz: Int = 0,
+            lsbMode: Boolean = false
+        ): WSPRTransmitStream
+        {
+            require(sampleRate > 0) { "Sample rate must be positive" }
+
+            val handle = CJarInterface.WSPRTxOpen(callsign, locator, powerDbm, offsetHz, lsbMode, sampleRate, startDelaySamples)
+            check(handle != 0L) { "Could not create the WSPR transmit generator" }
+            return WSPRTransmitStream(handle, sampleRate)
+        }
+
+        /**
+         * Opens a stream like [open] for message index of symbols from
+         * [CJarInterface.WSPREncodeBatch], without encoding it again.
+         *
+         * @throws IllegalStateException if symbols has no message index
+         */
+        fun openSymbols(
+            symbols: ByteArray,
+            index: Int,
+            sampleRate: Int,
+            startDelaySamples: Long = 0L,
+            offsetHz: Int = 0,
+            lsbMode: Boolean = false
+        ): WSPRTransmitStream
+        {
+            require(sampleRate > 0) { "Sample rate must be positive" }
+
+            val handle = CJarInterface.WSPRTxOpenSymbols(symbols, index, offsetHz, lsbMode, sampleRate, startDelaySamples)
+            check(handle != 0L) { "Could not create the WSPR transmit generator for message $index" }
+            return WSPRTransmitStream(handle, sampleRate)
+        }
+
+        /**
+         * Opens a stream timed so its first symbol reaches the air one second
+         * after the coming even minute, as the WSPR schedule requires.
+         *
+         * Playback should begin as soon as this returns: the silence before the
+         * first symbol is counted from now. During the first second of an even
+         * minute the current cycle's transmission is still ahead and is the one used.
+         *
+         * @param outputLatencyMillis Time from writing a sample to it being played
+         */
+        fun forNextTransmission(
+            callsign: String,
+            locator: String,
+            powerDbm: Int,
+            sampleRate: Int,
+            outputLatencyMillis: Long = 0L,
+            offsetHz: Int = 0,
+            lsbMode: Boolean = false,
+            timingCoordinator: WSPRTimingCoordinator = WSPRTimingCoordinator()
+        ): WSPRTransmitStream
+        {
+            val cycleMillis = WSPR_CYCLE_DURATION_SECONDS * 1000L
+            var delayMillis = timingCoordinator.getMillisUntilNextEvenMinute() +
+                WSPR_TRANSMISSION_START_OFFSET_MILLISECONDS - outputLatencyMillis
+            if (delayMillis >= cycleMillis) delayMillis -= cycleMillis
+
+            return open(callsign, locator, powerDbm, sampleRate, delayMillis * sampleRate / 1000L, offsetHz, lsbMode)
+        }
+    }
+
+    /** Samples still to come, including the silence before the first symbol */
+    val remainingSamples: Long
+        get() = if (handle == 0L) 0L else CJarInterface.WSPRTxRemaining(handle)
+
+    /**
+     * Writes the next samples into buffer.
+     *
+     * @return Number of samples written, 0 once the transmission is over
+     */
+    fun read(buffer: ShortArray, offset: Int = 0, count: Int = buffer.size - offset): Int
+    {
+        check(handle != 0L) { "Stream is closed" }
+        require(offset >= 0 && count >= 0 && count <= buffer.size - offset) { "Range outside the buffer" }
+
+        return CJarInterface.WSPRTxRead(handle, buffer, offset, count)
+    }
+
+    override fun close()
+    {
+        if (handle != 0L)
+        {
+            CJarInterface.WSPRTxClose(handle)
+            handle = 0L
+        }
+    }
+}
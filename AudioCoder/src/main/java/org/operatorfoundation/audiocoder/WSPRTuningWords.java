@@ -0,0 +1,35 @@
+package org.operatorfoundation.audiocoder;
+
+/**
+ * Si5351 register values for a WSPR transmission made directly by the
+ * synthesizer, filled in by {@link CJarInterface#WSPREncodeToTuningWords}.
+ *
+ * Write {@link #multisynthRegisters} to the output multisynth once, then
+ * for each symbol write the PLL register set of its tone, from
+ * {@link #tones}, every 8192/12000 s. Register layouts follow Silicon Labs
+ * AN619. Fields are written by name from native code, so keep them in sync
+ * with write_tuning_words() in libloud.cpp.
+ */
+public class WSPRTuningWords
+{
+    public static final int TONE_COUNT = 4;
+    public static final int REGISTERS_PER_SET = 8;
+
+    /** Output multisynth divider, an even integer; 4 uses the divide-by-4 mode. */
+    public int multisynthDivider;
+
+    /** Output R divider, a power of two from 1 to 128. */
+    public int rDivider;
+
+    /** MS0 parameters for registers 42-49, with R0_DIV and MS0_DIVBY4 set. */
+    public byte[] multisynthRegisters = new byte[REGISTERS_PER_SET];
+
+    /** PLL A parameters for registers 26-33 (PLL B: 34-41), tone k at byte 8 * k. */
+    public byte[] pllRegisters = new byte[TONE_COUNT * REGISTERS_PER_SET];
+
+    /** Frequency of each tone with these settings, in Hz, after the reference correction. */
+    public double[] toneFrequencies = new double[TONE_COUNT];
+
+    /** Tone of each of the 162 symbols, 0-3. */
+    public byte[] tones = new byte[162];
+}
@@ -1,6 +1,7 @@
 package org.operatorfoundation.audiocoder.models
 
 import org.operatorfoundation.audiocoder.WSPRBandplan
+import org.operatorfoundation.audiocoder.WSPRDecoderOptions
 
 /**
  * Configuration parameters for WSPR station operation.
@@ -20,7 +21,17 @@ data class WSPRStationConfiguration(
     val stationCallsign: String?,
 
     /** Station Maidenhead grid square location (optional) */
-    val stationGridSquare: String?
+    val stationGridSquare: String?,
+
+    /** Native decoder tuning options (null uses the decoder defaults) */
+    val decoderOptions: WSPRDecoderOptions? = null,
+
+    /**
+     * File in app storage that remembers callsigns for resolving hashed
+     * (Type 3) calls across decode cycles and restarts, e.g.
+     * File(context.filesDir, "wspr_callsigns.bin").path. Null disables it.
+     */
+    val callsignStorePath: String? = null
 )
 {
     companion object
@@ -0,0 +1,142 @@
+/*
+ * wcache.c
+ *
+ * Symbol cache of wcache.h. Entries are found through a chained hash
+ * table of key hashes; the least recently used one is found by a scan of
+ * use stamps, which only happens on a miss, next to a full encode.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "wenc.h"
+#include "wcache.h"
+
+#define WCACHE_SYMBOLS 162
+#define WCACHE_NONE (-1)
+
+struct wcache_entry {
+    char key[WCACHE_KEY_LENGTH];
+    uint32_t hash;
+    uint8_t symbols[WCACHE_SYMBOLS];
+    uint8_t type;
+    unsigned long used;         // stamp of the last lookup, 0 if empty
+    int next;                   // next entry in the same bucket
+};
+
+struct wcache {
+    struct wcache_entry *entries;
+    int *buckets;               // first entry of each bucket
+    int capacity, nbuckets;     // nbuckets is a power of two
+    unsigned long clock, hits, misses;
+};
+
+// FNV-1a
+static uint32_t wcache_hash(const char *key) {
+    uint32_t h = 2166136261u;
+
+    for (; *key; key++) {
+        h = (h ^ (uint8_t) *key) * 16777619u;
+    }
+    return h;
+}
+
+// "call grid dBm" into key; its length, or -1 if it does not fit
+static int wcache_key(char *key, const char *call, const char *grid, const char *dBm) {
+    const char *parts[3] = {call, grid, dBm};
+    int len = 0, i;
+
+    for (i = 0; i < 3; i++) {
+        const char *c = parts[i];
+        if (i > 0) key[len++] = ' ';
+        for (; *c; c++) {
+            if (len == WCACHE_KEY_LENGTH - 1) return -1;
+            key[len++] = *c;
+        }
+        if (len == WCACHE_KEY_LENGTH - 1) return -1;
+    }
+    key[len] = '\0';
+    return len;
+}
+
+struct wcache *wcache_alloc(int capacity) {
+    struct wcache *cache = calloc(1, sizeof(struct wcache));
+    int i;
+
+    if (cache == NULL) return NULL;
+    cache->capacity = capacity;
+    for (cache->nbuckets = 1; cache->nbuckets < capacity; cache->nbuckets <<= 1);
+    cache->entries = calloc(capacity, sizeof(struct wcache_entry));
+    cache->buckets = malloc(sizeof(int) * cache->nbuckets);
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        wcache_free(cache);
+        return NULL;
+    }
+    for (i = 0; i < cache->nbuckets; i++) cache->buckets[i] = WCACHE_NONE;
+    return cache;
+}
+
+void wcache_free(struct wcache *cache) {
+    if (cache == NULL) return;
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
+
+static void wcache_unlink(struct wcache *cache, int e) {
+    int *link = &cache->buckets[cache->entries[e].hash & (cache->nbuckets - 1)];
+
+    while (*link != e) link = &cache->entries[*link].next;
+    *link = cache->entries[e].next;
+}
+
+uint8_t wcache_symbols(struct wcache *cache, const char *call, const char *grid, const char *dBm,
+                       uint8_t *symbols) {
+    char key[WCACHE_KEY_LENGTH];
+    struct wcache_entry *entry;
+    uint32_t hash;
+    int e, i, len;
+    uint8_t type;
+
+    len = wcache_key(key, call, grid, dBm);
+    if (len < 0) {
+        cache->misses++;
+        return wspr_enc(call, grid, dBm, symbols);
+    }
+    hash = wcache_hash(key);
+
+    for (e = cache->buckets[hash & (cache->nbuckets - 1)]; e != WCACHE_NONE; e = entry->next) {
+        entry = &cache->entries[e];
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            entry->used = ++cache->clock;
+            cache->hits++;
+            memcpy(symbols, entry->symbols, WCACHE_SYMBOLS);
+            return entry->type;
+        }
+    }
+
+    cache->misses++;
+    type = wspr_enc(call, grid, dBm, symbols);
+    if (type == 0) return 0;
+
+    // An empty entry, or else the least recently used
+    e = 0;
+    for (i = 0; i < cache->capacity && cache->entries[e].used != 0; i++) {
+        if (cache->entries[i].used < cache->entries[e].used) e = i;
+    }
+    entry = &cache->entries[e];
+    if (entry->used != 0) wcache_unlink(cache, e);
+
+    entry->type = type;
+    memcpy(entry->symbols, symbols, WCACHE_SYMBOLS);
+    memcpy(entry->key, key, len + 1);
+    entry->hash = hash;
+    entry->used = ++cache->clock;
+    entry->next = cache->buckets[hash & (cache->nbuckets - 1)];
+    cache->buckets[hash & (cache->nbuckets - 1)] = e;
+    return type;
+}
+
+void wcache_counts(const struct wcache *cache, unsigned long *hits, unsigned long *misses) {
+    *hits = cache->hits;
+    *misses = cache->misses;
+}
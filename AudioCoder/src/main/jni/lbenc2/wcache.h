@@ -0,0 +1,45 @@
+#ifndef WSPR_CACHE_H
+#define WSPR_CACHE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Least-recently-used cache of WSPR channel symbols, keyed by message.
+ *
+ * A beacon rotating through a fixed set of callsign/grid/power messages
+ * (including the Type 2 and Type 3 halves of a compound or 6-character
+ * message) encodes each once; later lookups copy the 162 symbols out.
+ * Not thread-safe: callers sharing a cache hold their own lock.
+ */
+
+#define WCACHE_KEY_LENGTH 32    // "CALL GRID DBM" and its terminator
+
+struct wcache;
+
+// Room for capacity messages; NULL if out of memory
+struct wcache *wcache_alloc(int capacity);
+void wcache_free(struct wcache *cache);
+
+/*
+ * The 162 symbols of the message, as wspr_enc() makes them, from the
+ * cache or encoded and added to it in place of the least recently used
+ * entry. Messages too long to key are encoded without caching, and
+ * messages that cannot be sent are not cached.
+ *
+ * Returns the message type, 1 - 3, or 0 if the message cannot be sent.
+ */
+uint8_t wcache_symbols(struct wcache *cache, const char *call, const char *grid, const char *dBm,
+                       uint8_t *symbols);
+
+// Lookups answered from the cache and lookups that had to encode
+void wcache_counts(const struct wcache *cache, unsigned long *hits, unsigned long *misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WSPR_CACHE_H
@@ -20,7 +20,8 @@ extern "C" {
  *     dBm      Pointer to a TX power level with ranging "0" to "60".
  * symbols      Output pointer to an array that holding 162 channel symbols.
  *
- * Returns      Message type used in the encoding, ranging is 1 - 3.
+ * Returns      Message type used in the encoding, ranging is 1 - 3, or 0 if
+ *              the message cannot be sent; symbols are then left unchanged.
  */
 uint8_t wspr_enc(const char *call, const char *grid, const char *dBm,
                  uint8_t *symbols);
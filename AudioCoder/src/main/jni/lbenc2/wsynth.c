@@ -0,0 +1,155 @@
+/*
+ * wsynth.c
+ *
+ * Phase-continuous WSPR tone synthesis, see wsynth.h.
+ *
+ * The phasor is advanced in double precision: over a whole symbol its
+ * magnitude drifts by well under 1e-12, and it is renormalized every
+ * WSYNTH_RENORM samples anyway, so the amplitude holds over runs of any
+ * length.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "wsynth.h"
+
+#define WSYNTH_RENORM 4096
+
+// Nearest integer; unlike lrint() this vectorizes
+#define WSYNTH_ROUND(x) ((int16_t) ((x) + ((x) >= 0.0 ? 0.5 : -0.5)))
+
+static void wsynth_osc_renormalize(struct wsynth_osc *osc) {
+    double mag = sqrt(osc->re * osc->re + osc->im * osc->im);
+
+    osc->re /= mag;
+    osc->im /= mag;
+}
+
+void wsynth_osc_init(struct wsynth_osc *osc) {
+    osc->re = 1.0;
+    osc->im = 0.0;
+    wsynth_osc_set_freq(osc, 0.0, 1.0);
+}
+
+void wsynth_osc_set_freq(struct wsynth_osc *osc, double hz, double rate) {
+    double theta = 2.0 * M_PI * hz / rate;
+    int k;
+
+    osc->wre = cos(theta);
+    osc->wim = sin(theta);
+    for (k = 0; k < WSYNTH_LANES; k++) {
+        osc->lre[k] = cos(k * theta);
+        osc->lim[k] = sin(k * theta);
+    }
+    osc->sre = cos(WSYNTH_LANES * theta);
+    osc->sim = sin(WSYNTH_LANES * theta);
+}
+
+/*
+ * Each lane is the phasor a fixed number of samples ahead and all of them
+ * turn by WSYNTH_LANES samples per step, so the lanes do not wait on each
+ * other and the loop vectorizes. The last n % WSYNTH_LANES samples are
+ * done one at a time.
+ */
+void wsynth_osc_run(struct wsynth_osc *osc, int16_t *out, long n, double amplitude) {
+    double re[WSYNTH_LANES], im[WSYNTH_LANES], t;
+    long i, k, m;
+    int l;
+
+    for (k = 0; k + WSYNTH_LANES <= n; k += m) {
+        m = n - k < WSYNTH_RENORM ? (n - k) & ~(long) (WSYNTH_LANES - 1) : WSYNTH_RENORM;
+        for (l = 0; l < WSYNTH_LANES; l++) {
+            re[l] = osc->re * osc->lre[l] - osc->im * osc->lim[l];
+            im[l] = osc->re * osc->lim[l] + osc->im * osc->lre[l];
+        }
+        for (i = 0; i < m; i += WSYNTH_LANES) {
+            for (l = 0; l < WSYNTH_LANES; l++) {
+                out[k + i + l] = WSYNTH_ROUND(amplitude * im[l]);
+                t = re[l] * osc->sre - im[l] * osc->sim;
+                im[l] = re[l] * osc->sim + im[l] * osc->sre;
+                re[l] = t;
+            }
+        }
+        osc->re = re[0];
+        osc->im = im[0];
+        wsynth_osc_renormalize(osc);
+    }
+    for (; k < n; k++) {
+        out[k] = WSYNTH_ROUND(amplitude * osc->im);
+        t = osc->re * osc->wre - osc->im * osc->wim;
+        osc->im = osc->re * osc->wim + osc->im * osc->wre;
+        osc->re = t;
+    }
+}
+
+// First sample of symbol k; the tolerance keeps exact products from rounding up
+static long long wsynth_boundary(const struct wsynth_stream *s, int k) {
+    return (long long) ceil(k * s->symbol_samples - 1e-6);
+}
+
+static double wsynth_tone(const struct wsynth_stream *s, int k) {
+    return s->base_hz + s->symbols[k] * WSYNTH_TONE_SPACING;
+}
+
+static void wsynth_stream_tune(struct wsynth_stream *s, int k) {
+    s->symbol = k;
+    s->next = wsynth_boundary(s, k + 1);
+    wsynth_osc_set_freq(&s->osc, wsynth_tone(s, k), s->rate);
+}
+
+void wsynth_stream_init(struct wsynth_stream *s, const uint8_t *symbols, double base_hz,
+                        double amplitude, double rate, long long start) {
+    double phase = 0.0;
+    int k = 0;
+
+    memcpy(s->symbols, symbols, WSYNTH_SYMBOLS);
+    s->base_hz = base_hz;
+    s->amplitude = amplitude;
+    s->rate = rate;
+    s->symbol_samples = rate * WSYNTH_SYMBOL_SAMPLES / WSYNTH_RATE;
+    s->end = wsynth_boundary(s, WSYNTH_SYMBOLS);
+    s->pos = -start;
+
+    // Joining late: the phase reached by the symbols already gone
+    while (k < WSYNTH_SYMBOLS - 1 && wsynth_boundary(s, k + 1) <= s->pos) {
+        phase += 2.0 * M_PI * wsynth_tone(s, k) *
+                 (wsynth_boundary(s, k + 1) - wsynth_boundary(s, k)) / rate;
+        phase = fmod(phase, 2.0 * M_PI);
+        k++;
+    }
+    if (s->pos > 0) {
+        phase += 2.0 * M_PI * wsynth_tone(s, k) * (s->pos - wsynth_boundary(s, k)) / rate;
+    }
+    s->osc.re = cos(phase);
+    s->osc.im = sin(phase);
+    wsynth_stream_tune(s, k);
+}
+
+long wsynth_stream_read(struct wsynth_stream *s, int16_t *out, long n) {
+    long done = 0, m;
+
+    while (done < n && s->pos < s->end) {
+        if (s->pos < 0) {
+            m = -s->pos < n - done ? (long) -s->pos : n - done;
+            memset(out + done, 0, sizeof(int16_t) * m);
+        } else {
+            if (s->pos >= s->next) wsynth_stream_tune(s, s->symbol + 1);
+            m = s->next - s->pos < n - done ? (long) (s->next - s->pos) : n - done;
+            wsynth_osc_run(&s->osc, out + done, m, s->amplitude);
+        }
+        done += m;
+        s->pos += m;
+    }
+    return done;
+}
+
+long long wsynth_stream_remaining(const struct wsynth_stream *s) {
+    return s->pos < s->end ? s->end - s->pos : 0;
+}
+
+void wsynth_pcm(const uint8_t *symbols, double base_hz, double amplitude, int16_t *out) {
+    struct wsynth_stream s;
+
+    wsynth_stream_init(&s, symbols, base_hz, amplitude, WSYNTH_RATE, 0);
+    wsynth_stream_read(&s, out, (long) WSYNTH_SYMBOLS * WSYNTH_SYMBOL_SAMPLES);
+}
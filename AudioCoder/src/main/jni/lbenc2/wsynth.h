@@ -0,0 +1,83 @@
+#ifndef WSPR_SYNTH_H
+#define WSPR_SYNTH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Phase-continuous 4-FSK audio synthesis of WSPR channel symbols.
+ *
+ * Tones are 12000/8192 Hz (about 1.4648 Hz) apart and each symbol lasts
+ * 8192 samples at 12 kHz. The tone is made by a recursive oscillator,
+ * a unit phasor rotated once per sample, so a tone change only changes
+ * the rotation: the waveform never jumps in phase and no sin() is
+ * called per sample.
+ */
+
+#define WSYNTH_SYMBOLS          162
+#define WSYNTH_RATE             12000
+#define WSYNTH_SYMBOL_SAMPLES   8192
+#define WSYNTH_TONE_SPACING     ((double) WSYNTH_RATE / WSYNTH_SYMBOL_SAMPLES)
+
+#define WSYNTH_LANES 8  // samples computed side by side
+
+struct wsynth_osc {
+    double re, im;                  // phasor; the output is its imaginary part
+    double wre, wim;                // rotation per sample
+    double lre[WSYNTH_LANES];       // rotation by 0..WSYNTH_LANES-1 samples
+    double lim[WSYNTH_LANES];
+    double sre, sim;                // rotation by WSYNTH_LANES samples
+};
+
+// Phasor at phase 0, not rotating
+void wsynth_osc_init(struct wsynth_osc *osc);
+
+// Rotation for a tone of hz at rate samples per second; the phase carries on
+void wsynth_osc_set_freq(struct wsynth_osc *osc, double hz, double rate);
+
+// Next n samples, amplitude * sin(phase) rounded to 16 bits; amplitude at most 32767
+void wsynth_osc_run(struct wsynth_osc *osc, int16_t *out, long n, double amplitude);
+
+/*
+ * Transmission audio made a block at a time, at any sample rate, for
+ * playing while it is generated. Symbol k starts at sample
+ * start + ceil(k * rate * 8192 / 12000) of the stream, so the symbol
+ * clock does not drift at rates that are not multiples of 12 kHz.
+ * Samples before start are silence; a negative start joins the
+ * transmission late, with the phase it would have had by then.
+ */
+struct wsynth_stream {
+    uint8_t symbols[WSYNTH_SYMBOLS];
+    double base_hz, amplitude, rate;
+    double symbol_samples;      // samples per symbol at rate
+    long long pos;              // next sample, counted from the first symbol
+    long long next;             // first sample of the following symbol
+    long long end;              // samples in the transmission
+    int symbol;                 // symbol the oscillator is tuned to
+    struct wsynth_osc osc;
+};
+
+void wsynth_stream_init(struct wsynth_stream *s, const uint8_t *symbols, double base_hz,
+                        double amplitude, double rate, long long start);
+
+// Writes the next samples, at most n; returns their number, 0 once the transmission is over
+long wsynth_stream_read(struct wsynth_stream *s, int16_t *out, long n);
+
+// Samples still to come, including silence before the start
+long long wsynth_stream_remaining(const struct wsynth_stream *s);
+
+/*
+ * Audio of the 162 symbols (values 0-3) with tone 0 at base_hz: fills
+ * WSYNTH_SYMBOLS * WSYNTH_SYMBOL_SAMPLES samples of out at 12 kHz,
+ * starting at phase 0.
+ */
+void wsynth_pcm(const uint8_t *symbols, double base_hz, double amplitude, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WSPR_SYNTH_H
@@ -0,0 +1,123 @@
+/*
+ * wtune.c
+ *
+ * Si5351 tuning words, see wtune.h. Register layouts and limits are those
+ * of AN619, "Manually Generating an Si5351 Register Map".
+ */
+
+#include <math.h>
+#include <string.h>
+#include "wtune.h"
+#include "wsynth.h"
+
+#define WTUNE_OUT_MIN       2500.0
+#define WTUNE_VCO_MIN       600e6
+#define WTUNE_VCO_MAX       900e6
+#define WTUNE_PLL_MIN       15
+#define WTUNE_PLL_MAX       90
+#define WTUNE_MS_MAX        2048
+#define WTUNE_R_MAX         7       // divide by 128
+#define WTUNE_DENOMINATOR   1048575 // largest c, 20 bits
+
+/*
+ * Closest b / c to frac (0 <= frac < 1) with c at most WTUNE_DENOMINATOR:
+ * the best of the continued fraction's convergents and semiconvergents.
+ * Its error is about 1 / c^2 rather than the 1 / c of a fixed denominator.
+ */
+static void wtune_fraction(double frac, uint32_t *b, uint32_t *c) {
+    uint64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0, p2, q2, t, n;
+    double x = frac;
+
+    for (;;) {
+        t = (uint64_t) floor(x);
+        p2 = t * p1 + p0;
+        q2 = t * q1 + q0;
+        if (q2 > WTUNE_DENOMINATOR) {
+            // Largest semiconvergent that fits, if it beats the last convergent
+            n = (WTUNE_DENOMINATOR - q0) / q1;
+            p2 = n * p1 + p0;
+            q2 = n * q1 + q0;
+            if (fabs((double) p2 / q2 - frac) < fabs((double) p1 / q1 - frac)) {
+                p1 = p2;
+                q1 = q2;
+            }
+            break;
+        }
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+        if (x - t < 1e-12) break;
+        x = 1.0 / (x - t);
+    }
+    *b = (uint32_t) p1;
+    *c = (uint32_t) q1;
+}
+
+// Packs a + b / c into the P1, P2, P3 parameter block shared by MSNx and MSx
+static void wtune_pack(uint32_t a, uint32_t b, uint32_t c, uint8_t *regs) {
+    uint32_t f = (uint32_t) (((uint64_t) 128 * b) / c);
+    uint32_t p1 = 128 * a + f - 512;
+    uint32_t p2 = 128 * b - c * f;
+    uint32_t p3 = c;
+
+    regs[0] = (uint8_t) (p3 >> 8);
+    regs[1] = (uint8_t) p3;
+    regs[2] = (uint8_t) ((p1 >> 16) & 0x03);
+    regs[3] = (uint8_t) (p1 >> 8);
+    regs[4] = (uint8_t) p1;
+    regs[5] = (uint8_t) (((p3 >> 12) & 0xF0) | ((p2 >> 16) & 0x0F));
+    regs[6] = (uint8_t) (p2 >> 8);
+    regs[7] = (uint8_t) p2;
+}
+
+int wtune_plan(const struct wtune_synth *synth, double tone0_hz, const uint8_t *symbols,
+               struct wtune_plan *plan) {
+    double xtal = synth->xtal_hz * (1.0 + 1e-9 * synth->correction_ppb);
+    double top = tone0_hz + (WTUNE_TONES - 1) * WSYNTH_TONE_SPACING;
+    double m, scale;
+    uint32_t d;
+    int r = 0, k;
+
+    if (tone0_hz < WTUNE_OUT_MIN || xtal <= 0.0) return 0;
+
+    // R divider only where the multisynth alone cannot divide the VCO down far enough
+    while (r < WTUNE_R_MAX && top * (1 << r) * WTUNE_MS_MAX < WTUNE_VCO_MAX) r++;
+    scale = (double) (1 << r);
+
+    // Largest even divider keeping the top tone's VCO in range
+    m = floor(WTUNE_VCO_MAX / (top * scale));
+    d = m > WTUNE_MS_MAX ? WTUNE_MS_MAX : (uint32_t) m & ~1u;
+    if (d < 4 || d * tone0_hz * scale < WTUNE_VCO_MIN) return 0;
+
+    plan->ms_divider = d;
+    plan->r_div = (uint8_t) r;
+    if (d == 4) {
+        // Divide by 4 has its own mode: P1 = P2 = 0, P3 = 1, MS0_DIVBY4 set
+        memset(plan->ms_regs, 0, WTUNE_REGS);
+        plan->ms_regs[1] = 1;
+        plan->ms_regs[2] = 0x0C;
+    } else {
+        wtune_pack(d, 0, 1, plan->ms_regs);
+    }
+    plan->ms_regs[2] |= (uint8_t) (r << 4);
+
+    for (k = 0; k < WTUNE_TONES; k++) {
+        struct wtune_pll *pll = &plan->tone[k];
+        double ratio = (tone0_hz + k * WSYNTH_TONE_SPACING) * scale * d / xtal;
+
+        pll->a = (uint32_t) floor(ratio);
+        wtune_fraction(ratio - pll->a, &pll->b, &pll->c);
+        if (pll->b == pll->c) {
+            pll->a++;
+            pll->b = 0;
+            pll->c = 1;
+        }
+        if (pll->a < WTUNE_PLL_MIN || pll->a > WTUNE_PLL_MAX) return 0;
+        wtune_pack(pll->a, pll->b, pll->c, pll->regs);
+        pll->hz = xtal * (pll->a + (double) pll->b / pll->c) / (d * scale);
+    }
+
+    for (k = 0; k < WTUNE_SYMBOLS; k++) plan->tones[k] = symbols[k] & 3;
+    return 1;
+}
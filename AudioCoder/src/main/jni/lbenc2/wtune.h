@@ -0,0 +1,59 @@
+#ifndef WSPR_TUNE_H
+#define WSPR_TUNE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Si5351 register values for transmitting WSPR straight from the
+ * synthesizer, following Silicon Labs AN619.
+ *
+ * The output multisynth is set once, to an even integer divider (and an
+ * R divider below about 300 kHz), and the PLL is moved between four
+ * fractional-N settings, one per tone. A transmitter then needs the four
+ * 8-byte PLL register sets and the tone index of each of the 162 symbols
+ * instead of a frequency per symbol.
+ */
+
+#define WTUNE_SYMBOLS   162
+#define WTUNE_TONES     4
+#define WTUNE_REGS      8       // bytes of one multisynth parameter block
+
+struct wtune_synth {
+    double xtal_hz;             // reference, typically 25 or 27 MHz
+    double correction_ppb;      // measured reference error, positive if it runs fast
+};
+
+struct wtune_pll {
+    uint32_t a, b, c;           // feedback divider a + b / c
+    uint8_t regs[WTUNE_REGS];   // MSNA parameters, registers 26-33 (MSNB: 34-41)
+    double hz;                  // output frequency with these values
+};
+
+struct wtune_plan {
+    uint32_t ms_divider;            // output multisynth divider, an even integer
+    uint8_t r_div;                  // output R divider is 1 << r_div
+    uint8_t ms_regs[WTUNE_REGS];    // MS0 parameters, registers 42-49, R0_DIV included
+    struct wtune_pll tone[WTUNE_TONES];
+    uint8_t tones[WTUNE_SYMBOLS];   // tone of each symbol, 0-3
+};
+
+/*
+ * Settings for a transmission whose tone 0 is at tone0_hz on the air
+ * (USB dial frequency + 1500 Hz + offset) and whose symbols are the
+ * 162 channel symbols. The divider is chosen to put the VCO as high as
+ * possible, which makes the fractional steps finest.
+ *
+ * Returns 0 if no setting reaches tone0_hz.
+ */
+int wtune_plan(const struct wtune_synth *synth, double tone0_hz, const uint8_t *symbols,
+               struct wtune_plan *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WSPR_TUNE_H
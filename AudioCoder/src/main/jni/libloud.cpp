@@ -1,9 +1,14 @@
 #include "jni_link.h"
 #include <iostream>
 #include "lbenc2/wenc.h"
+#include "lbenc2/wcache.h"
+#include "lbenc2/wsynth.h"
+#include "lbenc2/wtune.h"
 #include <android/log.h>
 #include <stdio.h>
 #include <math.h>
+#include <memory>
+#include <mutex>
 
 int mains() {
     return 220;
@@ -11,6 +16,78 @@ int mains() {
 
 #define APPNAME "Messodj"
 #define WSPR_SYMBOL_COUNT 162
+#define SYMBOL_CACHE_MESSAGES 256
+
+// Symbols of recently encoded messages, shared by every encode call
+static struct wcache *symbol_cache = NULL;
+static std::mutex symbol_cache_lock;
+
+/*
+ * Channel symbols of a message, from the symbol cache when it has been
+ * encoded before. Returns the message type, or 0 if it cannot be sent.
+ */
+static int encode_symbols(JNIEnv *env, jstring j_calls, jstring j_loca, jint j_powr,
+                          uint8_t *symbols) {
+    char powr[3];
+    int type;
+
+    snprintf(powr, 3, "%02d", (int) j_powr);
+    const char *callsign = env->GetStringUTFChars(j_calls, 0);
+    const char *loca = env->GetStringUTFChars(j_loca, 0);
+    {
+        std::lock_guard<std::mutex> lock(symbol_cache_lock);
+        if (symbol_cache == NULL) symbol_cache = wcache_alloc(SYMBOL_CACHE_MESSAGES);
+        if (symbol_cache != NULL) {
+            type = wcache_symbols(symbol_cache, callsign, loca, powr, symbols);
+        } else {
+            type = LB_WSPR_Encode2symbolz(symbols, callsign, loca, powr);
+        }
+    }
+    env->ReleaseStringUTFChars(j_calls, callsign);
+    env->ReleaseStringUTFChars(j_loca, loca);
+    return type;
+}
+
+/*
+ * Copies the index-th 162-symbol vector out of a byte[] made by
+ * WSPREncodeBatch. Returns false if the array is too short.
+ */
+static bool read_symbols(JNIEnv *env, jbyteArray array, jint index, uint8_t *symbols) {
+    if (array == NULL || index < 0 ||
+        (jlong) (index + 1) * WSPR_SYMBOL_COUNT > env->GetArrayLength(array)) {
+        return false;
+    }
+    env->GetByteArrayRegion(array, index * WSPR_SYMBOL_COUNT, WSPR_SYMBOL_COUNT, (jbyte *) symbols);
+    return true;
+}
+
+// Tones are numbered from the top in LSB mode
+static void apply_sideband(uint8_t *symbols, jboolean lsb_mod) {
+    if (lsb_mod) {
+        for (int i = 0; i < WSPR_SYMBOL_COUNT; i++) {
+            symbols[i] = (uint8_t) 3 - symbols[i];
+        }
+    }
+}
+
+static jbyteArray symbols_to_pcm(JNIEnv *env, uint8_t *symbols, jint j_offset, jboolean lsb_mod) {
+    // Base band carrier 1500 Hz plus the offset; tones are 12000/8192 Hz apart
+    double frequency = 1500 + ((int) j_offset);
+    short volume = 16383;
+    double amp = volume >> 2;
+
+    apply_sideband(symbols, lsb_mod);
+
+    short *sound = (short *) malloc(sizeof(short) * WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH);
+    if (sound == NULL) return NULL;
+    wsynth_pcm(symbols, frequency, amp, sound);
+
+    jbyteArray ret = env->NewByteArray(WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH * sizeof(short));
+    env->SetByteArrayRegion(ret, 0, WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH * sizeof(short),
+                            (jbyte *) sound);
+    free(sound);
+    return ret;
+}
 
 extern "C" JNIEXPORT jbyteArray
 
@@ -18,66 +95,142 @@ JNICALL
 Java_org_operatorfoundation_audiocoder_CJarInterface_WSPREncodeToPCM
         (JNIEnv *env, jclass cls, jstring j_calls, jstring j_loca, jint j_powr, jint j_offset,
          jboolean lsb_mod) {
-    //JTEncode jit;
     uint8_t symbols[WSPR_SYMBOL_COUNT];
 
-    const char *callsign = env->GetStringUTFChars(j_calls, 0);
-    const char *loca = env->GetStringUTFChars(j_loca, 0);
+    if (!encode_symbols(env, j_calls, j_loca, j_powr, symbols)) return NULL;
+    return symbols_to_pcm(env, symbols, j_offset, lsb_mod);
+}
 
-    //jit.wspr_encode(callsign, loca, (uint8_t)j_powr, symbols);
-    char powr[3];
-    snprintf(powr, 3, "%02d", (int) j_powr);
+extern "C" JNIEXPORT jbyteArray
 
-    __android_log_print(ANDROID_LOG_WARN, APPNAME, "WENCODE: %s %s %s", callsign, loca, powr);
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRSymbolsToPCM
+        (JNIEnv *env, jclass cls, jbyteArray j_symbols, jint index, jint j_offset, jboolean lsb_mod) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
 
+    if (!read_symbols(env, j_symbols, index, symbols)) return NULL;
+    return symbols_to_pcm(env, symbols, j_offset, lsb_mod);
+}
 
-    int mt = LB_WSPR_Encode2symbolz(symbols, callsign, loca, powr);
-    __android_log_print(ANDROID_LOG_WARN, APPNAME, "Messodj typo: %d", mt);
+static jlong open_tx(uint8_t *symbols, jint j_offset, jboolean lsb_mod, jint sample_rate,
+                     jlong start_delay) {
+    if (sample_rate <= 0) return 0;
+    apply_sideband(symbols, lsb_mod);
 
-    env->ReleaseStringUTFChars(j_calls, callsign);
-    env->ReleaseStringUTFChars(j_loca, loca);
+    struct wsynth_stream *stream = (struct wsynth_stream *) malloc(sizeof(struct wsynth_stream));
+    if (stream == NULL) return 0;
+    wsynth_stream_init(stream, symbols, 1500 + ((int) j_offset), 16383 >> 2, sample_rate,
+                       start_delay);
+    return (jlong) (intptr_t) stream;
+}
 
+/*
+ * Transmission audio generated a block at a time: WSPRTxOpen encodes the
+ * message and returns a handle to a wsynth_stream, WSPRTxRead fills the
+ * caller's buffer with the next samples and WSPRTxClose frees it.
+ */
+extern "C" JNIEXPORT jlong
 
-    double TAU = 2 * M_PI;
-    //short sound[WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH];
-    short *sound = (short *) malloc(sizeof(short) * WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH);
-    memset(sound, 0, sizeof(short) * WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH);
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRTxOpen
+        (JNIEnv *env, jclass cls, jstring j_calls, jstring j_loca, jint j_powr, jint j_offset,
+         jboolean lsb_mod, jint sample_rate, jlong start_delay) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
 
-    __android_log_print(ANDROID_LOG_WARN, APPNAME, "Target array length: %d",
-                        WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH);
+    if (!encode_symbols(env, j_calls, j_loca, j_powr, symbols)) return 0;
+    return open_tx(symbols, j_offset, lsb_mod, sample_rate, start_delay);
+}
 
-    short volume = 16383;
+extern "C" JNIEXPORT jlong
 
-    for (int i = 0; i < WSPR_SYMBOL_COUNT; i++) {
-        if (lsb_mod) {
-            symbols[i] = (uint8_t) 3 - symbols[i];
-        }
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRTxOpenSymbols
+        (JNIEnv *env, jclass cls, jbyteArray j_symbols, jint index, jint j_offset, jboolean lsb_mod,
+         jint sample_rate, jlong start_delay) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
 
-        // Base band Carrier Frequency - 1500 Hz
-        // Frequency spacing between the symbols - 1.4548
-        double frequency = 1500 + ((int) j_offset) + symbols[i] * 1.4548;
-
-        // TODO: Create a new version of this function that converts frequency (double) to ints ( * 100 + casting to UInt64) to Bytes and returns a byte array of the frequencies
-        // Frequency array size = # of symbols * 8 bytes (size of 64 bit integer)
-        double theta = frequency * TAU / (double) 12000;
-        // 'volume' is UInt16 with range 0 thru Uint16.MaxValue ( = 65 535)
-        // we need 'amp' to have the range of 0 thru Int16.MaxValue ( = 32 767)
-        double amp = volume >> 2; // so we simply set amp = volume / 2
-        for (int step = 0; step < WSPR_SYMBOL_LENGTH; step++) {
-            if (((i * WSPR_SYMBOL_LENGTH) + step) % 10000 == 0)
-                __android_log_print(ANDROID_LOG_VERBOSE, APPNAME, "W @ %d",
-                                    (i * WSPR_SYMBOL_LENGTH) + step);
-
-            sound[(i * WSPR_SYMBOL_LENGTH) + step] = (short) (amp * sin(theta * (double) step));
+    if (!read_symbols(env, j_symbols, index, symbols)) return 0;
+    return open_tx(symbols, j_offset, lsb_mod, sample_rate, start_delay);
+}
+
+extern "C" JNIEXPORT jint
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRTxRead
+        (JNIEnv *env, jclass cls, jlong handle, jshortArray buffer, jint offset, jint count) {
+    struct wsynth_stream *stream = (struct wsynth_stream *) (intptr_t) handle;
+
+    if (stream == NULL || buffer == NULL || offset < 0 || count < 0 ||
+        count > env->GetArrayLength(buffer) - offset) {
+        return -1;
+    }
+    // No JNI calls until released; a read of a few thousand samples takes microseconds
+    jshort *out = (jshort *) env->GetPrimitiveArrayCritical(buffer, 0);
+    if (out == NULL) return -1;
+    long n = wsynth_stream_read(stream, out + offset, count);
+    env->ReleasePrimitiveArrayCritical(buffer, out, 0);
+    return (jint) n;
+}
+
+extern "C" JNIEXPORT jlong
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRTxRemaining(JNIEnv *env, jclass cls,
+                                                                   jlong handle) {
+    struct wsynth_stream *stream = (struct wsynth_stream *) (intptr_t) handle;
+
+    return stream == NULL ? 0 : (jlong) wsynth_stream_remaining(stream);
+}
+
+extern "C" JNIEXPORT void
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRTxClose(JNIEnv *env, jclass cls,
+                                                               jlong handle) {
+    free((struct wsynth_stream *) (intptr_t) handle);
+}
+
+/*
+ * Frequencies of the 162 symbols in units of 0.01 Hz, as a Java long[];
+ * NULL if an array could not be allocated.
+ */
+static jlongArray symbols_to_frequencies(JNIEnv *env, uint8_t *symbols, jint j_offset,
+                                         jboolean lsb_mode) {
+    jlong frequencies[WSPR_SYMBOL_COUNT];
+
+    // Convert each symbol to its corresponding frequency
+    for (int i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        uint8_t symbol = symbols[i];
+
+        // Apply LSB mode inversion if requested
+        if (lsb_mode)
+        {
+            symbol = (uint8_t) (3 - symbol);
         }
+
+        // Calculate the frequency for this symbol.
+        // Base frequency: 1500 Hz
+        // User offset: j_offset Hz
+        // Symbol spacing: 12000/8192 Hz between tones, as the PCM and stream paths use
+        double frequency_hz = 1500.0 + ((double) j_offset) + (symbol * WSYNTH_TONE_SPACING);
+
+        // Convert to 64-bit signed integer with 0.01 Hz precision (multiply by 100)
+        frequencies[i] = (jlong) (frequency_hz * 100.0);
     }
 
+    jlongArray result = env->NewLongArray(WSPR_SYMBOL_COUNT);
+    if (result == NULL)
+    {
+        __android_log_print(ANDROID_LOG_ERROR,
+                            APPNAME,
+                            "Failed to create Java long array for WSPR encoding.");
+        return NULL;
+    }
 
-    jbyteArray ret = env->NewByteArray(WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH * sizeof(short));
-    env->SetByteArrayRegion(ret, 0, WSPR_SYMBOL_COUNT * WSPR_SYMBOL_LENGTH * sizeof(short),
-                            (jbyte *) sound);
-    free(sound);// is it work?
-    return ret;
+    // Copy frequency data to Java long array
+    env->SetLongArrayRegion(result, 0, WSPR_SYMBOL_COUNT, frequencies);
+    return result;
 }
 
 /**
@@ -94,7 +247,7 @@ Java_org_operatorfoundation_audiocoder_CJarInterface_WSPREncodeToPCM
  * @param lsb_mode LSB mode flag - inverts symbol order if true
  *
  * @return jlongArray containing 162 frequencies as 64-bit integers (* 100)
- *          Each frequency has 0.01 Hz precision
+ *          Each frequency has 0.01 Hz precision; NULL if the message cannot be sent
  */
  extern "C" JNIEXPORT jlongArray
  JNICALL
@@ -102,90 +255,143 @@ Java_org_operatorfoundation_audiocoder_CJarInterface_WSPREncodeToPCM
      // Array to hold the 162 WSPR symbols (0-3 values representing frequency shifts)
      uint8_t symbols[WSPR_SYMBOL_COUNT];
 
-     // Convert Java strings to C strings
-     const char *callsign = env->GetStringUTFChars(j_calls, 0);
-     const char *loca = env->GetStringUTFChars(j_local, 0);
-
-     // Format power as 2-digit string (required by encoder)
-     char  powr[3];
-     snprintf(powr, 3, "%02d", (int) j_powr);
-
-     __android_log_print(ANDROID_LOG_INFO,
-                         APPNAME,
-                         "WSPR Frequency Encode: %s %s %s", callsign, loca, powr);
-
-     // Encode WSPR message into symbol array
-     int encode_result = LB_WSPR_Encode2symbolz(symbols, callsign, loca, powr);
-     __android_log_print(ANDROID_LOG_INFO,
-                         APPNAME,
-                         "WSPR encode result: %d", encode_result);
-
-     // Release Java string references
-     env->ReleaseStringUTFChars(j_calls, callsign);
-     env->ReleaseStringUTFChars(j_local, loca);
-
-     int64_t *frequencies = (int64_t *) malloc(WSPR_SYMBOL_COUNT * sizeof(int64_t));
-
-     if (frequencies == NULL)
-     {
-         __android_log_print(ANDROID_LOG_ERROR,
-                             APPNAME,
-                             "Failed to allocate frequency array");
-         return NULL;
-     }
-
-     // Convert each symbol to its corresponding frequency
-     for (int i = 0; i < WSPR_SYMBOL_COUNT; i++)
-     {
-         uint8_t symbol = symbols[i];
-
-         // Apply LSB mode inversion if requested
-         if (lsb_mode)
-         {
-             symbol = (uint8_t) (3 - symbol);
-         }
-
-         // Calculate the frequency for this symbol.
-         // Base frequency: 1500 Hz
-         // User offset: j_offset Hz
-         // Symbol spacing: 1.4648 Hz between tones (WSPR standard)
-         double frequency_hz = 1500.0 + ((double) j_offset) + (symbol * 1.4648);
-
-         // Convert to 64-bit signed integer with 0.01 Hz precision (multiply by 100)
-         frequencies[i] = (int64_t) (frequency_hz * 100.0);
-
-         // Debug: Log the first few frequencies
-         if (i < 5)
-         {
-             __android_log_print(ANDROID_LOG_DEBUG,
-                                 APPNAME,
-                                 "Symbol[%d] = %d, Frequency = %.4f Hz, Encoded = %lld", i, symbol, frequency_hz, (long long)frequencies[i]);
-         }
-     }
-
-     jlongArray result = env->NewLongArray(WSPR_SYMBOL_COUNT);
-     if (result == NULL)
-     {
-         __android_log_print(ANDROID_LOG_ERROR,
-                             APPNAME,
-                             "Failed to create Java long array for WSPR encoding.");
-         free(frequencies);
-         return NULL;
-     }
-
-     // Copy frequency data to Java long array
-     env->SetLongArrayRegion(result, 0, WSPR_SYMBOL_COUNT, (jlong *) frequencies);
-
-     // Don't forget to clean up after yourself!
-     free(frequencies);
-
-     __android_log_print(ANDROID_LOG_INFO, APPNAME,
-                         "WSPR frequency encoding complete: %d frequencies",
-                         WSPR_SYMBOL_COUNT);
-
-     return result;
+     if (!encode_symbols(env, j_calls, j_local, j_powr, symbols)) return NULL;
+     return symbols_to_frequencies(env, symbols, j_offset, lsb_mode);
  }
 
+extern "C" JNIEXPORT jlongArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRSymbolsToFrequencies
+        (JNIEnv *env, jclass cls, jbyteArray j_symbols, jint index, jint j_offset, jboolean lsb_mode) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
+
+    if (!read_symbols(env, j_symbols, index, symbols)) return NULL;
+    return symbols_to_frequencies(env, symbols, j_offset, lsb_mode);
+}
+
+static void set_byte_array(JNIEnv *env, jobject obj, jclass cls, const char *name,
+                           const uint8_t *values, int n) {
+    jbyteArray array = env->NewByteArray(n);
+    env->SetByteArrayRegion(array, 0, n, (const jbyte *) values);
+    env->SetObjectField(obj, env->GetFieldID(cls, name, "[B"), array);
+    env->DeleteLocalRef(array);
+}
+
+/*
+ * Fills a WSPRTuningWords with the Si5351 settings of a transmission. Its
+ * fields are written by name, so keep them in sync with
+ * WSPRTuningWords.java. Returns false if the synthesizer cannot reach the
+ * frequency.
+ */
+static jboolean write_tuning_words(JNIEnv *env, const uint8_t *symbols, jdouble dial_hz,
+                                   jint j_offset, jdouble xtal_hz, jdouble correction_ppb,
+                                   jobject out) {
+    struct wtune_synth synth = {xtal_hz, correction_ppb};
+    struct wtune_plan plan;
+    uint8_t pll_regs[WTUNE_TONES * WTUNE_REGS];
+    jdouble tone_hz[WTUNE_TONES];
+
+    if (out == NULL || !wtune_plan(&synth, dial_hz + 1500.0 + j_offset, symbols, &plan)) {
+        return JNI_FALSE;
+    }
+    for (int k = 0; k < WTUNE_TONES; k++) {
+        memcpy(pll_regs + k * WTUNE_REGS, plan.tone[k].regs, WTUNE_REGS);
+        tone_hz[k] = plan.tone[k].hz;
+    }
+
+    jclass cls = env->GetObjectClass(out);
+    env->SetIntField(out, env->GetFieldID(cls, "multisynthDivider", "I"), (jint) plan.ms_divider);
+    env->SetIntField(out, env->GetFieldID(cls, "rDivider", "I"), 1 << plan.r_div);
+    set_byte_array(env, out, cls, "multisynthRegisters", plan.ms_regs, WTUNE_REGS);
+    set_byte_array(env, out, cls, "pllRegisters", pll_regs, WTUNE_TONES * WTUNE_REGS);
+    set_byte_array(env, out, cls, "tones", plan.tones, WTUNE_SYMBOLS);
+    jdoubleArray array = env->NewDoubleArray(WTUNE_TONES);
+    env->SetDoubleArrayRegion(array, 0, WTUNE_TONES, tone_hz);
+    env->SetObjectField(out, env->GetFieldID(cls, "toneFrequencies", "[D"), array);
+    env->DeleteLocalRef(array);
+    env->DeleteLocalRef(cls);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPREncodeToTuningWords
+        (JNIEnv *env, jclass cls, jstring j_calls, jstring j_loca, jint j_powr, jdouble dial_hz,
+         jint j_offset, jdouble xtal_hz, jdouble correction_ppb, jobject words) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
+
+    if (!encode_symbols(env, j_calls, j_loca, j_powr, symbols)) return JNI_FALSE;
+    return write_tuning_words(env, symbols, dial_hz, j_offset, xtal_hz, correction_ppb, words);
+}
+
+extern "C" JNIEXPORT jboolean
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRSymbolsToTuningWords
+        (JNIEnv *env, jclass cls, jbyteArray j_symbols, jint index, jdouble dial_hz, jint j_offset,
+         jdouble xtal_hz, jdouble correction_ppb, jobject words) {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
+
+    if (!read_symbols(env, j_symbols, index, symbols)) return JNI_FALSE;
+    return write_tuning_words(env, symbols, dial_hz, j_offset, xtal_hz, correction_ppb, words);
+}
+
+/*
+ * Encodes many messages in one call: symbols of message i are bytes
+ * 162 * i to 162 * i + 161 of the result. NULL if the arrays differ in
+ * length, hold a null entry or hold a message that cannot be sent.
+ */
+extern "C" JNIEXPORT jbyteArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPREncodeBatch
+        (JNIEnv *env, jclass cls, jobjectArray j_calls, jobjectArray j_locas, jintArray j_powrs) {
+    jsize n = env->GetArrayLength(j_calls);
+
+    if (env->GetArrayLength(j_locas) != n || env->GetArrayLength(j_powrs) != n) return NULL;
+
+    jbyteArray result = env->NewByteArray(n * WSPR_SYMBOL_COUNT);
+    if (result == NULL) return NULL;
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
+    jint powr;
+    bool ok = true;
+
+    for (jsize i = 0; i < n && ok; i++) {
+        jstring call = (jstring) env->GetObjectArrayElement(j_calls, i);
+        jstring loca = (jstring) env->GetObjectArrayElement(j_locas, i);
+        ok = call != NULL && loca != NULL;
+        if (ok) {
+            env->GetIntArrayRegion(j_powrs, i, 1, &powr);
+            ok = encode_symbols(env, call, loca, powr, symbols) != 0;
+        }
+        if (ok) {
+            env->SetByteArrayRegion(result, i * WSPR_SYMBOL_COUNT, WSPR_SYMBOL_COUNT,
+                                    (jbyte *) symbols);
+        }
+        env->DeleteLocalRef(call);
+        env->DeleteLocalRef(loca);
+    }
+    return ok ? result : NULL;
+}
+
+extern "C" JNIEXPORT jlongArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRGetSymbolCacheCounts(JNIEnv *env,
+                                                                            jclass cls) {
+    unsigned long hits = 0, misses = 0;
+    {
+        std::lock_guard<std::mutex> lock(symbol_cache_lock);
+        if (symbol_cache != NULL) wcache_counts(symbol_cache, &hits, &misses);
+    }
+    jlong counts[2] = {(jlong) hits, (jlong) misses};
+    jlongArray result = env->NewLongArray(2);
+    if (result != NULL) env->SetLongArrayRegion(result, 0, 2, counts);
+    return result;
+}
+
 
 
 extern "C"
@@ -203,9 +409,56 @@ unsigned char *as_unsigned_char_array(JNIEnv *env, jbyteArray array) {
     return buf;
 }
 
+#include "wsprd/wsprd_decoder.h"
+#include "wsprd/callhash.h"
+#include "wsprd/wsprd_trace.h"
+#include <string>
+
+/*
+ * Callsigns behind hashed calls, kept across decodes; see
+ * WSPRSetCallsignStore. Every decode holds a reference for as long as it
+ * runs, so a store that is replaced is closed only once the decodes
+ * using it have finished.
+ */
+static std::shared_ptr<struct callhash> callsign_store;
+static std::mutex callsign_store_lock;
+
+static std::shared_ptr<struct callhash> current_callsign_store() {
+    std::lock_guard<std::mutex> lock(callsign_store_lock);
+    return callsign_store;
+}
+
+// Span trace of the latest decode and the file it is written to; see WSPRSetDecodeTrace
+#define DECODE_TRACE_SPANS 65536
+static struct wsprd_trace *decode_trace = NULL;
+static std::string decode_trace_path;
+static std::mutex decode_trace_lock;
+
 extern "C" jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
                                         unsigned char *soundarr, int len, double jdialfreq,
-                                        jboolean lsb_mode);
+                                        jboolean lsb_mode, const struct wsprd_options *opts);
+
+/*
+ * jani_do_process(), writing a trace of the decode when one is set. A
+ * decode that starts while another is being traced runs untraced rather
+ * than waiting for it.
+ */
+static jobjectArray process_traced(JNIEnv *env, jclass clazz, unsigned char *soundarr, int len,
+                                   double dialfreq, jboolean lsb, struct wsprd_options *opts) {
+    std::unique_lock<std::mutex> lock(decode_trace_lock, std::try_to_lock);
+    if (!lock.owns_lock() || decode_trace == NULL) {
+        return jani_do_process(env, clazz, soundarr, len, dialfreq, lsb, opts);
+    }
+
+    wsprd_trace_reset(decode_trace);
+    opts->trace = decode_trace;
+    jobjectArray result = jani_do_process(env, clazz, soundarr, len, dialfreq, lsb, opts);
+    if (!wsprd_trace_write(decode_trace, decode_trace_path.c_str())) {
+        __android_log_print(ANDROID_LOG_WARN, APPNAME, "Cannot write decode trace %s",
+                            decode_trace_path.c_str());
+    }
+    return result;
+}
 
 extern "C"
 JNIEXPORT jobjectArray
@@ -214,9 +467,176 @@ JNICALL
 Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRDecodeFromPcm(JNIEnv *env, jclass clazz,
                                                                   jbyteArray sound,
                                                                   jdouble dialfreq, jboolean lsb) {
+    struct wsprd_options opts;
+    std::shared_ptr<struct callhash> store = current_callsign_store();
+    wsprd_options_init(&opts);
+    opts.callhash = store.get();
+
+    unsigned char *soundarr = as_unsigned_char_array(env, sound);
+    jobjectArray result = process_traced(env, clazz, soundarr, (int) env->GetArrayLength(sound),
+                                         dialfreq, lsb, &opts);
+    delete[] soundarr;
+    return result;
+}
+
+/*
+ * Copies the fields of a WSPRDecoderOptions object into the native options;
+ * a null object leaves the defaults in place.
+ */
+static void read_decoder_options(JNIEnv *env, jobject options, struct wsprd_options *opts) {
+    wsprd_options_init(opts);
+    if (options == NULL) return;
+
+    jclass cls = env->GetObjectClass(options);
+    opts->deep_search = env->GetBooleanField(options, env->GetFieldID(cls, "deepSearch", "Z"));
+    opts->max_passes = env->GetIntField(options, env->GetFieldID(cls, "maxPasses", "I"));
+    opts->deadline_ms = env->GetIntField(options, env->GetFieldID(cls, "deadlineMillis", "I"));
+    opts->osd_depth = env->GetIntField(options, env->GetFieldID(cls, "osdDepth", "I"));
+    opts->stack_decoder = env->GetBooleanField(options, env->GetFieldID(cls, "stackDecoder", "Z"));
+    opts->decode_threads = env->GetIntField(options, env->GetFieldID(cls, "decodeThreads", "I"));
+    opts->adaptive_cycles = env->GetBooleanField(options, env->GetFieldID(cls, "adaptiveCycles", "Z"));
+    opts->metric_bias = env->GetFloatField(options, env->GetFieldID(cls, "metricBias", "F"));
+    env->DeleteLocalRef(cls);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRDecodeFromPcmWithOptions(JNIEnv *env, jclass clazz,
+                                                                             jbyteArray sound,
+                                                                             jdouble dialfreq, jboolean lsb,
+                                                                             jobject options) {
+    struct wsprd_options opts;
+    std::shared_ptr<struct callhash> store = current_callsign_store();
+    read_decoder_options(env, options, &opts);
+    opts.callhash = store.get();
+
+    unsigned char *soundarr = as_unsigned_char_array(env, sound);
+    jobjectArray result = process_traced(env, clazz, soundarr, (int) env->GetArrayLength(sound),
+                                         dialfreq, lsb, &opts);
+    delete[] soundarr;
+    return result;
+}
+
+static void set_double_field(JNIEnv *env, jobject obj, jclass cls, const char *name, double value) {
+    env->SetDoubleField(obj, env->GetFieldID(cls, name, "D"), value);
+}
+
+static void set_long_field(JNIEnv *env, jobject obj, jclass cls, const char *name, jlong value) {
+    env->SetLongField(obj, env->GetFieldID(cls, name, "J"), value);
+}
+
+static void set_int_array_field(JNIEnv *env, jobject obj, jclass cls, const char *name,
+                                const int *values, int n) {
+    jintArray array = env->NewIntArray(n);
+    env->SetIntArrayRegion(array, 0, n, reinterpret_cast<const jint *>(values));
+    env->SetObjectField(obj, env->GetFieldID(cls, name, "[I"), array);
+    env->DeleteLocalRef(array);
+}
+
+/*
+ * Copies native decode statistics into a WSPRDecodeStats object, with
+ * times in milliseconds.
+ */
+static void write_decode_stats(JNIEnv *env, jobject out, const struct wsprd_stats *stats) {
+    jclass cls = env->GetObjectClass(out);
+    jdouble wall[WSPRD_STAGES], cpu[WSPRD_STAGES];
+
+    for (int i = 0; i < WSPRD_STAGES; i++) {
+        wall[i] = 1e3 * stats->wall_seconds[i];
+        cpu[i] = 1e3 * stats->cpu_seconds[i];
+    }
+    jdoubleArray array = env->NewDoubleArray(WSPRD_STAGES);
+    env->SetDoubleArrayRegion(array, 0, WSPRD_STAGES, wall);
+    env->SetObjectField(out, env->GetFieldID(cls, "stageWallMillis", "[D"), array);
+    env->DeleteLocalRef(array);
+    array = env->NewDoubleArray(WSPRD_STAGES);
+    env->SetDoubleArrayRegion(array, 0, WSPRD_STAGES, cpu);
+    env->SetObjectField(out, env->GetFieldID(cls, "stageCpuMillis", "[D"), array);
+    env->DeleteLocalRef(array);
+
+    set_double_field(env, out, cls, "totalWallMillis", 1e3 * stats->total_wall_seconds);
+    set_double_field(env, out, cls, "totalCpuMillis", 1e3 * stats->total_cpu_seconds);
+    set_int_array_field(env, out, cls, "candidatesPerPass", stats->candidates, stats->passes);
+    set_int_array_field(env, out, cls, "decodesPerPass", stats->pass_decodes, stats->passes);
+    set_long_field(env, out, cls, "decoderAttempts", (jlong) stats->decoder_attempts);
+    set_long_field(env, out, cls, "decoderTimeouts", (jlong) stats->decoder_timeouts);
+    set_long_field(env, out, cls, "decoderCycles", (jlong) stats->decoder_cycles);
+    set_long_field(env, out, cls, "osdAttempts", (jlong) stats->osd_attempts);
+    set_long_field(env, out, cls, "osdDecodes", (jlong) stats->osd_decodes);
+    env->SetIntField(out, env->GetFieldID(cls, "subtractions", "I"), stats->subtractions);
+    set_long_field(env, out, cls, "peakScratchBytes", (jlong) stats->peak_scratch_bytes);
+    env->DeleteLocalRef(cls);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRDecodeFromPcmWithStats(JNIEnv *env, jclass clazz,
+                                                                           jbyteArray sound,
+                                                                           jdouble dialfreq, jboolean lsb,
+                                                                           jobject options, jobject stats) {
+    struct wsprd_options opts;
+    struct wsprd_stats native_stats;
+    std::shared_ptr<struct callhash> store = current_callsign_store();
+    read_decoder_options(env, options, &opts);
+    opts.callhash = store.get();
+    memset(&native_stats, 0, sizeof(native_stats));
+    opts.stats = &native_stats;
+
     unsigned char *soundarr = as_unsigned_char_array(env, sound);
+    jobjectArray result = process_traced(env, clazz, soundarr, (int) env->GetArrayLength(sound),
+                                         dialfreq, lsb, &opts);
+    delete[] soundarr;
+    if (stats != NULL) write_decode_stats(env, stats, &native_stats);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jboolean
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRSetCallsignStore(JNIEnv *env, jclass clazz,
+                                                                     jstring path) {
+    std::shared_ptr<struct callhash> store;
+
+    if (path != NULL) {
+        const char *cpath = env->GetStringUTFChars(path, 0);
+        struct callhash *opened = callhash_open(cpath);
+        env->ReleaseStringUTFChars(path, cpath);
+        if (opened == NULL) return JNI_FALSE;
+        store.reset(opened, callhash_close);
+    }
+    {
+        std::lock_guard<std::mutex> lock(callsign_store_lock);
+        callsign_store.swap(store);
+    }
+    // The previous store is closed here, or by the last decode still using it
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean
 
-    return jani_do_process(env, clazz, soundarr, (int) env->GetArrayLength(sound), dialfreq, lsb);
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRSetDecodeTrace(JNIEnv *env, jclass clazz,
+                                                                   jstring path) {
+    std::lock_guard<std::mutex> lock(decode_trace_lock);
+
+    if (path == NULL) {
+        wsprd_trace_free(decode_trace);
+        decode_trace = NULL;
+        return JNI_TRUE;
+    }
+    if (decode_trace == NULL && (decode_trace = wsprd_trace_alloc(DECODE_TRACE_SPANS)) == NULL) {
+        return JNI_FALSE;
+    }
+    const char *cpath = env->GetStringUTFChars(path, 0);
+    decode_trace_path = cpath;
+    env->ReleaseStringUTFChars(path, cpath);
+    return JNI_TRUE;
 }
 
 
@@ -236,6 +656,69 @@ Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRNhash(JNIEnv *env, jcla
             ret;
 }
 
+/*
+ * Copies a String[] of callsigns into 13-byte slots of buf, with calls
+ * pointing at each one. Null or over-long entries become NULL pointers.
+ */
+static void read_callsigns(JNIEnv *env, jobjectArray array, int n, char *buf, const char **calls) {
+    for (int i = 0; i < n; i++) {
+        jstring s = (jstring) env->GetObjectArrayElement(array, i);
+        calls[i] = NULL;
+        if (s == NULL) continue;
+        jsize len = env->GetStringLength(s);
+        if (len > 0 && len <= 12 && env->GetStringUTFLength(s) == len) {
+            char *slot = buf + i * 13;
+            env->GetStringUTFRegion(s, 0, len, slot);
+            slot[len] = 0;
+            calls[i] = slot;
+        }
+        env->DeleteLocalRef(s);
+    }
+}
+
+extern "C"
+JNIEXPORT jintArray
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRNhashBatch(JNIEnv *env, jclass clazz,
+                                                               jobjectArray calls) {
+    int n = env->GetArrayLength(calls);
+    char *buf = new char[n * 13];
+    const char **ptrs = new const char *[n];
+    jint *hashes = new jint[n];
+
+    read_callsigns(env, calls, n, buf, ptrs);
+    callhash_hash_batch(ptrs, n, hashes);
+
+    jintArray result = env->NewIntArray(n);
+    env->SetIntArrayRegion(result, 0, n, hashes);
+    delete[] hashes;
+    delete[] ptrs;
+    delete[] buf;
+    return result;
+}
+
+extern "C"
+JNIEXPORT jint
+
+JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRPreloadCallsigns(JNIEnv *env, jclass clazz,
+                                                                     jobjectArray calls) {
+    std::shared_ptr<struct callhash> store = current_callsign_store();
+    if (store == NULL) return -1;
+
+    int n = env->GetArrayLength(calls);
+    char *buf = new char[n * 13];
+    const char **ptrs = new const char *[n];
+
+    read_callsigns(env, calls, n, buf, ptrs);
+    int added = callhash_preload(store.get(), ptrs, n);
+
+    delete[] ptrs;
+    delete[] buf;
+    return (jint) added;
+}
+
 
 extern "C"
 JNIEXPORT jstring JNICALL
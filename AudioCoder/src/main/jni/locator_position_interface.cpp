@@ -3,154 +3,162 @@
 #include "lbenc2/wenc.h"
 #include <android/log.h>
 #include <stdio.h>
+#include <ctype.h>
 #include <math.h>
 
-class LocatorPosnInterface {
-public:
-    double lata, lona, latb, lonb;
-    char *loca, *locb;
+/*
+ * Great-circle paths between Maidenhead locators. A locator is parsed
+ * once into the unit vector of its position, so a path needs only a dot
+ * and a cross product and the two atan2() calls: no per-path sin/cos.
+ * Paths are computed a block at a time in stack arrays, and the block
+ * arithmetic vectorizes; nothing is allocated.
+ */
 
-    LocatorPosnInterface(const char *ina, const char *inb) {
-        this->lata = -90.0;
-        this->lona = -180.0;
-        this->latb = -90.0;
-        this->lonb = -180;
-        this->loca = (char *) malloc(11);
-        memset(this->loca, 0, 11);
-        this->locb = (char *) malloc(11);
-        memset(this->locb, 0, 11);
+#define LOCATOR_MAX_LENGTH 10   // up to five character pairs
+#define LOCATOR_BLOCK 64        // paths computed together
 
+// Kilometres per degree of arc, as the distance has always been reported
+#define LOCATOR_KM_PER_DEGREE (60 * 1.1515 * 1.609344)
 
-        strcpy(this->loca, ina);
-        strcpy(this->locb, inb);
-
-
-        while ((strlen(this->loca) / 2) < 5) {
-            if (((strlen(this->loca) / 2) % 2) == 1) {
-                this->loca[strlen(this->loca)] = '5';
-                this->loca[strlen(this->loca)] = '5';
-            } else {
-                this->loca[strlen(this->loca)] = 'L';
-                this->loca[strlen(this->loca)] = 'L';
-            }
-        }
+struct LocatorPoint {
+    double x, y, z;
+};
 
-        while ((strlen(this->locb) / 2) < 5) {
-            if (((strlen(this->locb) / 2) % 2) == 1) {
-                this->locb[strlen(this->locb)] = '5';
-                this->locb[strlen(this->locb)] = '5';
+/*
+ * Position of the centre of a locator of 2 to 10 characters: missing
+ * pairs are taken as the middle of the square ("LL" for a letter pair,
+ * "55" for a digit pair). Returns false for anything that is not a locator.
+ */
+static bool locator_point(const char *loc, int length, LocatorPoint &p) {
+    static const double divisors[5] = {1, 10, 10 * 24, 10 * 24 * 10, 10 * 24 * 10 * 24};
+    double lat = -90.0, lon = -180.0;
+
+    if (length < 2 || length > LOCATOR_MAX_LENGTH || length % 2 != 0) return false;
+    for (int pair = 0; pair < 5; pair++) {
+        int llon, llat;
+
+        if (2 * pair < length) {
+            char grid_lon = (char) toupper(loc[2 * pair]);
+            char grid_lat = (char) toupper(loc[2 * pair + 1]);
+
+            if (pair % 2 == 1) {
+                if (grid_lon < '0' || grid_lon > '9' || grid_lat < '0' || grid_lat > '9') return false;
+                llon = grid_lon - '0';
+                llat = grid_lat - '0';
             } else {
-                this->locb[strlen(this->locb)] = 'L';
-                this->locb[strlen(this->locb)] = 'L';
+                char last = pair == 0 ? 'R' : 'X';
+                if (grid_lon < 'A' || grid_lon > last || grid_lat < 'A' || grid_lat > last) return false;
+                llon = grid_lon - 'A';
+                llat = grid_lat - 'A';
             }
+        } else {
+            llon = llat = pair % 2 == 1 ? 5 : 11;
         }
-
-
-        this->extractLocatorPartA(0, 1);
-        this->extractLocatorPartA(1, 10);
-        this->extractLocatorPartA(2, 10 * 24);
-        this->extractLocatorPartA(3, 10 * 24 * 10);
-        this->extractLocatorPartA(4, 10 * 24 * 10 * 24);
-
-
-        this->extractLocatorPartB(0, 1);
-        this->extractLocatorPartB(1, 10);
-        this->extractLocatorPartB(2, 10 * 24);
-        this->extractLocatorPartB(3, 10 * 24 * 10);
-        this->extractLocatorPartB(4, 10 * 24 * 10 * 24);
-
-
+        lat += llat * 10.0 / divisors[pair];
+        lon += llon * 20.0 / divisors[pair];
     }
 
-    double getDistance() {
-        double theta, dist;
+    lat *= M_PI / 180;
+    lon *= M_PI / 180;
+    p.x = cos(lat) * cos(lon);
+    p.y = cos(lat) * sin(lon);
+    p.z = sin(lat);
+    return true;
+}
 
-        if ((this->lata == this->latb) && (this->lona == this->lonb)) {
-            return 0;
-        } else {
-            theta = this->lona - this->lonb;
-            dist = sin(deg2rad(this->lata)) * sin(deg2rad(this->latb)) +
-                   cos(deg2rad(this->lata)) * cos(deg2rad(this->latb)) * cos(deg2rad(theta));
-            dist = acos(dist);
-            dist = this->rad2deg(dist);
-            dist = dist * 60 * 1.1515;
-            dist = dist * 1.609344;
-            return dist;
-        }
+/*
+ * Distance in km and initial bearing in degrees east of north from a[i]
+ * to b[i], n at most LOCATOR_BLOCK. The bearing is atan2 of the
+ * components of b along east and north at a, both scaled by cos(lat a),
+ * which is never 0 at the centre of a locator.
+ */
+static void locator_paths(const double *ax, const double *ay, const double *az,
+                          const double *bx, const double *by, const double *bz, int n,
+                          double *km, double *azimuth) {
+    double sin_arc[LOCATOR_BLOCK], cos_arc[LOCATOR_BLOCK];
+    double east[LOCATOR_BLOCK], north[LOCATOR_BLOCK];
+
+    for (int i = 0; i < n; i++) {
+        double cx = ay[i] * bz[i] - az[i] * by[i];
+        double cy = az[i] * bx[i] - ax[i] * bz[i];
+        double cz = ax[i] * by[i] - ay[i] * bx[i];
+
+        sin_arc[i] = sqrt(cx * cx + cy * cy + cz * cz);
+        cos_arc[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+        east[i] = cz;
+        north[i] = bz[i] * (ax[i] * ax[i] + ay[i] * ay[i]) - az[i] * (ax[i] * bx[i] + ay[i] * by[i]);
     }
-
-    ~LocatorPosnInterface() {
-        free(this->loca);
-        free(this->locb);
+    for (int i = 0; i < n; i++) {
+        km[i] = atan2(sin_arc[i], cos_arc[i]) * (180 / M_PI) * LOCATOR_KM_PER_DEGREE;
     }
-
-private:
-    void extractLocatorPartA(int counter, double divisor) {
-        char grid_lon = this->loca[counter * 2];
-        char grid_lat = this->loca[counter * 2 + 1];
-
-        int llat, llon;
-
-        if ('0' <= grid_lat && grid_lat <= '9') {
-            llat = grid_lat - '0';
-        } else if ('a' <= grid_lat && grid_lat <= 'z') {
-            llat = grid_lat - 'a';
-        } else if ('A' <= grid_lat && grid_lat <= 'Z') {
-            llat = grid_lat - 'A';
-        }
-
-        if ('0' <= grid_lon && grid_lon <= '9') {
-            llon = grid_lon - '0';
-        } else if ('a' <= grid_lon && grid_lon <= 'z') {
-            llon = grid_lon - 'a';
-        } else if ('A' <= grid_lon && grid_lon <= 'Z') {
-            llon = grid_lon - 'A';
-        }
-
-        this->lata += llat * 10.0 / divisor;
-        this->lona += llon * 20.0 / divisor;
-
+    if (azimuth == NULL) return;
+    for (int i = 0; i < n; i++) {
+        double deg = atan2(east[i], north[i]) * (180 / M_PI);
+        azimuth[i] = deg < 0 ? deg + 360 : deg;
     }
+}
 
-    void extractLocatorPartB(int counter, double divisor) {
-        char grid_lon = this->locb[counter * 2];
-        char grid_lat = this->locb[counter * 2 + 1];
+// Reads a locator without copying the string out of the VM; false for null or not a locator
+static bool read_locator(JNIEnv *env, jstring j_loc, LocatorPoint &p) {
+    char loc[LOCATOR_MAX_LENGTH + 1];
 
-        int llat, llon;
+    if (j_loc == NULL) return false;
+    jsize length = env->GetStringLength(j_loc);
+    if (length > LOCATOR_MAX_LENGTH || env->GetStringUTFLength(j_loc) != length) return false;
+    env->GetStringUTFRegion(j_loc, 0, length, loc);
+    loc[length] = 0;
+    return locator_point(loc, length, p);
+}
 
-        if ('0' <= grid_lat && grid_lat <= '9') {
-            llat = grid_lat - '0';
-        } else if ('a' <= grid_lat && grid_lat <= 'z') {
-            llat = grid_lat - 'a';
-        } else if ('A' <= grid_lat && grid_lat <= 'Z') {
-            llat = grid_lat - 'A';
+/*
+ * Paths from origins to targets, a block at a time: origin i of from, or
+ * the one origin when from is NULL. Locators that do not parse, or a NULL
+ * origin without from, give NaN.
+ */
+static void locator_path_blocks(JNIEnv *env, const LocatorPoint *origin, jobjectArray from,
+                                jobjectArray to, jsize n, jdoubleArray j_km,
+                                jdoubleArray j_azimuth) {
+    double ax[LOCATOR_BLOCK], ay[LOCATOR_BLOCK], az[LOCATOR_BLOCK];
+    double bx[LOCATOR_BLOCK], by[LOCATOR_BLOCK], bz[LOCATOR_BLOCK];
+    double km[LOCATOR_BLOCK], azimuth[LOCATOR_BLOCK];
+    bool valid[LOCATOR_BLOCK];
+    LocatorPoint a, b;
+
+    if (origin != NULL) a = *origin;
+    for (jsize start = 0; start < n; start += LOCATOR_BLOCK) {
+        int m = n - start < LOCATOR_BLOCK ? (int) (n - start) : LOCATOR_BLOCK;
+
+        for (int i = 0; i < m; i++) {
+            valid[i] = from != NULL || origin != NULL;
+            if (from != NULL) {
+                jstring j_a = (jstring) env->GetObjectArrayElement(from, start + i);
+                valid[i] = read_locator(env, j_a, a);
+                env->DeleteLocalRef(j_a);
+            }
+            jstring j_b = (jstring) env->GetObjectArrayElement(to, start + i);
+            valid[i] = read_locator(env, j_b, b) && valid[i];
+            env->DeleteLocalRef(j_b);
+
+            if (!valid[i]) a = b = {0, 0, 1};
+            ax[i] = a.x, ay[i] = a.y, az[i] = a.z;
+            bx[i] = b.x, by[i] = b.y, bz[i] = b.z;
+            if (origin != NULL) a = *origin;
         }
 
-        if ('0' <= grid_lon && grid_lon <= '9') {
-            llon = grid_lon - '0';
-        } else if ('a' <= grid_lon && grid_lon <= 'z') {
-            llon = grid_lon - 'a';
-        } else if ('A' <= grid_lon && grid_lon <= 'Z') {
-            llon = grid_lon - 'A';
+        locator_paths(ax, ay, az, bx, by, bz, m, km, j_azimuth != NULL ? azimuth : NULL);
+        for (int i = 0; i < m; i++) {
+            if (!valid[i]) km[i] = azimuth[i] = NAN;
         }
-
-        this->latb += llat * 10.0 / divisor;
-        this->lonb += llon * 20.0 / divisor;
-
-    }
-
-
-    double deg2rad(double deg) {
-        return (deg * M_PI / 180);
-    }
-
-
-    double rad2deg(double rad) {
-        return (rad * 180 / M_PI);
+        env->SetDoubleArrayRegion(j_km, start, m, km);
+        if (j_azimuth != NULL) env->SetDoubleArrayRegion(j_azimuth, start, m, azimuth);
     }
+}
 
-};
-
+// False if an output array is too short for n paths
+static bool path_outputs_fit(JNIEnv *env, jsize n, jdoubleArray j_km, jdoubleArray j_azimuth) {
+    if (j_km == NULL || env->GetArrayLength(j_km) < n) return false;
+    return j_azimuth == NULL || env->GetArrayLength(j_azimuth) >= n;
+}
 
 extern "C"
 JNIEXPORT jdouble JNICALL
@@ -158,22 +166,47 @@ Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRGetDistanceBetweenLocat
                                                                                jclass clazz,
                                                                                jstring a,
                                                                                jstring b) {
-    const char *j_a = env->GetStringUTFChars(a, 0);
-    const char *j_b = env->GetStringUTFChars(b, 0);
+    LocatorPoint pa, pb;
+    double ax, ay, az, bx, by, bz, km;
 
-    if (strlen(j_a) == 0 || strlen(j_b) == 0) {
-        env->ReleaseStringUTFChars(a, j_a);
-        env->ReleaseStringUTFChars(b, j_b);
+    if (!read_locator(env, a, pa) || !read_locator(env, b, pb)) {
         return (jdouble) -1;
     }
 
-    LocatorPosnInterface *lpi = new LocatorPosnInterface(j_a, j_b);
-
-    env->ReleaseStringUTFChars(a, j_a);
-    env->ReleaseStringUTFChars(b, j_b);
+    ax = pa.x, ay = pa.y, az = pa.z;
+    bx = pb.x, by = pb.y, bz = pb.z;
+    locator_paths(&ax, &ay, &az, &bx, &by, &bz, 1, &km, NULL);
+    return (jdouble) km;
+}
 
-    jdouble ret = (jdouble) lpi->getDistance();
-    delete lpi;
+extern "C"
+JNIEXPORT jint JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRGetLocatorPaths(JNIEnv *env,
+                                                                    jclass clazz,
+                                                                    jobjectArray from,
+                                                                    jobjectArray to,
+                                                                    jdoubleArray km,
+                                                                    jdoubleArray azimuth) {
+    jsize n = env->GetArrayLength(to);
+
+    if (env->GetArrayLength(from) != n || !path_outputs_fit(env, n, km, azimuth)) return -1;
+    locator_path_blocks(env, NULL, from, to, n, km, azimuth);
+    return (jint) n;
+}
 
-    return ret;
+extern "C"
+JNIEXPORT jint JNICALL
+Java_org_operatorfoundation_audiocoder_CJarInterface_WSPRGetLocatorPathsFrom(JNIEnv *env,
+                                                                        jclass clazz,
+                                                                        jstring origin,
+                                                                        jobjectArray to,
+                                                                        jdoubleArray km,
+                                                                        jdoubleArray azimuth) {
+    jsize n = env->GetArrayLength(to);
+    LocatorPoint a;
+
+    if (!path_outputs_fit(env, n, km, azimuth)) return -1;
+    bool valid = read_locator(env, origin, a);
+    locator_path_blocks(env, valid ? &a : NULL, NULL, to, n, km, azimuth);
+    return (jint) n;
 }
@@ -0,0 +1,228 @@
+/*
+ This file is part of wsprd.
+
+ File name: callhash.c
+
+ Description: Memory-mapped, open-addressed callsign hash store.
+
+ Each 15-bit hash has at most one slot, found by linear probing from
+ slot (hash mod CALLHASH_SLOTS) over at most CALLHASH_PROBES slots.
+ Slots are never emptied, only overwritten, so a lookup may stop at the
+ first empty slot. When all probed slots hold other hashes the least
+ recently seen one is replaced. A slot's stamp is written after its
+ contents, so a store cut off mid-write holds at worst a stale call.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "callhash.h"
+#include "nhash.h"
+
+#define CALLHASH_MAGIC   0x48435357u   // "WSCH"
+#define CALLHASH_VERSION 1
+
+struct callhash_slot {
+    uint32_t seen;         // insertion stamp, 0 if the slot is empty
+    uint16_t ihash;
+    char call[14];
+};
+
+struct callhash_file {
+    uint32_t magic, version, nslots, count;
+    uint32_t clock;        // last stamp handed out
+    uint32_t reserved[3];
+    struct callhash_slot slots[CALLHASH_SLOTS];
+};
+
+struct callhash {
+    struct callhash_file *file;
+    int mapped;            // file is an mmap()ed file rather than malloc()ed
+    pthread_mutex_t lock;
+};
+
+static void callhash_init_file(struct callhash_file *f) {
+    memset(f, 0, sizeof(struct callhash_file));
+    f->magic = CALLHASH_MAGIC;
+    f->version = CALLHASH_VERSION;
+    f->nslots = CALLHASH_SLOTS;
+}
+
+struct callhash *callhash_open(const char *path) {
+    struct callhash *ch = calloc(1, sizeof(struct callhash));
+    struct stat st;
+    int fd;
+
+    if (ch == NULL) return NULL;
+    if (path == NULL) {
+        ch->file = malloc(sizeof(struct callhash_file));
+        if (ch->file == NULL) {
+            free(ch);
+            return NULL;
+        }
+        callhash_init_file(ch->file);
+    } else {
+        fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0 || fstat(fd, &st) != 0 ||
+            (st.st_size != sizeof(struct callhash_file) &&
+             ftruncate(fd, sizeof(struct callhash_file)) != 0)) {
+            if (fd >= 0) close(fd);
+            free(ch);
+            return NULL;
+        }
+        ch->file = mmap(NULL, sizeof(struct callhash_file), PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+        close(fd);
+        if (ch->file == MAP_FAILED) {
+            free(ch);
+            return NULL;
+        }
+        ch->mapped = 1;
+        if (ch->file->magic != CALLHASH_MAGIC || ch->file->version != CALLHASH_VERSION ||
+            ch->file->nslots != CALLHASH_SLOTS) {
+            callhash_init_file(ch->file);
+        }
+    }
+    pthread_mutex_init(&ch->lock, NULL);
+    return ch;
+}
+
+void callhash_close(struct callhash *ch) {
+    if (ch == NULL) return;
+    if (ch->mapped) {
+        msync(ch->file, sizeof(struct callhash_file), MS_ASYNC);
+        munmap(ch->file, sizeof(struct callhash_file));
+    } else {
+        free(ch->file);
+    }
+    pthread_mutex_destroy(&ch->lock);
+    free(ch);
+}
+
+/*
+ * Stores a call of len (1..CALLHASH_MAX_CALL) characters under ihash; the caller holds
+ * the lock. An existing call for ihash is overwritten only if replace is
+ * set. Returns 1 if the call was stored.
+ */
+static int callhash_put(struct callhash_file *f, int ihash, const char *callsign, size_t len,
+                        int replace) {
+    struct callhash_slot *s, *oldest = NULL;
+    int i;
+
+    for (i = 0; i < CALLHASH_PROBES; i++) {
+        s = &f->slots[(ihash + i) & (CALLHASH_SLOTS - 1)];
+        if (s->seen == 0) {
+            f->count++;
+            break;
+        }
+        if (s->ihash == ihash) {
+            if (!replace) return 0;
+            break;
+        }
+        if (oldest == NULL || s->seen < oldest->seen) oldest = s;
+    }
+    if (i == CALLHASH_PROBES) s = oldest;
+
+    s->seen = 0;
+    s->ihash = ihash;
+    memset(s->call, 0, sizeof(s->call));
+    memcpy(s->call, callsign, len);
+    s->seen = ++f->clock;
+    return 1;
+}
+
+void callhash_insert(struct callhash *ch, const char *callsign) {
+    size_t len = strlen(callsign);
+    int ihash;
+
+    if (len == 0 || len > CALLHASH_MAX_CALL) return;
+    ihash = nhash(callsign, len, (uint32_t) 146);
+
+    pthread_mutex_lock(&ch->lock);
+    callhash_put(ch->file, ihash, callsign, len, 1);
+    pthread_mutex_unlock(&ch->lock);
+}
+
+void callhash_hash_batch(const char *const *calls, int n, int *hashes) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        hashes[i] = calls[i] != NULL ? (int) nhash(calls[i], strlen(calls[i]), (uint32_t) 146) : -1;
+    }
+}
+
+int callhash_preload(struct callhash *ch, const char *const *calls, int n) {
+    char upper[256][CALLHASH_MAX_CALL + 1];
+    const char *ptrs[256];
+    int hashes[256];
+    int i, j, k, m, added = 0;
+    size_t len;
+
+    /*
+     * Type 3 messages carry the hash of the uppercase call, so calls are
+     * uppercased first (log exports are often lowercase). Hashing happens
+     * outside the lock, a chunk at a time, then the chunk is stored in one go.
+     */
+    for (i = 0; i < n; i += m) {
+        m = n - i < 256 ? n - i : 256;
+        for (j = 0; j < m; j++) {
+            ptrs[j] = NULL;
+            if (calls[i + j] == NULL) continue;
+            len = strlen(calls[i + j]);
+            if (len == 0 || len > CALLHASH_MAX_CALL) continue;
+            for (k = 0; k <= (int) len; k++) upper[j][k] = (char) toupper((unsigned char) calls[i + j][k]);
+            ptrs[j] = upper[j];
+        }
+        callhash_hash_batch(ptrs, m, hashes);
+        pthread_mutex_lock(&ch->lock);
+        for (j = 0; j < m; j++) {
+            if (ptrs[j] != NULL) added += callhash_put(ch->file, hashes[j], ptrs[j], strlen(ptrs[j]), 0);
+        }
+        pthread_mutex_unlock(&ch->lock);
+    }
+    return added;
+}
+
+int callhash_lookup(struct callhash *ch, int ihash, char *callsign) {
+    struct callhash_slot *s;
+    int i, found = 0;
+
+    pthread_mutex_lock(&ch->lock);
+    for (i = 0; i < CALLHASH_PROBES; i++) {
+        s = &ch->file->slots[(ihash + i) & (CALLHASH_SLOTS - 1)];
+        if (s->seen == 0) break;
+        if (s->ihash == ihash) {
+            if (strnlen(s->call, sizeof(s->call)) > CALLHASH_MAX_CALL) break;
+            memcpy(callsign, s->call, 13);
+            callsign[12] = 0;
+            found = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ch->lock);
+    return found;
+}
+
+int callhash_fill(struct callhash *ch, char *hashtab) {
+    struct callhash_slot *s;
+    int i, n = 0;
+
+    pthread_mutex_lock(&ch->lock);
+    for (i = 0; i < CALLHASH_SLOTS; i++) {
+        s = &ch->file->slots[i];
+        if (s->seen == 0 || s->ihash > 32767) continue;
+        // Longer calls, from a store written before the limit, would not fit "<CALL>"
+        if (strnlen(s->call, sizeof(s->call)) > CALLHASH_MAX_CALL) continue;
+        memcpy(hashtab + s->ihash * 13, s->call, 13);
+        hashtab[s->ihash * 13 + 12] = 0;
+        n++;
+    }
+    pthread_mutex_unlock(&ch->lock);
+    return n;
+}
@@ -0,0 +1,61 @@
+/*
+ This file is part of wsprd.
+
+ File name: callhash.h
+
+ Description: Persistent store of the callsigns behind WSPR's 15-bit
+ callsign hashes, so that Type 3 messages (<CALL> GRID6 PWR) resolve
+ with calls heard in earlier decodes. The store is a small open-addressed
+ table in a memory-mapped file: opening it costs no parsing and every
+ insertion is saved as it happens.
+ */
+
+#ifndef CALLHASH_H
+#define CALLHASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CALLHASH_SLOTS  4096   // table size, a power of two
+#define CALLHASH_PROBES 16     // slots searched per hash; the oldest is replaced when full
+#define CALLHASH_MAX_CALL 10   // longest call stored, so "<CALL>" fits a 13-byte wsprd callsign
+
+struct callhash;
+
+/*
+ * Opens (creating if needed) the store in the file at path, or an
+ * in-memory store that lasts until callhash_close() if path is NULL.
+ * A file that is not a valid store is reinitialized. Returns NULL if
+ * the file cannot be opened or mapped.
+ */
+struct callhash *callhash_open(const char *path);
+void callhash_close(struct callhash *ch);
+
+// Records callsign under nhash(callsign); a newer call replaces an older one.
+// Calls longer than CALLHASH_MAX_CALL are not stored, here or by callhash_preload().
+void callhash_insert(struct callhash *ch, const char *callsign);
+
+/*
+ * Adds n callsigns known from elsewhere (a spot list, a log), so their
+ * Type 3 messages resolve before they are heard as Type 1. A call already
+ * stored under the same hash is kept, since it was heard on the air.
+ * Calls are stored uppercase, as they are hashed when sent.
+ * Returns the number of calls added.
+ */
+int callhash_preload(struct callhash *ch, const char *const *calls, int n);
+
+// hashes[i] = nhash(calls[i], strlen(calls[i]), 146) for i < n
+void callhash_hash_batch(const char *const *calls, int n, int *hashes);
+
+// Copies the call stored for ihash into callsign[13]; returns 0 if none.
+int callhash_lookup(struct callhash *ch, int ihash, char *callsign);
+
+// Copies every stored call into a 32768 x 13 wsprd hash table; returns their number.
+int callhash_fill(struct callhash *ch, char *hashtab);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
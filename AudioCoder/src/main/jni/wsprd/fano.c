@@ -14,11 +14,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 #include "fano.h"
 
 struct node {
-  unsigned long encstate;	// Encoder state of next node
-  long gamma;		        // Cumulative metric to this node
+  uint32_t encstate;		// Encoder state of next node
+  int gamma;		        // Cumulative metric to this node
   int metrics[4];		// Metrics indexed by all possible tx syms
   int tm[2];		        // Sorted metrics for current hypotheses
   int i;			// Current branch being tested
@@ -81,6 +82,48 @@ int encode(
   return 0;
 }
 
+/* Branch symbol pair for an encoder state, as ENCODE() but with the
+ * parity computed by the compiler builtin (a single instruction on
+ * most targets) instead of the Partab lookup.
+ */
+static inline unsigned int branch_symbols(uint32_t encstate)
+{
+  return (__builtin_parity(encstate & POLY1) << 1) | __builtin_parity(encstate & POLY2);
+}
+
+/* Node storage for decoding packets of up to nbits bits, so that
+ * repeated decodes do not allocate.
+ */
+struct fano_arena *fano_arena_alloc(unsigned int nbits)
+{
+  struct fano_arena *arena;
+
+  if((arena = (struct fano_arena *)calloc(1,sizeof(struct fano_arena))) == NULL)
+    return NULL;
+  if((arena->nodes = (struct node *)malloc((nbits+1)*sizeof(struct node))) == NULL) {
+    free(arena);
+    return NULL;
+  }
+  arena->maxbits = nbits;
+  return arena;
+}
+
+void fano_arena_free(struct fano_arena *arena)
+{
+  if(arena == NULL)
+    return;
+  free(arena->nodes);
+  free(arena);
+}
+
+/* Memory held by an arena, 0 for NULL */
+unsigned long fano_arena_bytes(const struct fano_arena *arena)
+{
+  if(arena == NULL)
+    return 0;
+  return sizeof(struct fano_arena) + (arena->maxbits+1)*sizeof(struct node);
+}
+
 /* Decode packet with the Fano algorithm.
  * Return 0 on success, -1 on timeout
  */
@@ -91,7 +134,35 @@ int fano(
 	 unsigned char *data,	   // Decoded output data
 	 unsigned char *symbols,   // Raw deinterleaved input symbols
 	 unsigned int nbits,	   // Number of output bits
-	 int mettab[2][256],	   // Metric table, [sent sym][rx symbol]
+	 const int mettab[2][256],	   // Metric table, [sent sym][rx symbol]
+	 int delta,		   // Threshold adjust parameter
+	 unsigned int maxcycles)   // Decoding timeout in cycles per bit
+{
+  struct fano_arena *arena;
+  int result;
+
+  if((arena = fano_arena_alloc(nbits)) == NULL) {
+    printf("malloc failed\n");
+    return 0;
+  }
+  result = fano_arena_decode(arena,metric,cycles,maxnp,data,symbols,nbits,
+			     mettab,delta,maxcycles);
+  fano_arena_free(arena);
+  return result;
+}
+
+/* As fano(), with the nodes taken from an arena of at least nbits bits.
+ * The arena also accumulates call and cycle counts for profiling.
+ */
+int fano_arena_decode(
+	 struct fano_arena *arena, // Node storage
+	 unsigned int  *metric,	   // Final path metric (returned value)
+	 unsigned int  *cycles,	   // Cycle count (returned value)
+	 unsigned int  *maxnp,     // Progress before timeout (returned value)
+	 unsigned char *data,	   // Decoded output data
+	 unsigned char *symbols,   // Raw deinterleaved input symbols
+	 unsigned int nbits,	   // Number of output bits
+	 const int mettab[2][256],	   // Metric table, [sent sym][rx symbol]
 	 int delta,		   // Threshold adjust parameter
 	 unsigned int maxcycles)   // Decoding timeout in cycles per bit
 {
@@ -105,10 +176,9 @@ int fano(
   unsigned int lsym;
   unsigned int i;
 
-  if((nodes = (struct node *)malloc((nbits+1)*sizeof(struct node))) == NULL) {
-    printf("malloc failed\n");
-    return 0;
-  }
+  if(nbits > arena->maxbits)
+    return -1;
+  nodes = arena->nodes;
   lastnode = &nodes[nbits-1];
   tail = &nodes[nbits-31];
   *maxnp = 0;
@@ -127,7 +197,7 @@ int fano(
   np->encstate = 0;
 
 // Compute and sort branch metrics from root node */
-  ENCODE(lsym,np->encstate);	// 0-branch (LSB is 0)
+  lsym = branch_symbols(np->encstate);	// 0-branch (LSB is 0)
   m0 = np->metrics[lsym];
 
 /* Now do the 1-branch. To save another ENCODE call here and
@@ -152,9 +222,14 @@ int fano(
 
   // Start the Fano decoder
   for(i=1;i <= maxcycles;i++) {
+    if((i & 255) == 0 && arena->cancel != NULL &&
+       __atomic_load_n(arena->cancel,__ATOMIC_RELAXED)) {
+      i = maxcycles;                          // Cancelled: report a timeout
+      break;
+    }
     if((int)(np-nodes) > (int)*maxnp) *maxnp=(int)(np-nodes);
 #ifdef	debug
-    printf("k=%ld, g=%ld, t=%d, m[%d]=%d, maxnp=%d, encstate=%lx\n",
+    printf("k=%ld, g=%d, t=%d, m[%d]=%d, maxnp=%d, encstate=%x\n",
 	   np-nodes,np->gamma,t,np->i,np->tm[np->i],*maxnp,np->encstate);
 #endif
 // Look forward */
@@ -179,7 +254,7 @@ int fano(
       /* Compute and sort metrics, starting with the 
        * zero branch
        */
-      ENCODE(lsym,np->encstate);
+      lsym = branch_symbols(np->encstate);
       if(np >= tail) {
 	/* The tail must be all zeroes, so don't 
 	 * bother computing the 1-branches here.
@@ -232,8 +307,9 @@ int fano(
     np += 8;
   }
   *cycles = i+1;
+  arena->ncalls++;
+  arena->cycles += i+1;
 
-  free(nodes);
   if(i >= maxcycles) return -1;	          // Decoder timed out
   return 0;		                  // Successful completion
 }
@@ -14,7 +14,28 @@
 
 int fano(unsigned int *metric, unsigned int *cycles, unsigned int *maxnp,
 	unsigned char *data,unsigned char *symbols, unsigned int nbits,
-	 int mettab[2][256],int delta,unsigned int maxcycles);
+	 const int mettab[2][256],int delta,unsigned int maxcycles);
+
+/* Caller-owned node storage for fano_arena_decode(). The counters
+ * are summed over every decode made with the arena.
+ */
+struct fano_arena {
+  struct node *nodes;		// maxbits+1 nodes
+  unsigned int maxbits;
+  unsigned long ncalls;		// Decodes attempted
+  unsigned long long cycles;	// Decoder cycles spent
+  const int *cancel;		// If set, decoding gives up (as a timeout)
+				// soon after *cancel becomes nonzero
+};
+
+struct fano_arena *fano_arena_alloc(unsigned int nbits);
+void fano_arena_free(struct fano_arena *arena);
+unsigned long fano_arena_bytes(const struct fano_arena *arena);
+
+int fano_arena_decode(struct fano_arena *arena,
+	unsigned int *metric, unsigned int *cycles, unsigned int *maxnp,
+	unsigned char *data,unsigned char *symbols, unsigned int nbits,
+	 const int mettab[2][256],int delta,unsigned int maxcycles);
 
 int encode(unsigned char *symbols,unsigned char *data,unsigned int nbytes);
 
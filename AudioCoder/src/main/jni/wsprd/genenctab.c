@@ -0,0 +1,65 @@
+/*
+ This file is part of wsprd.
+
+ File name: genenctab.c
+
+ Description: Writes wspr_encode_tab.c, the tables with which
+ wspr_encode_data() runs the convolutional code a byte at a time.
+
+ The code is linear, so the 16 output bits for the next 8 input bits
+ are the XOR of the output due to each byte of the 32-bit encoder state
+ and that due to the new input byte. Each table holds one of those
+ contributions; bit 15 - 2j is the POLY1 output after input bit j and
+ bit 14 - 2j the POLY2 output.
+
+ Usage: genenctab > wspr_encode_tab.c
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define POLY1 0xf2d05351
+#define POLY2 0xe4613c47
+
+// Output bits of the 8 steps shifting input, MSB first, into an encoder holding state
+static unsigned int output_bits(uint32_t state, unsigned int input) {
+    unsigned int bits = 0, j;
+    uint32_t reg;
+
+    for (j = 0; j < 8; j++) {
+        reg = (state << (j + 1)) | (input >> (7 - j));
+        bits |= __builtin_parity(reg & POLY1) << (15 - 2 * j);
+        bits |= __builtin_parity(reg & POLY2) << (14 - 2 * j);
+    }
+    return bits;
+}
+
+static void print_table(const char *indent, unsigned int k, int input) {
+    unsigned int v;
+
+    printf("%s{", indent);
+    for (v = 0; v < 256; v++) {
+        printf("%s0x%04x%s", v % 8 ? " " : "\n    ",
+               input ? output_bits(0, v) : output_bits((uint32_t) v << (8 * k), 0),
+               v < 255 ? "," : "");
+    }
+    printf("}");
+}
+
+int main(void) {
+    unsigned int k;
+
+    printf("/*\n This file is part of wsprd.\n\n File name: wspr_encode_tab.c\n\n");
+    printf(" Description: Byte-wise tables of the WSPR convolutional code.\n");
+    printf(" Generated by genenctab; do not edit.\n*/\n\n");
+    printf("#include \"wspr_encode.h\"\n\n");
+    printf("const uint16_t wspr_encode_state_tab[4][256] = {\n");
+    for (k = 0; k < 4; k++) {
+        print_table("", k, 0);
+        printf("%s\n", k < 3 ? "," : "");
+    }
+    printf("};\n\nconst uint16_t wspr_encode_input_tab[256] = ");
+    print_table("", 0, 1);
+    printf(";\n");
+    return 0;
+}
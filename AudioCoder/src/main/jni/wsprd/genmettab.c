@@ -0,0 +1,36 @@
+/*
+ This file is part of wsprd.
+
+ File name: genmettab.c
+
+ Description: Writes metric_default.c, the metric table for the default
+ Fano bias, so the decoder does not rebuild it at run time. Uses the same
+ rounding as metric_table() in metric_cache.c.
+
+ Usage: genmettab > metric_default.c
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "metric_cache.h"
+#include "metric_tables.c"
+
+int main(void) {
+    int i, j, v;
+
+    printf("/*\n This file is part of wsprd.\n\n File name: metric_default.c\n\n");
+    printf(" Description: Fano/Jelinek metric table for bias %.2f.\n", WSPRD_DEFAULT_BIAS);
+    printf(" Generated by genmettab from metric_tables.c; do not edit.\n*/\n\n");
+    printf("#include \"metric_cache.h\"\n\n");
+    printf("const int wsprd_default_mettab[2][256] = {\n");
+    for (j = 0; j < 2; j++) {
+        printf("    {");
+        for (i = 0; i < 256; i++) {
+            v = round(10 * (metric_tables[2][j ? 255 - i : i] - WSPRD_DEFAULT_BIAS));
+            printf("%s%4d%s", i % 16 ? "" : "\n     ", v, i < 255 ? "," : "");
+        }
+        printf("}%s\n", j ? "" : ",");
+    }
+    printf("};\n");
+    return 0;
+}
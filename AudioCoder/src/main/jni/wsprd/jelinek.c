@@ -24,8 +24,43 @@
 #define	POLY1	0xf2d05351
 #define	POLY2	0xe4613c47
 
+#define NBUCKETS 1000
+
 struct snode *stack;
 
+struct jelinek_workspace *jelinek_workspace_alloc(unsigned int stacksize)
+{
+    struct jelinek_workspace *ws;
+
+    ws = calloc(1, sizeof(struct jelinek_workspace));
+    if (ws == NULL) return NULL;
+    ws->stack = calloc(stacksize, sizeof(struct snode));
+    ws->buckets = calloc(NBUCKETS, sizeof(unsigned int));
+    if (ws->stack == NULL || ws->buckets == NULL) {
+        jelinek_workspace_free(ws);
+        return NULL;
+    }
+    ws->stacksize = stacksize;
+    ws->nbuckets = NBUCKETS;
+    ws->owns_stack = 1;
+    return ws;
+}
+
+void jelinek_workspace_free(struct jelinek_workspace *ws)
+{
+    if (ws == NULL) return;
+    if (ws->owns_stack) free(ws->stack);
+    free(ws->buckets);
+    free(ws);
+}
+
+unsigned long jelinek_workspace_bytes(const struct jelinek_workspace *ws)
+{
+    if (ws == NULL) return 0;
+    return sizeof(*ws) + ws->nbuckets * sizeof(unsigned int) +
+           (ws->owns_stack ? ws->stacksize * sizeof(struct snode) : 0);
+}
+
 //Decoder - returns 0 on success, -1 on timeout
 int jelinek(
             unsigned int *metric,	/* Final path metric (returned value) */
@@ -35,9 +70,42 @@ int jelinek(
             unsigned int nbits,	/* Number of output bits */
             unsigned int stacksize,
             struct snode *stack,
-            int mettab[2][256],	/* Metric table, [sent sym][rx symbol] */
+            const int mettab[2][256],	/* Metric table, [sent sym][rx symbol] */
             unsigned int maxcycles)/* Decoding timeout in cycles per bit */
 {
+    struct jelinek_workspace ws;
+    unsigned int buckets[NBUCKETS];
+    int result;
+
+    memset(&ws, 0, sizeof(ws));
+    memset(buckets, 0, sizeof(buckets));
+    ws.stack = stack;
+    ws.stacksize = stacksize;
+    ws.buckets = buckets;
+    ws.nbuckets = NBUCKETS;
+    ws.touched = stacksize;     // caller's stack: contents unknown
+    result = jelinek_decode(&ws, metric, cycles, data, symbols, nbits, mettab, maxcycles);
+    return result;
+}
+
+/*
+ * As jelinek(), with the stack and bucket index taken from a workspace.
+ * Stack entries are always written before they are read, but the part
+ * the previous decode touched is cleared so the stack starts out zeroed
+ * as before; the buckets it used are emptied on the way out.
+ */
+int jelinek_decode(
+            struct jelinek_workspace *ws,
+            unsigned int *metric,	/* Final path metric (returned value) */
+            unsigned int *cycles,	/* Cycle count (returned value) */
+            unsigned char *data,	/* Decoded output data */
+            unsigned char *symbols,	/* Raw deinterleaved input symbols */
+            unsigned int nbits,	/* Number of output bits */
+            const int mettab[2][256],	/* Metric table, [sent sym][rx symbol] */
+            unsigned int maxcycles)/* Decoding timeout in cycles per bit */
+{
+    struct snode *stack = ws->stack;
+    unsigned int stacksize = ws->stacksize;
     
     // Compute branch metrics for each symbol pair
     // The sequential decoding algorithm only uses the metrics, not the
@@ -52,18 +120,17 @@ int jelinek(
         symbols += 2;
     }
     
-    // zero the stack
-    memset(stack,0,stacksize*sizeof(struct snode));
+    // zero the part of the stack the last decode used
+    memset(stack,0,ws->touched*sizeof(struct snode));
     
     // initialize the loop variables
     unsigned int lsym, ntail=31;
     uint64_t encstate=0;
-    unsigned int nbuckets=1000;
+    unsigned int nbuckets=ws->nbuckets;
     unsigned int low_bucket=nbuckets-1; //will be set on first run-through
     unsigned int high_bucket=0;
-    unsigned int *buckets, bucket;
-    buckets=malloc(nbuckets*sizeof(unsigned int));
-    memset(buckets,0,nbuckets*sizeof(unsigned int));
+    unsigned int *buckets=ws->buckets, bucket;
+    unsigned int min_bucket=nbuckets-1, max_bucket=0; // range to empty when done
     unsigned int ptr=1;
     unsigned int stackptr=1; //pointer values of 0 are reserved (they mean that a bucket is empty)
     unsigned int depth=0, nbits_minus_ntail=nbits-ntail;
@@ -73,6 +140,11 @@ int jelinek(
     unsigned int ncycles=maxcycles*nbits;
     /********************* Start the stack decoder *****************/
     for (i=1; i <= ncycles; i++) {
+        if( (i & 255) == 0 && ws->cancel != NULL &&
+            __atomic_load_n(ws->cancel, __ATOMIC_RELAXED) ) {
+            i = ncycles;                // cancelled: report a timeout
+            break;
+        }
 #ifdef DEBUG
         printf("***stackptr=%ld, depth=%d, gamma=%d, encstate=%lx, bucket %d, low_bucket %d, high_bucket %d\n",
                stackptr, depth, gamma, encstate, bucket, low_bucket, high_bucket);
@@ -93,6 +165,7 @@ int jelinek(
         depth++; //the depth of the daughter nodes
 
         bucket=(totmet0>>5)+200; //fast, but not particularly safe - totmet can be negative
+        if( bucket >= nbuckets ) bucket = totmet0 < 0 ? 0 : nbuckets-1;
         if( bucket > high_bucket ) high_bucket=bucket;
         if( bucket < low_bucket ) low_bucket=bucket;
        
@@ -102,6 +175,8 @@ int jelinek(
         stack[ptr].depth=depth;
         stack[ptr].jpointer=buckets[bucket];
         buckets[bucket]=ptr;
+        if( bucket > max_bucket ) max_bucket=bucket;
+        if( bucket < min_bucket ) min_bucket=bucket;
         
         // if in the tail, only need to evaluate the "0" branch.
         // Otherwise, enter this "if" and place the 1 node on the stack,
@@ -118,6 +193,7 @@ int jelinek(
             }
 
             bucket=(totmet1>>5)+200; //this may not be safe on all compilers
+            if( bucket >= nbuckets ) bucket = totmet1 < 0 ? 0 : nbuckets-1;
             if( bucket > high_bucket ) high_bucket=bucket;
             if( bucket < low_bucket ) low_bucket=bucket;
             
@@ -126,6 +202,8 @@ int jelinek(
             stack[ptr].depth=depth;
             stack[ptr].jpointer=buckets[bucket];
             buckets[bucket]=ptr;
+            if( bucket > max_bucket ) max_bucket=bucket;
+            if( bucket < min_bucket ) min_bucket=bucket;
         }
 
     // pick off the latest entry from the high bucket
@@ -147,6 +225,13 @@ int jelinek(
     *cycles = i+1;
     *metric =  gamma;	/* Return final path metric */
 
+    // leave the bucket index empty for the next decode
+    if( min_bucket <= max_bucket )
+        memset(buckets+min_bucket,0,(max_bucket-min_bucket+1)*sizeof(unsigned int));
+    ws->touched = stackptr+1;
+    ws->ncalls++;
+    ws->cycles += *cycles;
+
     //    printf("cycles %d stackptr=%d, depth=%d, gamma=%d, encstate=%lx\n",
     //           *cycles, stackptr, depth, *metric, encstate);
     
@@ -19,8 +19,38 @@ int jelinek(unsigned int *metric,
             unsigned int nbits,
             unsigned int stacksize,
             struct snode *stack,
-            int mettab[2][256],
+            const int mettab[2][256],
             unsigned int maxcycles);
 
+/*
+ * Stack and bucket index kept between decodes, so a decode neither
+ * allocates nor clears more than the previous one touched.
+ */
+struct jelinek_workspace {
+    struct snode *stack;
+    unsigned int stacksize;
+    unsigned int *buckets;            // bucket heads, all 0 between decodes
+    unsigned int nbuckets;
+    unsigned int touched;             // stack entries used by the last decode
+    int owns_stack;
+    unsigned long ncalls;             // Decodes attempted
+    unsigned long long cycles;        // Decoder cycles spent
+    const int *cancel;                // If set, decoding gives up (as a timeout)
+                                      // soon after *cancel becomes nonzero
+};
+
+struct jelinek_workspace *jelinek_workspace_alloc(unsigned int stacksize);
+void jelinek_workspace_free(struct jelinek_workspace *ws);
+unsigned long jelinek_workspace_bytes(const struct jelinek_workspace *ws);  // 0 for NULL
+
+int jelinek_decode(struct jelinek_workspace *ws,
+                   unsigned int *metric,
+                   unsigned int *cycles,
+                   unsigned char *data,
+                   unsigned char *symbols,
+                   unsigned int nbits,
+                   const int mettab[2][256],
+                   unsigned int maxcycles);
+
 #endif
 
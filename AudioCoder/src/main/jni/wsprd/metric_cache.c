@@ -0,0 +1,46 @@
+/*
+ This file is part of wsprd.
+
+ File name: metric_cache.c
+
+ Description: Per-bias cache of the integer Fano/Jelinek metric tables.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "metric_cache.h"
+#include "metric_tables.c"
+
+struct metric_entry {
+    float bias;
+    int mettab[2][256];
+    struct metric_entry *next;
+};
+
+// Entries are never freed: tables handed out may be in use by any decoder
+static struct metric_entry *metric_entries = NULL;
+static pthread_mutex_t metric_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const int (*metric_table(float bias))[256] {
+    struct metric_entry *e;
+    int i;
+
+    if (bias == WSPRD_DEFAULT_BIAS) return wsprd_default_mettab;
+
+    pthread_mutex_lock(&metric_lock);
+    for (e = metric_entries; e != NULL; e = e->next) {
+        if (e->bias == bias) break;
+    }
+    if (e == NULL && (e = malloc(sizeof(struct metric_entry))) != NULL) {
+        e->bias = bias;
+        for (i = 0; i < 256; i++) {
+            e->mettab[0][i] = round(10 * (metric_tables[2][i] - bias));
+            e->mettab[1][i] = round(10 * (metric_tables[2][255 - i] - bias));
+        }
+        e->next = metric_entries;
+        metric_entries = e;
+    }
+    pthread_mutex_unlock(&metric_lock);
+    return e != NULL ? (const int (*)[256]) e->mettab : wsprd_default_mettab;
+}
@@ -0,0 +1,26 @@
+/*
+ This file is part of wsprd.
+
+ File name: metric_cache.h
+
+ Description: Integer metric tables for the Fano and Jelinek decoders,
+ mettab[sent bit][received symbol] = round(10 * (metric - bias)), shared
+ read-only by every decoder instance.
+ */
+
+#ifndef METRIC_CACHE_H
+#define METRIC_CACHE_H
+
+#define WSPRD_DEFAULT_BIAS 0.45f   // Fano metric bias used unless -z is given
+
+// Generated from metric_tables.c by genmettab for WSPRD_DEFAULT_BIAS
+extern const int wsprd_default_mettab[2][256];
+
+/*
+ * Table for the given bias. The default table is returned directly;
+ * any other bias is built on first use and kept for the life of the
+ * process. Safe to call from several threads.
+ */
+const int (*metric_table(float bias))[256];
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ This file is part of wsprd.
+
+ File name: metric_default.c
+
+ Description: Fano/Jelinek metric table for bias 0.45.
+ Generated by genmettab from metric_tables.c; do not edit.
+*/
+
+#include "metric_cache.h"
+
+const int wsprd_default_mettab[2][256] = {
+    {
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   4,   4,   4,   4,   4,   4,
+        4,   4,   4,   4,   3,   3,   3,   3,   3,   3,   3,   2,   2,   2,   2,   1,
+        1,   1,   1,   0,   0,   0,  -1,  -1,  -1,  -2,  -2,  -3,  -3,  -4,  -4,  -5,
+       -5,  -6,  -6,  -7,  -7,  -8,  -9,  -9, -10, -10, -11, -12, -13, -13, -14, -15,
+      -16, -16, -17, -18, -19, -20, -20, -21, -22, -23, -24, -25, -26, -27, -28, -28,
+      -29, -30, -31, -32, -33, -34, -35, -36, -37, -38, -39, -40, -41, -42, -43, -44,
+      -45, -46, -47, -48, -49, -50, -51, -52, -53, -54, -55, -56, -57, -58, -59, -60,
+      -61, -62, -63, -64, -65, -66, -67, -68, -69, -70, -71, -72, -73, -74, -75, -76,
+      -77, -78, -79, -80, -81, -83, -83, -84, -86, -87, -87, -89, -90, -91, -92, -93,
+      -94, -95, -96, -97, -97, -99,-100,-101,-102,-103,-104,-105,-106,-108,-107,-110,
+     -110,-112,-112,-114,-115,-115,-116,-117,-118,-119,-120,-121,-124,-123,-126,-137},
+    {
+     -137,-126,-123,-124,-121,-120,-119,-118,-117,-116,-115,-115,-114,-112,-112,-110,
+     -110,-107,-108,-106,-105,-104,-103,-102,-101,-100, -99, -97, -97, -96, -95, -94,
+      -93, -92, -91, -90, -89, -87, -87, -86, -84, -83, -83, -81, -80, -79, -78, -77,
+      -76, -75, -74, -73, -72, -71, -70, -69, -68, -67, -66, -65, -64, -63, -62, -61,
+      -60, -59, -58, -57, -56, -55, -54, -53, -52, -51, -50, -49, -48, -47, -46, -45,
+      -44, -43, -42, -41, -40, -39, -38, -37, -36, -35, -34, -33, -32, -31, -30, -29,
+      -28, -28, -27, -26, -25, -24, -23, -22, -21, -20, -20, -19, -18, -17, -16, -16,
+      -15, -14, -13, -13, -12, -11, -10, -10,  -9,  -9,  -8,  -7,  -7,  -6,  -6,  -5,
+       -5,  -4,  -4,  -3,  -3,  -2,  -2,  -1,  -1,  -1,   0,   0,   0,   1,   1,   1,
+        1,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,
+        4,   4,   4,   4,   4,   4,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5}
+};
@@ -4,7 +4,7 @@
 * should be normalized to have rms amplitude equal to "symbol_scale".
 ********************************************************************************/
 //float symbol_scale[5]={42.6, 53.3, 72.7, 100.2, 125.4};
-float metric_tables[5][256]={
+static const float metric_tables[5][256]={
     {0.9782,      0.9695,      0.9689,      0.9669,      0.9666,      0.9653,      0.9638,      0.9618,      0.9599,      0.9601, 
      0.9592,      0.9570,      0.9556,      0.9540,      0.9525,      0.9527,      0.9486,      0.9477,      0.9450,      0.9436, 
      0.9424,      0.9400,      0.9381,      0.9360,      0.9340,      0.9316,      0.9301,      0.9272,      0.9254,      0.9224, 
@@ -0,0 +1,389 @@
+/*
+ This file is part of wsprd.
+
+ File name: osdwspr.c
+
+ Description: Ordered-statistics decoder for the K=32, r=1/2 WSPR
+ convolutional code, ported from osdwspr.f90 (Steven Franke, K9AN).
+
+ The 50x162 generator matrix is kept one 64-bit word per column, so a
+ Gaussian elimination row operation touches one word per column, and
+ the reduced matrix is kept one 162-bit (3-word) vector per row, so
+ re-encoding a test pattern is a handful of word XORs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "osdwspr.h"
+
+#define OSD_N  162          // code symbols
+#define OSD_K  50           // message bits
+#define OSD_NW 3            // 64-bit words per codeword
+
+typedef struct {
+    uint64_t w[OSD_NW];
+} osd_vec;
+
+// First row of the generator matrix: interleaved taps of the two polynomials
+static const unsigned char gg[64] = {
+        1, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 0, 1, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 0, 0, 0,
+        0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1};
+
+static inline int vec_bit(const osd_vec *v, int i) {
+    return (int) ((v->w[i >> 6] >> (i & 63)) & 1);
+}
+
+static inline void vec_set(osd_vec *v, int i) {
+    v->w[i >> 6] |= (uint64_t) 1 << (i & 63);
+}
+
+// Mask of positions [lo, hi)
+static osd_vec vec_range(int lo, int hi) {
+    osd_vec m;
+    int i;
+    memset(&m, 0, sizeof(m));
+    for (i = lo; i < hi; i++) vec_set(&m, i);
+    return m;
+}
+
+static inline int vec_weight(const osd_vec *v) {
+    return __builtin_popcountll(v->w[0]) + __builtin_popcountll(v->w[1]) +
+           __builtin_popcountll(v->w[2]);
+}
+
+// Sum of w[i] over the set positions of v
+static float vec_dist(const osd_vec *v, const float *w) {
+    float d = 0.0;
+    int k;
+    for (k = 0; k < OSD_NW; k++) {
+        uint64_t x = v->w[k];
+        while (x) {
+            d += w[64 * k + __builtin_ctzll(x)];
+            x &= x - 1;
+        }
+    }
+    return d;
+}
+
+// Codeword of a message pattern (bit i of m = message bit i)
+static osd_vec mrbencode(uint64_t m, const osd_vec *g2) {
+    osd_vec c;
+    memset(&c, 0, sizeof(c));
+    while (m) {
+        const osd_vec *r = &g2[__builtin_ctzll(m)];
+        c.w[0] ^= r->w[0];
+        c.w[1] ^= r->w[1];
+        c.w[2] ^= r->w[2];
+        m &= m - 1;
+    }
+    return c;
+}
+
+static inline osd_vec vec_xor(const osd_vec *a, const osd_vec *b) {
+    osd_vec c;
+    c.w[0] = a->w[0] ^ b->w[0];
+    c.w[1] = a->w[1] ^ b->w[1];
+    c.w[2] = a->w[2] ^ b->w[2];
+    return c;
+}
+
+static inline osd_vec vec_and(const osd_vec *a, const osd_vec *b) {
+    osd_vec c;
+    c.w[0] = a->w[0] & b->w[0];
+    c.w[1] = a->w[1] & b->w[1];
+    c.w[2] = a->w[2] & b->w[2];
+    return c;
+}
+
+/*
+ * Next test error pattern of the same weight (nextpat in the Fortran).
+ * Returns the lowest set position of the new pattern, or -1 when the
+ * last pattern of weight iorder has been generated.
+ */
+static int nextpat(uint64_t *mi, int k, int iorder) {
+    int i, ind = -1;
+    uint64_t ms;
+
+    for (i = 0; i < k - 1; i++) {
+        if (!((*mi >> i) & 1) && ((*mi >> (i + 1)) & 1)) ind = i;
+    }
+    if (ind < 0) return -1;
+
+    ms = *mi & (((uint64_t) 1 << ind) - 1);
+    ms |= (uint64_t) 1 << ind;
+    if (ind + 2 < k) {
+        int nz = iorder - __builtin_popcountll(ms);
+        for (i = k - nz; i < k; i++) ms |= (uint64_t) 1 << i;
+    }
+    *mi = ms;
+    return __builtin_ctzll(ms);
+}
+
+struct osd_sortkey {
+    float a;
+    int i;
+};
+
+// Decreasing reliability; ties keep received order
+static int osd_keycomp(const void *p1, const void *p2) {
+    const struct osd_sortkey *a = p1, *b = p2;
+    if (a->a > b->a) return -1;
+    if (a->a < b->a) return 1;
+    return a->i - b->i;
+}
+
+/*
+ * Pairs of message positions bucketed by the XOR of their first ntau
+ * parity bits (boxit/fetchit in the Fortran). Lists keep insertion order.
+ */
+struct osd_boxes {
+    int *head;                       // 1 << ntau
+    int *tail;                       // 1 << ntau
+    int next[OSD_K * (OSD_K - 1) / 2];
+    int pair[OSD_K * (OSD_K - 1) / 2][2];
+};
+
+static unsigned int tau_pattern(const osd_vec *v, int ntau) {
+    // Parity positions K..K+ntau-1 all lie in the first two words
+    uint64_t lo = v->w[0] >> OSD_K | v->w[1] << (64 - OSD_K);
+    return (unsigned int) (lo & (((uint64_t) 1 << ntau) - 1));
+}
+
+void osdwspr(const float *ss, const unsigned char *apmask, int ndeep,
+             unsigned char *cw, int *nhardmin, float *dmin) {
+    uint64_t col[OSD_N];             // generator column c, bit i = row i
+    osd_vec g2[OSD_K];               // reduced generator rows
+    int indices[OSD_N];
+    float absrx[OSD_N];
+    struct osd_sortkey key[OSD_N];
+    osd_vec hdec, c0, best;
+    uint64_t m0 = 0, apm = 0;
+    int i, j;
+
+    // Columns of the generator matrix in received order
+    memset(col, 0, sizeof(col));
+    for (i = 0; i < OSD_K; i++) {
+        for (j = 0; j < 64 && 2 * i + j < OSD_N; j++) {
+            if (gg[j]) col[2 * i + j] |= (uint64_t) 1 << i;
+        }
+    }
+
+    // Order the symbols by decreasing reliability
+    for (i = 0; i < OSD_N; i++) {
+        key[i].a = fabsf(ss[i] / 127.0f);
+        key[i].i = i;
+    }
+    qsort(key, OSD_N, sizeof(key[0]), osd_keycomp);
+
+    uint64_t colmrb[OSD_N];
+    for (i = 0; i < OSD_N; i++) {
+        indices[i] = key[i].i;
+        colmrb[i] = col[indices[i]];
+    }
+
+    /*
+     * Gaussian elimination to put the most reliable independent positions
+     * in 0..K-1 (more or less in order of decreasing reliability). The
+     * pivot search is limited to 20 columns past the diagonal.
+     */
+    for (i = 0; i < OSD_K; i++) {
+        uint64_t bit = (uint64_t) 1 << i;
+        for (j = i; j < OSD_K + 20; j++) {
+            if (colmrb[j] & bit) {
+                if (j != i) {
+                    uint64_t t = colmrb[i];
+                    int it = indices[i];
+                    colmrb[i] = colmrb[j];
+                    colmrb[j] = t;
+                    indices[i] = indices[j];
+                    indices[j] = it;
+                }
+                uint64_t rows = colmrb[i] & ~bit;
+                int c;
+                for (c = 0; c < OSD_N; c++) {
+                    if (colmrb[c] & bit) colmrb[c] ^= rows;
+                }
+                break;
+            }
+        }
+    }
+
+    // Rows of the reduced matrix, and the received word, in MRB order
+    memset(g2, 0, sizeof(g2));
+    memset(&hdec, 0, sizeof(hdec));
+    for (j = 0; j < OSD_N; j++) {
+        uint64_t x = colmrb[j];
+        while (x) {
+            vec_set(&g2[__builtin_ctzll(x)], j);
+            x &= x - 1;
+        }
+        float rx = ss[indices[j]] / 127.0f;
+        absrx[j] = fabsf(rx);
+        if (rx >= 0) vec_set(&hdec, j);
+    }
+    for (i = 0; i < OSD_K; i++) {
+        if (vec_bit(&hdec, i)) m0 |= (uint64_t) 1 << i;
+        if (apmask[indices[i]]) apm |= (uint64_t) 1 << i;
+    }
+
+    // Order-0 codeword from the hard decisions on the MRB
+    c0 = mrbencode(m0, g2);
+    {
+        osd_vec nxor = vec_xor(&c0, &hdec);
+        *nhardmin = vec_weight(&nxor);
+        *dmin = vec_dist(&nxor, absrx);
+    }
+    best = c0;
+
+    if (ndeep > 0) {
+        int nord, npre1, npre2, nt, ntheta, ntau = 0;
+        int iorder;
+        osd_vec parity, ntmask;
+
+        if (ndeep > 5) ndeep = 5;
+        nt = 66;
+        switch (ndeep) {
+            case 1:  nord = 1; npre1 = 0; npre2 = 0; ntheta = 16; break;
+            case 2:  nord = 1; npre1 = 1; npre2 = 0; ntheta = 16; break;
+            case 3:  nord = 2; npre1 = 1; npre2 = 0; ntheta = 22; ntau = 16; break;
+            case 4:  nord = 2; npre1 = 1; npre2 = 1; ntheta = 22; ntau = 16; break;
+            default: nord = 3; npre1 = 1; npre2 = 0; ntheta = 22; ntau = 20; break;
+        }
+        parity = vec_range(OSD_K, OSD_N);
+        ntmask = vec_range(OSD_K, OSD_K + nt);
+
+        /*
+         * Flip every pattern of iorder MRB bits and re-encode; with
+         * preprocessing rule 1 also every pattern with one more bit below
+         * the lowest, screened by the parity disagreements in the first nt
+         * positions. Since c(m0 ^ mi) = c0 ^ c(mi), only the few rows of
+         * mi are XORed per candidate.
+         */
+        for (iorder = 1; iorder <= nord; iorder++) {
+            uint64_t misub = 0;
+            for (i = OSD_K - iorder; i < OSD_K; i++) misub |= (uint64_t) 1 << i;
+            int iflag = OSD_K - iorder;
+
+            while (iflag >= 0) {
+                int iend = (iorder == nord && npre1 == 0) ? iflag : 0;
+                int n1;
+                float d1 = 0.0;
+                osd_vec e2sub, ce;
+
+                memset(&e2sub, 0, sizeof(e2sub));
+                for (n1 = iflag; n1 >= iend; n1--) {
+                    uint64_t mi = misub | (uint64_t) 1 << n1;
+                    osd_vec e2, t;
+                    int nd1Kpt;
+
+                    if (mi & apm) continue;
+                    if (n1 == iflag) {
+                        ce = mrbencode(mi, g2);
+                        ce = vec_xor(&ce, &c0);
+                        t = vec_xor(&ce, &hdec);
+                        e2sub = vec_and(&t, &parity);
+                        e2 = e2sub;
+                        t = vec_and(&e2sub, &ntmask);
+                        nd1Kpt = vec_weight(&t) + 1;
+                        // Systematic part: ce ^ hdec = mi on 0..K-1
+                        osd_vec mv = {{mi, 0, 0}};
+                        d1 = vec_dist(&mv, absrx);
+                    } else {
+                        t = vec_and(&g2[n1], &parity);
+                        e2 = vec_xor(&e2sub, &t);
+                        t = vec_and(&e2, &ntmask);
+                        nd1Kpt = vec_weight(&t) + 2;
+                    }
+                    if (nd1Kpt <= ntheta) {
+                        float dd;
+                        if (n1 != iflag) {
+                            ce = mrbencode(mi, g2);
+                            ce = vec_xor(&ce, &c0);
+                            dd = d1 + (vec_bit(&ce, n1) ^ vec_bit(&hdec, n1)) * absrx[n1] +
+                                 vec_dist(&e2, absrx);
+                        } else {
+                            dd = d1 + vec_dist(&e2sub, absrx);
+                        }
+                        if (dd < *dmin) {
+                            osd_vec nxor = vec_xor(&ce, &hdec);
+                            *dmin = dd;
+                            best = ce;
+                            *nhardmin = vec_weight(&nxor);
+                        }
+                    }
+                }
+                iflag = nextpat(&misub, OSD_K, iorder);
+            }
+        }
+
+        /*
+         * Preprocessing rule 2: extend each order-nord pattern by the pairs
+         * of positions whose parity bits cancel its first ntau parity
+         * disagreements, allowing at most one remaining disagreement.
+         */
+        if (npre2) {
+            struct osd_boxes *box = malloc(sizeof(struct osd_boxes));
+            int np = 0, i1, i2;
+
+            box->head = malloc(sizeof(int) << ntau);
+            box->tail = malloc(sizeof(int) << ntau);
+            memset(box->head, -1, sizeof(int) << ntau);
+            for (i1 = OSD_K - 1; i1 >= 0; i1--) {
+                for (i2 = i1 - 1; i2 >= 0; i2--) {
+                    osd_vec t = vec_xor(&g2[i1], &g2[i2]);
+                    unsigned int ipat = tau_pattern(&t, ntau);
+                    box->pair[np][0] = i1;
+                    box->pair[np][1] = i2;
+                    box->next[np] = -1;
+                    if (box->head[ipat] < 0) {
+                        box->head[ipat] = np;
+                    } else {
+                        box->next[box->tail[ipat]] = np;
+                    }
+                    box->tail[ipat] = np;
+                    np++;
+                }
+            }
+
+            uint64_t misub = 0;
+            for (i = OSD_K - nord; i < OSD_K; i++) misub |= (uint64_t) 1 << i;
+            int iflag = OSD_K - nord;
+            while (iflag >= 0) {
+                osd_vec ce = mrbencode(misub, g2);
+                ce = vec_xor(&ce, &c0);
+                osd_vec e2sub = vec_xor(&ce, &hdec);
+                unsigned int r2 = tau_pattern(&e2sub, ntau);
+
+                for (i2 = 0; i2 <= ntau; i2++) {
+                    unsigned int r2pat = i2 > 0 ? r2 ^ (1u << (i2 - 1)) : r2;
+                    int ip;
+                    for (ip = box->head[r2pat]; ip >= 0; ip = box->next[ip]) {
+                        uint64_t mi = misub | (uint64_t) 1 << box->pair[ip][0] |
+                                      (uint64_t) 1 << box->pair[ip][1];
+                        if (__builtin_popcountll(mi) < nord + npre1 + npre2 || (mi & apm)) continue;
+                        osd_vec ce2 = mrbencode(mi, g2);
+                        ce2 = vec_xor(&ce2, &c0);
+                        osd_vec nxor = vec_xor(&ce2, &hdec);
+                        float dd = vec_dist(&nxor, absrx);
+                        if (dd < *dmin) {
+                            *dmin = dd;
+                            best = ce2;
+                            *nhardmin = vec_weight(&nxor);
+                        }
+                    }
+                }
+                iflag = nextpat(&misub, OSD_K, nord);
+            }
+            free(box->head);
+            free(box->tail);
+            free(box);
+        }
+    }
+
+    // Back to as-received order
+    for (j = 0; j < OSD_N; j++) {
+        cw[indices[j]] = (unsigned char) vec_bit(&best, j);
+    }
+}
@@ -0,0 +1,25 @@
+/*
+ This file is part of wsprd.
+
+ File name: osdwspr.h
+
+ Description: Ordered-statistics decoder for the K=32, r=1/2 WSPR
+ convolutional code (C port of osdwspr.f90).
+ */
+
+#ifndef OSDWSPR_H
+#define OSDWSPR_H
+
+/*
+ * ss:       162 deinterleaved soft symbols, positive for a 1
+ *           (symbols[i] - 128 in the Fano convention)
+ * apmask:   162 flags; message bits marked 1 are not flipped
+ * ndeep:    search depth 0..5 (0 = order-0 only)
+ * cw:       receives the most likely codeword, one bit per byte
+ * nhardmin: receives the number of hard-decision disagreements with cw
+ * dmin:     receives the soft distance of cw from the received word
+ */
+void osdwspr(const float *ss, const unsigned char *apmask, int ndeep,
+             unsigned char *cw, int *nhardmin, float *dmin);
+
+#endif
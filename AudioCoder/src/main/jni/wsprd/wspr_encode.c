@@ -0,0 +1,266 @@
+/*
+ This file is part of wsprd.
+
+ File name: wspr_encode.c
+
+ Description: WSPR message packing and channel encoding, see
+ wspr_encode.h. The packing follows BD1ES's wspr_enc (itself after
+ James Peroulas's WsprryPi) and G4JNT's "The WSPR Coding Process".
+
+ The convolutional code is run a byte at a time: five lookups in the
+ tables of wspr_encode_tab.c give the 16 code bits of each input byte,
+ where the bitwise encoder takes two 32-bit parities per bit.
+ */
+
+#include <ctype.h>
+#include <string.h>
+#include "nhash.h"
+#include "wspr_encode.h"
+
+// Bit-reversed order in which the 162 code bits are sent
+static const unsigned char wspr_interleave[WSPR_ENCODE_SYMBOLS] = {
+        0, 128, 64, 32, 160, 96, 16, 144, 80, 48, 112, 8, 136, 72,
+        40, 104, 24, 152, 88, 56, 120, 4, 132, 68, 36, 100, 20, 148,
+        84, 52, 116, 12, 140, 76, 44, 108, 28, 156, 92, 60, 124, 2,
+        130, 66, 34, 98, 18, 146, 82, 50, 114, 10, 138, 74, 42, 106,
+        26, 154, 90, 58, 122, 6, 134, 70, 38, 102, 22, 150, 86, 54,
+        118, 14, 142, 78, 46, 110, 30, 158, 94, 62, 126, 1, 129, 65,
+        33, 161, 97, 17, 145, 81, 49, 113, 9, 137, 73, 41, 105, 25,
+        153, 89, 57, 121, 5, 133, 69, 37, 101, 21, 149, 85, 53, 117,
+        13, 141, 77, 45, 109, 29, 157, 93, 61, 125, 3, 131, 67, 35,
+        99, 19, 147, 83, 51, 115, 11, 139, 75, 43, 107, 27, 155, 91,
+        59, 123, 7, 135, 71, 39, 103, 23, 151, 87, 55, 119, 15, 143,
+        79, 47, 111, 31, 159, 95, 63, 127,
+};
+
+// Sync vector, added to twice the interleaved code bit to form each channel symbol
+static const unsigned char wspr_sync[WSPR_ENCODE_SYMBOLS] = {
+        1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1,
+        1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0,
+        1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1, 0, 0, 0, 0, 1, 1, 0, 1, 0,
+        1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0,
+        0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1,
+        0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0,
+        0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0,
+};
+
+/* Character values: '0' - '9' give 0 - 9, 'A' - 'Z' (either case) 10 - 35
+ * and space 36; anything else 0.
+ */
+static const unsigned char wspr_cenc[128] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 36, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5,
+        6, 7, 8, 9, 0, 0, 0, 0, 0, 0, 0, 10, 11, 12, 13, 14, 15, 16,
+        17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+        35, 0, 0, 0, 0, 0, 0, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+        21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 0, 0, 0,
+        0, 0,
+};
+
+#define CENC(c) wspr_cenc[(c) & 0x7f]
+
+// ASCII only, whatever the locale; letters in either case
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define IS_LETTER(c) (((c) | 0x20) >= 'a' && ((c) | 0x20) <= 'z')
+#define IS_ALNUM(c) (IS_DIGIT(c) || IS_LETTER(c))
+
+/*
+ * Position of the digit of a base call of clen characters: one or two
+ * letters or digits, the digit, then up to three letters. -1 if the call
+ * has another shape.
+ */
+static int call_digit(const unsigned char *c, int clen) {
+    int i, k;
+
+    if (clen < 2 || clen > 6) return -1;
+    i = clen > 2 && IS_DIGIT(c[2]) ? 2 : IS_DIGIT(c[1]) ? 1 : -1;
+    if (i < 0 || clen - i - 1 > 3) return -1;
+    for (k = 0; k < i; k++) {
+        if (!IS_ALNUM(c[k])) return -1;
+    }
+    for (k = i + 1; k < clen; k++) {
+        if (!IS_LETTER(c[k])) return -1;
+    }
+    return i;
+}
+
+/*
+ * n1 is the 28-bit base call. For a compound call ("PJ4/K1ABC",
+ * "K1ABC/P", "K1ABC/10"), ng gets the prefix or suffix and nadd is 1
+ * or 2; otherwise nadd is 0.
+ *
+ * Returns 0 if the call cannot be packed: a base call of another shape,
+ * a prefix of more than 3 characters, or a suffix other than one letter
+ * or digit or two digits.
+ */
+static int pack_call(const char *call, uint32_t *n1, uint32_t *ng, int *nadd) {
+    const char *s = strchr(call, '/');
+    const unsigned char *c = (const unsigned char *) call;
+    int clen = (int) strlen(call);
+    int n, i, k;
+    uint32_t m = 0;
+
+    if (s) {
+        *nadd = 2;
+        // stroke position
+        i = (int) (s - call);
+        // suffix len, prefix-call len
+        n = clen - i - 1;
+        if (n < 1 || (n == 1 && !IS_ALNUM(c[i + 1])) ||
+            (n == 2 && !(IS_DIGIT(c[i + 1]) && IS_DIGIT(c[i + 2])))) {
+            return 0;
+        }
+        // 1-digit suffix /A to /Z, /0 to /9
+        if (n == 1) m = 60000 - 32768 + CENC(c[i + 1]);
+        // 2-digit suffix /10 to /99
+        if (n == 2) m = 60000 + 26 + 10 * CENC(c[i + 1]) + CENC(c[i + 2]);
+        // prefix EA8/, right align
+        if (n > 2) {
+            if (i < 1 || i > 3) return 0;
+            for (k = 0; k < i; k++) {
+                if (!IS_ALNUM(c[k])) return 0;
+            }
+            m = i < 3 ? 36 : CENC(c[i - 3]);
+            m = 37 * m + (i < 2 ? 36 : CENC(c[i - 2]));
+            m = 37 * m + (i < 1 ? 36 : CENC(c[i - 1]));
+            if (m < 32768) {
+                *nadd = 1;
+            } else {
+                m -= 32768;
+            }
+            c += i + 1;
+            clen -= i + 1;
+        } else {
+            clen -= n + 1;
+        }
+
+        // in message type 2, ng contains prefix or suffix
+        *ng = m;
+    } else {
+        *nadd = 0;
+    }
+
+    // n1 contains the normal call
+    i = call_digit(c, clen);
+    if (i < 0) return 0;
+    n = clen - i - 1;
+    m = i < 2 ? 36 : CENC(c[i - 2]);
+    m = 36 * m + (i < 1 ? 36 : CENC(c[i - 1]));
+    m = 10 * m + CENC(c[i]);
+    m = 27 * m + (n < 1 ? 26 : CENC(c[i + 1]) - 10);
+    m = 27 * m + (n < 2 ? 26 : CENC(c[i + 2]) - 10);
+    m = 27 * m + (n < 3 ? 26 : CENC(c[i + 3]) - 10);
+    *n1 = m;
+    return 1;
+}
+
+// Field letters A-R, square digits and, for 6 characters, subsquare letters A-X
+static int valid_grid(const char *grid, int gridlen) {
+    int k;
+
+    if (gridlen != 4 && gridlen != 6) return 0;
+    for (k = 0; k < gridlen; k++) {
+        int g = (unsigned char) grid[k];
+        int last = k < 2 ? 'r' : 'x';
+
+        if (k == 2 || k == 3) {
+            if (!IS_DIGIT(g)) return 0;
+        } else if ((g | 0x20) < 'a' || (g | 0x20) > last) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int wspr_pack_message(const char *call, const char *grid, int power, unsigned char *data) {
+    // EIRP in dBm={0,3,7,10,13,17,20,23,27,30,33,37,40,43,47,50,53,57,60}
+    static const signed char corr[10] = {0, -1, 1, 0, -1, 2, 1, 0, -1, 1};
+    int gridlen = (int) strlen(grid);
+    uint32_t n1, ng = 0;
+    int nadd, mtype, ntype, i;
+
+    if (gridlen != 6) {
+        if (!pack_call(call, &n1, &ng, &nadd)) return 0;
+
+        // in message type 1, ng contains 4-character grid locator
+        if (nadd == 0) {
+            const unsigned char *g = (const unsigned char *) grid;
+
+            if (!valid_grid(grid, gridlen)) return 0;
+            ng = 180 * (179 - 10 * (CENC(g[0]) - 10) - CENC(g[2]))
+                 + 10 * (CENC(g[1]) - 10) + CENC(g[3]);
+            mtype = 1;
+        } else {
+            // the grid is not sent
+            if (gridlen != 0 && !valid_grid(grid, gridlen)) return 0;
+            mtype = 2;
+        }
+    } else {
+        char tmp[13];
+        int clen = (int) strlen(call);
+
+        // the call is only sent as its hash, but must be one that types 1 and 2 could send
+        if (!valid_grid(grid, gridlen) || !pack_call(call, &n1, &ng, &nadd)) return 0;
+
+        // in message type 3, ng contains nhashing of the call (in uppercase)
+        if (clen > 12) clen = 12;
+        for (i = 0; i < clen; i++) tmp[i] = (char) toupper((unsigned char) call[i]);
+        tmp[clen] = 0;
+        ng = nhash(tmp, clen, (uint32_t) 146);
+
+        // n1 contains left-rotated 6-character grid locator as a call
+        for (i = 0; i < 5; i++) tmp[i] = grid[i + 1];
+        tmp[5] = grid[0];
+        tmp[6] = 0;
+        pack_call(tmp, &n1, &ng, &nadd);
+
+        mtype = 3;
+    }
+
+    power = power > 60 ? 60 : power < 0 ? 0 : power + corr[power % 10];
+
+    // add power level to ng according to the corresponding message formats
+    ntype = gridlen != 6 ? power + nadd : -(power + 1);
+    ng = 128 * ng + ntype + 64;
+
+    // pack n1, ng into 50 bits
+    data[0] = (unsigned char) (n1 >> 20);
+    data[1] = (unsigned char) (n1 >> 12);
+    data[2] = (unsigned char) (n1 >> 4);
+    data[3] = (unsigned char) (((n1 & 0x0f) << 4) | ((ng >> 18) & 0x0f));
+    data[4] = (unsigned char) (ng >> 10);
+    data[5] = (unsigned char) (ng >> 2);
+    data[6] = (unsigned char) ((ng & 0x03) << 6);
+
+    return mtype;
+}
+
+void wspr_encode_data(const unsigned char *data, unsigned char *symbols) {
+    uint32_t state = 0;     // last 32 input bits, the newest in bit 0
+    unsigned int input, bits, i, j, n = 0;
+
+    // 50 message bits and 31 zero tail bits give the 162 code bits
+    for (i = 0; i < 11; i++) {
+        input = i < 6 ? data[i] : i == 6 ? data[6] & 0xc0 : 0;
+        bits = wspr_encode_input_tab[input] ^
+               wspr_encode_state_tab[0][state & 0xff] ^
+               wspr_encode_state_tab[1][(state >> 8) & 0xff] ^
+               wspr_encode_state_tab[2][(state >> 16) & 0xff] ^
+               wspr_encode_state_tab[3][state >> 24];
+        state = (state << 8) | input;
+        for (j = 0; j < 16 && n < WSPR_ENCODE_SYMBOLS; j++, n++) {
+            unsigned int k = wspr_interleave[n];
+            symbols[k] = (unsigned char) (2 * ((bits >> (15 - j)) & 1) + wspr_sync[k]);
+        }
+    }
+}
+
+int wspr_encode_message(const char *call, const char *grid, int power, unsigned char *symbols) {
+    unsigned char data[7];
+    int mtype = wspr_pack_message(call, grid, power, data);
+
+    if (mtype == 0) return 0;
+    wspr_encode_data(data, symbols);
+    return mtype;
+}
@@ -0,0 +1,51 @@
+/*
+ This file is part of wsprd.
+
+ File name: wspr_encode.h
+
+ Description: The WSPR message encoder shared by the transmit path
+ (lbenc2 wspr_enc, the JNI encode calls and WSPREncoder.kt), the
+ simulator and the decoder's signal subtraction: message packing for
+ Type 1, 2 and 3 messages and the table-driven K=32, r=1/2
+ convolutional code with interleaving and sync.
+ */
+
+#ifndef WSPR_ENCODE_H
+#define WSPR_ENCODE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WSPR_ENCODE_SYMBOLS 162
+
+// Convolutional code output for 8 input bits, generated by genenctab: see wspr_encode.c
+extern const uint16_t wspr_encode_state_tab[4][256];
+extern const uint16_t wspr_encode_input_tab[256];
+
+/*
+ * Packs a message into its 50 bits, data[0..6] as fano() returns them.
+ * A callsign with a '/' makes a Type 2 message (the grid is not sent),
+ * a 6-character grid a Type 3 message (the callsign is sent as its
+ * hash); anything else is Type 1. Power is rounded to the nearest level
+ * WSPR can send, 0 to 60 dBm.
+ *
+ * Returns the message type, 1 - 3, or 0 if the message cannot be sent:
+ * a callsign not of the shapes WSPR packs, a Type 1 message without a
+ * 4-character grid, or a grid with a field beyond R or subsquare beyond X.
+ */
+int wspr_pack_message(const char *call, const char *grid, int power, unsigned char *data);
+
+// The 162 channel symbols (values 0-3) of the 50 message bits in data[0..6]
+void wspr_encode_data(const unsigned char *data, unsigned char *symbols);
+
+// Both of the above; returns the message type, or 0 with symbols untouched
+int wspr_encode_message(const char *call, const char *grid, int power, unsigned char *symbols);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
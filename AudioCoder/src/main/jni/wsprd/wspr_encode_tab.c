@@ -0,0 +1,179 @@
+/*
+ This file is part of wsprd.
+
+ File name: wspr_encode_tab.c
+
+ Description: Byte-wise tables of the WSPR convolutional code.
+ Generated by genenctab; do not edit.
+*/
+
+#include "wspr_encode.h"
+
+const uint16_t wspr_encode_state_tab[4][256] = {
+{
+    0x0000, 0x5232, 0x48ca, 0x1af8, 0x2329, 0x711b, 0x6be3, 0x39d1,
+    0x8ca5, 0xde97, 0xc46f, 0x965d, 0xaf8c, 0xfdbe, 0xe746, 0xb574,
+    0x3297, 0x60a5, 0x7a5d, 0x286f, 0x11be, 0x438c, 0x5974, 0x0b46,
+    0xbe32, 0xec00, 0xf6f8, 0xa4ca, 0x9d1b, 0xcf29, 0xd5d1, 0x87e3,
+    0xca5d, 0x986f, 0x8297, 0xd0a5, 0xe974, 0xbb46, 0xa1be, 0xf38c,
+    0x46f8, 0x14ca, 0x0e32, 0x5c00, 0x65d1, 0x37e3, 0x2d1b, 0x7f29,
+    0xf8ca, 0xaaf8, 0xb000, 0xe232, 0xdbe3, 0x89d1, 0x9329, 0xc11b,
+    0x746f, 0x265d, 0x3ca5, 0x6e97, 0x5746, 0x0574, 0x1f8c, 0x4dbe,
+    0x2976, 0x7b44, 0x61bc, 0x338e, 0x0a5f, 0x586d, 0x4295, 0x10a7,
+    0xa5d3, 0xf7e1, 0xed19, 0xbf2b, 0x86fa, 0xd4c8, 0xce30, 0x9c02,
+    0x1be1, 0x49d3, 0x532b, 0x0119, 0x38c8, 0x6afa, 0x7002, 0x2230,
+    0x9744, 0xc576, 0xdf8e, 0x8dbc, 0xb46d, 0xe65f, 0xfca7, 0xae95,
+    0xe32b, 0xb119, 0xabe1, 0xf9d3, 0xc002, 0x9230, 0x88c8, 0xdafa,
+    0x6f8e, 0x3dbc, 0x2744, 0x7576, 0x4ca7, 0x1e95, 0x046d, 0x565f,
+    0xd1bc, 0x838e, 0x9976, 0xcb44, 0xf295, 0xa0a7, 0xba5f, 0xe86d,
+    0x5d19, 0x0f2b, 0x15d3, 0x47e1, 0x7e30, 0x2c02, 0x36fa, 0x64c8,
+    0xa5d8, 0xf7ea, 0xed12, 0xbf20, 0x86f1, 0xd4c3, 0xce3b, 0x9c09,
+    0x297d, 0x7b4f, 0x61b7, 0x3385, 0x0a54, 0x5866, 0x429e, 0x10ac,
+    0x974f, 0xc57d, 0xdf85, 0x8db7, 0xb466, 0xe654, 0xfcac, 0xae9e,
+    0x1bea, 0x49d8, 0x5320, 0x0112, 0x38c3, 0x6af1, 0x7009, 0x223b,
+    0x6f85, 0x3db7, 0x274f, 0x757d, 0x4cac, 0x1e9e, 0x0466, 0x5654,
+    0xe320, 0xb112, 0xabea, 0xf9d8, 0xc009, 0x923b, 0x88c3, 0xdaf1,
+    0x5d12, 0x0f20, 0x15d8, 0x47ea, 0x7e3b, 0x2c09, 0x36f1, 0x64c3,
+    0xd1b7, 0x8385, 0x997d, 0xcb4f, 0xf29e, 0xa0ac, 0xba54, 0xe866,
+    0x8cae, 0xde9c, 0xc464, 0x9656, 0xaf87, 0xfdb5, 0xe74d, 0xb57f,
+    0x000b, 0x5239, 0x48c1, 0x1af3, 0x2322, 0x7110, 0x6be8, 0x39da,
+    0xbe39, 0xec0b, 0xf6f3, 0xa4c1, 0x9d10, 0xcf22, 0xd5da, 0x87e8,
+    0x329c, 0x60ae, 0x7a56, 0x2864, 0x11b5, 0x4387, 0x597f, 0x0b4d,
+    0x46f3, 0x14c1, 0x0e39, 0x5c0b, 0x65da, 0x37e8, 0x2d10, 0x7f22,
+    0xca56, 0x9864, 0x829c, 0xd0ae, 0xe97f, 0xbb4d, 0xa1b5, 0xf387,
+    0x7464, 0x2656, 0x3cae, 0x6e9c, 0x574d, 0x057f, 0x1f87, 0x4db5,
+    0xf8c1, 0xaaf3, 0xb00b, 0xe239, 0xdbe8, 0x89da, 0x9322, 0xc110},
+{
+    0x0000, 0x9761, 0x5d84, 0xcae5, 0x7610, 0xe171, 0x2b94, 0xbcf5,
+    0xd840, 0x4f21, 0x85c4, 0x12a5, 0xae50, 0x3931, 0xf3d4, 0x64b5,
+    0x6102, 0xf663, 0x3c86, 0xabe7, 0x1712, 0x8073, 0x4a96, 0xddf7,
+    0xb942, 0x2e23, 0xe4c6, 0x73a7, 0xcf52, 0x5833, 0x92d6, 0x05b7,
+    0x8409, 0x1368, 0xd98d, 0x4eec, 0xf219, 0x6578, 0xaf9d, 0x38fc,
+    0x5c49, 0xcb28, 0x01cd, 0x96ac, 0x2a59, 0xbd38, 0x77dd, 0xe0bc,
+    0xe50b, 0x726a, 0xb88f, 0x2fee, 0x931b, 0x047a, 0xce9f, 0x59fe,
+    0x3d4b, 0xaa2a, 0x60cf, 0xf7ae, 0x4b5b, 0xdc3a, 0x16df, 0x81be,
+    0x1027, 0x8746, 0x4da3, 0xdac2, 0x6637, 0xf156, 0x3bb3, 0xacd2,
+    0xc867, 0x5f06, 0x95e3, 0x0282, 0xbe77, 0x2916, 0xe3f3, 0x7492,
+    0x7125, 0xe644, 0x2ca1, 0xbbc0, 0x0735, 0x9054, 0x5ab1, 0xcdd0,
+    0xa965, 0x3e04, 0xf4e1, 0x6380, 0xdf75, 0x4814, 0x82f1, 0x1590,
+    0x942e, 0x034f, 0xc9aa, 0x5ecb, 0xe23e, 0x755f, 0xbfba, 0x28db,
+    0x4c6e, 0xdb0f, 0x11ea, 0x868b, 0x3a7e, 0xad1f, 0x67fa, 0xf09b,
+    0xf52c, 0x624d, 0xa8a8, 0x3fc9, 0x833c, 0x145d, 0xdeb8, 0x49d9,
+    0x2d6c, 0xba0d, 0x70e8, 0xe789, 0x5b7c, 0xcc1d, 0x06f8, 0x9199,
+    0x409e, 0xd7ff, 0x1d1a, 0x8a7b, 0x368e, 0xa1ef, 0x6b0a, 0xfc6b,
+    0x98de, 0x0fbf, 0xc55a, 0x523b, 0xeece, 0x79af, 0xb34a, 0x242b,
+    0x219c, 0xb6fd, 0x7c18, 0xeb79, 0x578c, 0xc0ed, 0x0a08, 0x9d69,
+    0xf9dc, 0x6ebd, 0xa458, 0x3339, 0x8fcc, 0x18ad, 0xd248, 0x4529,
+    0xc497, 0x53f6, 0x9913, 0x0e72, 0xb287, 0x25e6, 0xef03, 0x7862,
+    0x1cd7, 0x8bb6, 0x4153, 0xd632, 0x6ac7, 0xfda6, 0x3743, 0xa022,
+    0xa595, 0x32f4, 0xf811, 0x6f70, 0xd385, 0x44e4, 0x8e01, 0x1960,
+    0x7dd5, 0xeab4, 0x2051, 0xb730, 0x0bc5, 0x9ca4, 0x5641, 0xc120,
+    0x50b9, 0xc7d8, 0x0d3d, 0x9a5c, 0x26a9, 0xb1c8, 0x7b2d, 0xec4c,
+    0x88f9, 0x1f98, 0xd57d, 0x421c, 0xfee9, 0x6988, 0xa36d, 0x340c,
+    0x31bb, 0xa6da, 0x6c3f, 0xfb5e, 0x47ab, 0xd0ca, 0x1a2f, 0x8d4e,
+    0xe9fb, 0x7e9a, 0xb47f, 0x231e, 0x9feb, 0x088a, 0xc26f, 0x550e,
+    0xd4b0, 0x43d1, 0x8934, 0x1e55, 0xa2a0, 0x35c1, 0xff24, 0x6845,
+    0x0cf0, 0x9b91, 0x5174, 0xc615, 0x7ae0, 0xed81, 0x2764, 0xb005,
+    0xb5b2, 0x22d3, 0xe836, 0x7f57, 0xc3a2, 0x54c3, 0x9e26, 0x0947,
+    0x6df2, 0xfa93, 0x3076, 0xa717, 0x1be2, 0x8c83, 0x4666, 0xd107},
+{
+    0x0000, 0x0278, 0x09e2, 0x0b9a, 0x2789, 0x25f1, 0x2e6b, 0x2c13,
+    0x9e24, 0x9c5c, 0x97c6, 0x95be, 0xb9ad, 0xbbd5, 0xb04f, 0xb237,
+    0x7892, 0x7aea, 0x7170, 0x7308, 0x5f1b, 0x5d63, 0x56f9, 0x5481,
+    0xe6b6, 0xe4ce, 0xef54, 0xed2c, 0xc13f, 0xc347, 0xc8dd, 0xcaa5,
+    0xe24b, 0xe033, 0xeba9, 0xe9d1, 0xc5c2, 0xc7ba, 0xcc20, 0xce58,
+    0x7c6f, 0x7e17, 0x758d, 0x77f5, 0x5be6, 0x599e, 0x5204, 0x507c,
+    0x9ad9, 0x98a1, 0x933b, 0x9143, 0xbd50, 0xbf28, 0xb4b2, 0xb6ca,
+    0x04fd, 0x0685, 0x0d1f, 0x0f67, 0x2374, 0x210c, 0x2a96, 0x28ee,
+    0x892f, 0x8b57, 0x80cd, 0x82b5, 0xaea6, 0xacde, 0xa744, 0xa53c,
+    0x170b, 0x1573, 0x1ee9, 0x1c91, 0x3082, 0x32fa, 0x3960, 0x3b18,
+    0xf1bd, 0xf3c5, 0xf85f, 0xfa27, 0xd634, 0xd44c, 0xdfd6, 0xddae,
+    0x6f99, 0x6de1, 0x667b, 0x6403, 0x4810, 0x4a68, 0x41f2, 0x438a,
+    0x6b64, 0x691c, 0x6286, 0x60fe, 0x4ced, 0x4e95, 0x450f, 0x4777,
+    0xf540, 0xf738, 0xfca2, 0xfeda, 0xd2c9, 0xd0b1, 0xdb2b, 0xd953,
+    0x13f6, 0x118e, 0x1a14, 0x186c, 0x347f, 0x3607, 0x3d9d, 0x3fe5,
+    0x8dd2, 0x8faa, 0x8430, 0x8648, 0xaa5b, 0xa823, 0xa3b9, 0xa1c1,
+    0x24bf, 0x26c7, 0x2d5d, 0x2f25, 0x0336, 0x014e, 0x0ad4, 0x08ac,
+    0xba9b, 0xb8e3, 0xb379, 0xb101, 0x9d12, 0x9f6a, 0x94f0, 0x9688,
+    0x5c2d, 0x5e55, 0x55cf, 0x57b7, 0x7ba4, 0x79dc, 0x7246, 0x703e,
+    0xc209, 0xc071, 0xcbeb, 0xc993, 0xe580, 0xe7f8, 0xec62, 0xee1a,
+    0xc6f4, 0xc48c, 0xcf16, 0xcd6e, 0xe17d, 0xe305, 0xe89f, 0xeae7,
+    0x58d0, 0x5aa8, 0x5132, 0x534a, 0x7f59, 0x7d21, 0x76bb, 0x74c3,
+    0xbe66, 0xbc1e, 0xb784, 0xb5fc, 0x99ef, 0x9b97, 0x900d, 0x9275,
+    0x2042, 0x223a, 0x29a0, 0x2bd8, 0x07cb, 0x05b3, 0x0e29, 0x0c51,
+    0xad90, 0xafe8, 0xa472, 0xa60a, 0x8a19, 0x8861, 0x83fb, 0x8183,
+    0x33b4, 0x31cc, 0x3a56, 0x382e, 0x143d, 0x1645, 0x1ddf, 0x1fa7,
+    0xd502, 0xd77a, 0xdce0, 0xde98, 0xf28b, 0xf0f3, 0xfb69, 0xf911,
+    0x4b26, 0x495e, 0x42c4, 0x40bc, 0x6caf, 0x6ed7, 0x654d, 0x6735,
+    0x4fdb, 0x4da3, 0x4639, 0x4441, 0x6852, 0x6a2a, 0x61b0, 0x63c8,
+    0xd1ff, 0xd387, 0xd81d, 0xda65, 0xf676, 0xf40e, 0xff94, 0xfdec,
+    0x3749, 0x3531, 0x3eab, 0x3cd3, 0x10c0, 0x12b8, 0x1922, 0x1b5a,
+    0xa96d, 0xab15, 0xa08f, 0xa2f7, 0x8ee4, 0x8c9c, 0x8706, 0x857e},
+{
+    0x0000, 0x92fc, 0x4bf0, 0xd90c, 0x2fc0, 0xbd3c, 0x6430, 0xf6cc,
+    0xbf00, 0x2dfc, 0xf4f0, 0x660c, 0x90c0, 0x023c, 0xdb30, 0x49cc,
+    0xfc00, 0x6efc, 0xb7f0, 0x250c, 0xd3c0, 0x413c, 0x9830, 0x0acc,
+    0x4300, 0xd1fc, 0x08f0, 0x9a0c, 0x6cc0, 0xfe3c, 0x2730, 0xb5cc,
+    0xf000, 0x62fc, 0xbbf0, 0x290c, 0xdfc0, 0x4d3c, 0x9430, 0x06cc,
+    0x4f00, 0xddfc, 0x04f0, 0x960c, 0x60c0, 0xf23c, 0x2b30, 0xb9cc,
+    0x0c00, 0x9efc, 0x47f0, 0xd50c, 0x23c0, 0xb13c, 0x6830, 0xfacc,
+    0xb300, 0x21fc, 0xf8f0, 0x6a0c, 0x9cc0, 0x0e3c, 0xd730, 0x45cc,
+    0xc000, 0x52fc, 0x8bf0, 0x190c, 0xefc0, 0x7d3c, 0xa430, 0x36cc,
+    0x7f00, 0xedfc, 0x34f0, 0xa60c, 0x50c0, 0xc23c, 0x1b30, 0x89cc,
+    0x3c00, 0xaefc, 0x77f0, 0xe50c, 0x13c0, 0x813c, 0x5830, 0xcacc,
+    0x8300, 0x11fc, 0xc8f0, 0x5a0c, 0xacc0, 0x3e3c, 0xe730, 0x75cc,
+    0x3000, 0xa2fc, 0x7bf0, 0xe90c, 0x1fc0, 0x8d3c, 0x5430, 0xc6cc,
+    0x8f00, 0x1dfc, 0xc4f0, 0x560c, 0xa0c0, 0x323c, 0xeb30, 0x79cc,
+    0xcc00, 0x5efc, 0x87f0, 0x150c, 0xe3c0, 0x713c, 0xa830, 0x3acc,
+    0x7300, 0xe1fc, 0x38f0, 0xaa0c, 0x5cc0, 0xce3c, 0x1730, 0x85cc,
+    0x0000, 0x92fc, 0x4bf0, 0xd90c, 0x2fc0, 0xbd3c, 0x6430, 0xf6cc,
+    0xbf00, 0x2dfc, 0xf4f0, 0x660c, 0x90c0, 0x023c, 0xdb30, 0x49cc,
+    0xfc00, 0x6efc, 0xb7f0, 0x250c, 0xd3c0, 0x413c, 0x9830, 0x0acc,
+    0x4300, 0xd1fc, 0x08f0, 0x9a0c, 0x6cc0, 0xfe3c, 0x2730, 0xb5cc,
+    0xf000, 0x62fc, 0xbbf0, 0x290c, 0xdfc0, 0x4d3c, 0x9430, 0x06cc,
+    0x4f00, 0xddfc, 0x04f0, 0x960c, 0x60c0, 0xf23c, 0x2b30, 0xb9cc,
+    0x0c00, 0x9efc, 0x47f0, 0xd50c, 0x23c0, 0xb13c, 0x6830, 0xfacc,
+    0xb300, 0x21fc, 0xf8f0, 0x6a0c, 0x9cc0, 0x0e3c, 0xd730, 0x45cc,
+    0xc000, 0x52fc, 0x8bf0, 0x190c, 0xefc0, 0x7d3c, 0xa430, 0x36cc,
+    0x7f00, 0xedfc, 0x34f0, 0xa60c, 0x50c0, 0xc23c, 0x1b30, 0x89cc,
+    0x3c00, 0xaefc, 0x77f0, 0xe50c, 0x13c0, 0x813c, 0x5830, 0xcacc,
+    0x8300, 0x11fc, 0xc8f0, 0x5a0c, 0xacc0, 0x3e3c, 0xe730, 0x75cc,
+    0x3000, 0xa2fc, 0x7bf0, 0xe90c, 0x1fc0, 0x8d3c, 0x5430, 0xc6cc,
+    0x8f00, 0x1dfc, 0xc4f0, 0x560c, 0xa0c0, 0x323c, 0xeb30, 0x79cc,
+    0xcc00, 0x5efc, 0x87f0, 0x150c, 0xe3c0, 0x713c, 0xa830, 0x3acc,
+    0x7300, 0xe1fc, 0x38f0, 0xaa0c, 0x5cc0, 0xce3c, 0x1730, 0x85cc}
+};
+
+const uint16_t wspr_encode_input_tab[256] = {
+    0x0000, 0x0003, 0x000d, 0x000e, 0x0035, 0x0036, 0x0038, 0x003b,
+    0x00d4, 0x00d7, 0x00d9, 0x00da, 0x00e1, 0x00e2, 0x00ec, 0x00ef,
+    0x0352, 0x0351, 0x035f, 0x035c, 0x0367, 0x0364, 0x036a, 0x0369,
+    0x0386, 0x0385, 0x038b, 0x0388, 0x03b3, 0x03b0, 0x03be, 0x03bd,
+    0x0d48, 0x0d4b, 0x0d45, 0x0d46, 0x0d7d, 0x0d7e, 0x0d70, 0x0d73,
+    0x0d9c, 0x0d9f, 0x0d91, 0x0d92, 0x0da9, 0x0daa, 0x0da4, 0x0da7,
+    0x0e1a, 0x0e19, 0x0e17, 0x0e14, 0x0e2f, 0x0e2c, 0x0e22, 0x0e21,
+    0x0ece, 0x0ecd, 0x0ec3, 0x0ec0, 0x0efb, 0x0ef8, 0x0ef6, 0x0ef5,
+    0x3523, 0x3520, 0x352e, 0x352d, 0x3516, 0x3515, 0x351b, 0x3518,
+    0x35f7, 0x35f4, 0x35fa, 0x35f9, 0x35c2, 0x35c1, 0x35cf, 0x35cc,
+    0x3671, 0x3672, 0x367c, 0x367f, 0x3644, 0x3647, 0x3649, 0x364a,
+    0x36a5, 0x36a6, 0x36a8, 0x36ab, 0x3690, 0x3693, 0x369d, 0x369e,
+    0x386b, 0x3868, 0x3866, 0x3865, 0x385e, 0x385d, 0x3853, 0x3850,
+    0x38bf, 0x38bc, 0x38b2, 0x38b1, 0x388a, 0x3889, 0x3887, 0x3884,
+    0x3b39, 0x3b3a, 0x3b34, 0x3b37, 0x3b0c, 0x3b0f, 0x3b01, 0x3b02,
+    0x3bed, 0x3bee, 0x3be0, 0x3be3, 0x3bd8, 0x3bdb, 0x3bd5, 0x3bd6,
+    0xd48c, 0xd48f, 0xd481, 0xd482, 0xd4b9, 0xd4ba, 0xd4b4, 0xd4b7,
+    0xd458, 0xd45b, 0xd455, 0xd456, 0xd46d, 0xd46e, 0xd460, 0xd463,
+    0xd7de, 0xd7dd, 0xd7d3, 0xd7d0, 0xd7eb, 0xd7e8, 0xd7e6, 0xd7e5,
+    0xd70a, 0xd709, 0xd707, 0xd704, 0xd73f, 0xd73c, 0xd732, 0xd731,
+    0xd9c4, 0xd9c7, 0xd9c9, 0xd9ca, 0xd9f1, 0xd9f2, 0xd9fc, 0xd9ff,
+    0xd910, 0xd913, 0xd91d, 0xd91e, 0xd925, 0xd926, 0xd928, 0xd92b,
+    0xda96, 0xda95, 0xda9b, 0xda98, 0xdaa3, 0xdaa0, 0xdaae, 0xdaad,
+    0xda42, 0xda41, 0xda4f, 0xda4c, 0xda77, 0xda74, 0xda7a, 0xda79,
+    0xe1af, 0xe1ac, 0xe1a2, 0xe1a1, 0xe19a, 0xe199, 0xe197, 0xe194,
+    0xe17b, 0xe178, 0xe176, 0xe175, 0xe14e, 0xe14d, 0xe143, 0xe140,
+    0xe2fd, 0xe2fe, 0xe2f0, 0xe2f3, 0xe2c8, 0xe2cb, 0xe2c5, 0xe2c6,
+    0xe229, 0xe22a, 0xe224, 0xe227, 0xe21c, 0xe21f, 0xe211, 0xe212,
+    0xece7, 0xece4, 0xecea, 0xece9, 0xecd2, 0xecd1, 0xecdf, 0xecdc,
+    0xec33, 0xec30, 0xec3e, 0xec3d, 0xec06, 0xec05, 0xec0b, 0xec08,
+    0xefb5, 0xefb6, 0xefb8, 0xefbb, 0xef80, 0xef83, 0xef8d, 0xef8e,
+    0xef61, 0xef62, 0xef6c, 0xef6f, 0xef54, 0xef57, 0xef59, 0xef5a};
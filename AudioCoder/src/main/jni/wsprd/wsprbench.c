@@ -0,0 +1,441 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprbench.c
+
+ Description: Microbenchmarks of the decoder's stages on a fixed-seed
+ synthetic recording (three signals near -22 dB in noise), for
+ comparing commits and ABIs. Every kernel is called repeatedly for at
+ least the minimum time; the report gives the time per call and the
+ throughput in the kernel's natural unit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "fano.h"
+#include "jelinek.h"
+#include "metric_cache.h"
+#include "wsprd_utils.h"
+#include "wsprsim_utils.h"
+#include "wsprd_kernels.h"
+#include "wsprsim_channel.h"
+#include "wspr_encode.h"
+#include "../lbenc2/wenc.h"
+#include "../lbenc2/wcache.h"
+#include "../lbenc2/wsynth.h"
+
+#if defined(__aarch64__)
+#define BENCH_ABI "arm64-v8a"
+#elif defined(__arm__)
+#define BENCH_ABI "armeabi-v7a"
+#elif defined(__x86_64__)
+#define BENCH_ABI "x86_64"
+#elif defined(__i386__)
+#define BENCH_ABI "x86"
+#else
+#define BENCH_ABI "unknown"
+#endif
+
+#define BENCH_SEED 20240611
+#define NCANDIDATES 21
+#define SYMFAC 50
+
+// Inputs shared by the kernels, built once from the fixed seed
+struct bench_input {
+    struct wsprsim_signal sigs[3];
+    short *pcm;
+    float *idat, *qdat;          // baseband from ReadWavFileEx
+    float *iwork, *qwork;        // scratch copies for subtraction
+    long np;
+    int nffts;
+    float (*ps)[];               // 512 x nffts spectrogram
+    float psavg[512], w[512];
+    fftwf_complex *fftin, *fftout;
+    fftwf_plan plan;
+    float f1, drift1;            // first signal, as the decoder refines it
+    int shift1;
+    unsigned char soft[3][162];  // deinterleaved soft symbols: first signal, and the
+                                 // same message alone near the decoder's threshold
+    unsigned char decdata[11];
+    unsigned char channel_symbols[162];
+    const int (*mettab)[256];
+    struct jelinek_workspace *jelinek;
+    struct wsprd_context *ctx;
+    char *hashtab;
+    struct wcache *symbol_cache;
+    unsigned long long cycles;   // decoder cycles of the last call
+};
+
+struct bench {
+    const char *name;
+    const char *unit;
+    double units;                // per call; 0 for millions of decoder cycles
+    void (*run)(struct bench_input *in);
+};
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_readwav(struct bench_input *in) {
+    ReadWavFileEx((unsigned char *) in->pcm, sizeof(short) * WSPRSIM_PCM_SAMPLES, 2,
+                  in->iwork, in->qwork);
+}
+
+static void run_spectrogram(struct bench_input *in) {
+    compute_spectrogram(in->idat, in->qdat, in->nffts, in->w, in->fftin, in->fftout, in->plan,
+                        in->ps, in->psavg);
+}
+
+static void run_candidates(struct bench_input *in) {
+    float freq0[NCANDIDATES], drift0[NCANDIDATES], sync0[NCANDIDATES];
+    int shift0[NCANDIDATES], i;
+
+    for (i = 0; i < NCANDIDATES; i++) freq0[i] = -100.0 + 10.0 * i;
+    coarse_candidate_search(in->nffts, in->ps, NCANDIDATES, 4, freq0, shift0, drift0, sync0);
+}
+
+// Arguments as the original wsprd passed them; lagstep must be nonzero in every mode
+static void run_sync(struct bench_input *in, int mode) {
+    unsigned char symbols[162];
+    float f1 = in->f1, drift1 = in->drift1, sync1;
+    int shift1 = in->shift1;
+
+    if (mode == 0) {
+        sync_and_demodulate(in->idat, in->qdat, in->np, symbols, &f1, 0, 0, 0.0, &shift1,
+                            shift1 - 128, shift1 + 128, 64, &drift1, SYMFAC, &sync1, 0);
+    } else if (mode == 1) {
+        sync_and_demodulate(in->idat, in->qdat, in->np, symbols, &f1, -2, 2, 0.25, &shift1,
+                            shift1, shift1, 64, &drift1, SYMFAC, &sync1, 1);
+    } else {
+        sync_and_demodulate(in->idat, in->qdat, in->np, symbols, &f1, 0, 0, 0.0, &shift1,
+                            shift1, shift1, 64, &drift1, SYMFAC, &sync1, 2);
+    }
+}
+
+static void run_sync0(struct bench_input *in) { run_sync(in, 0); }
+static void run_sync1(struct bench_input *in) { run_sync(in, 1); }
+static void run_sync2(struct bench_input *in) { run_sync(in, 2); }
+
+// The decoder's replacement for modes 0 and 1: one sweep over the lag grid
+static void run_sync_grid(struct bench_input *in) {
+    float f1, drift1 = in->drift1, sync1;
+    int shift1;
+
+    sync_search_grid(in->idat, in->qdat, in->np, in->f1, 0, 0, 0.0, in->shift1 - 128,
+                     in->shift1 + 128, 64, &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
+}
+
+static void run_ncsd(struct bench_input *in, int nblock) {
+    unsigned char symbols[162];
+    float f1 = in->f1, drift1 = in->drift1;
+    int shift1 = in->shift1;
+
+    noncoherent_sequence_detection(in->idat, in->qdat, in->np, symbols, &f1, &shift1, &drift1,
+                                   SYMFAC, &nblock);
+}
+
+static void run_ncsd1(struct bench_input *in) { run_ncsd(in, 1); }
+static void run_ncsd2(struct bench_input *in) { run_ncsd(in, 2); }
+static void run_ncsd3(struct bench_input *in) { run_ncsd(in, 3); }
+
+static void run_subtract2(struct bench_input *in) {
+    memcpy(in->iwork, in->idat, sizeof(float) * in->np);
+    memcpy(in->qwork, in->qdat, sizeof(float) * in->np);
+    subtract_signal2(in->iwork, in->qwork, in->np, in->f1, in->shift1, in->drift1,
+                     in->channel_symbols);
+}
+
+static void run_subtract_fft(struct bench_input *in) {
+    memcpy(in->iwork, in->idat, sizeof(float) * in->np);
+    memcpy(in->qwork, in->qdat, sizeof(float) * in->np);
+    subtract_signal_fft(in->ctx, in->iwork, in->qwork, in->np, in->f1, in->shift1, in->drift1,
+                        in->channel_symbols);
+}
+
+static void run_fano(struct bench_input *in, int k) {
+    unsigned char symbols[162], data[11];
+    unsigned int metric, cycles, maxnp;
+
+    memcpy(symbols, in->soft[k], 162);
+    fano(&metric, &cycles, &maxnp, data, symbols, 81, in->mettab, 60, 10000);
+    in->cycles = cycles;
+}
+
+static void run_fano0(struct bench_input *in) { run_fano(in, 0); }
+static void run_fano1(struct bench_input *in) { run_fano(in, 1); }
+static void run_fano2(struct bench_input *in) { run_fano(in, 2); }
+
+static void run_jelinek(struct bench_input *in, int k) {
+    unsigned char symbols[162], data[11];
+    unsigned int metric, cycles;
+
+    memcpy(symbols, in->soft[k], 162);
+    jelinek_decode(in->jelinek, &metric, &cycles, data, symbols, 81, in->mettab, 10000);
+    in->cycles = cycles;
+}
+
+static void run_jelinek0(struct bench_input *in) { run_jelinek(in, 0); }
+static void run_jelinek1(struct bench_input *in) { run_jelinek(in, 1); }
+static void run_jelinek2(struct bench_input *in) { run_jelinek(in, 2); }
+
+static void run_unpk(struct bench_input *in) {
+    signed char message[11];
+    char call_loc_pow[23], callsign[13];
+    int i;
+
+    for (i = 0; i < 11; i++) message[i] = (signed char) in->decdata[i];
+    unpk_(message, in->hashtab, call_loc_pow, callsign);
+}
+
+static void run_wspr_enc(struct bench_input *in) {
+    uint8_t symbols[162];
+
+    (void) in;
+    wspr_enc("K1ABC", "FN42", "37", symbols);
+}
+
+// Convolutional code, interleaving and sync of the decoded message
+static void run_channel_encode(struct bench_input *in) {
+    unsigned char symbols[162];
+
+    wspr_encode_data(in->decdata, symbols);
+}
+
+// Packing and coding of Type 1, 2 and 3 messages in turn, one per call
+static void run_wspr_encode_types(struct bench_input *in) {
+    static const char *calls[3] = {"K1ABC", "PJ4/K1ABC", "K1ABC"};
+    static const char *grids[3] = {"FN42", "", "FN42ab"};
+    static int next;
+    unsigned char symbols[162];
+
+    (void) in;
+    wspr_encode_message(calls[next], grids[next], 37, symbols);
+    next = next == 2 ? 0 : next + 1;
+}
+
+// A beacon rotation already in the symbol cache, one message per call
+static void run_wspr_enc_cached(struct bench_input *in) {
+    static const char *calls[4] = {"K1ABC", "PJ4/K1ABC", "<PJ4/K1ABC>", "G4XYZ"};
+    static const char *grids[4] = {"FN42", "FN42", "FN42ab", "IO91"};
+    static int next;
+    uint8_t symbols[162];
+
+    wcache_symbols(in->symbol_cache, calls[next], grids[next], "37", symbols);
+    next = (next + 1) & 3;
+}
+
+static void run_synth(struct bench_input *in) {
+    struct wsprsim_rng rng;
+
+    wsprsim_rng_seed(&rng, BENCH_SEED);
+    wsprsim_pcm(in->sigs, 1, &rng, in->pcm);
+}
+
+// Transmit audio as WSPREncodeToPCM makes it
+static void run_tx_pcm(struct bench_input *in) {
+    wsynth_pcm(in->sigs[0].symbols, 1500.0, 4095.0, in->pcm);
+}
+
+static const struct bench benches[] = {
+    {"ReadWavFileEx",         "Msample", WSPRSIM_PCM_SAMPLES / 1e6, run_readwav},
+    {"spectrogram",           "frame",   1,                          run_spectrogram},
+    {"coarse_candidates",     "cand",    NCANDIDATES,                run_candidates},
+    {"sync_and_demod_mode0",  "call",    1,                          run_sync0},
+    {"sync_and_demod_mode1",  "call",    1,                          run_sync1},
+    {"sync_and_demod_mode2",  "call",    1,                          run_sync2},
+    {"sync_search_grid",      "call",    1,                          run_sync_grid},
+    {"ncsd_block1",           "call",    1,                          run_ncsd1},
+    {"ncsd_block2",           "call",    1,                          run_ncsd2},
+    {"ncsd_block3",           "call",    1,                          run_ncsd3},
+    {"subtract_signal2",      "signal",  1,                          run_subtract2},
+    {"subtract_signal_fft",   "signal",  1,                          run_subtract_fft},
+    {"fano",                  "Mcycle",  0,                          run_fano0},
+    {"fano_weak",             "Mcycle",  0,                          run_fano1},
+    {"fano_timeout",          "Mcycle",  0,                          run_fano2},
+    {"jelinek",               "Mcycle",  0,                          run_jelinek0},
+    {"jelinek_weak",          "Mcycle",  0,                          run_jelinek1},
+    {"jelinek_timeout",       "Mcycle",  0,                          run_jelinek2},
+    {"unpk_",                 "msg",     1,                          run_unpk},
+    {"wspr_enc",              "msg",     1,                          run_wspr_enc},
+    {"channel_encode",        "msg",     1,                          run_channel_encode},
+    {"wspr_encode_types",     "msg",     1,                          run_wspr_encode_types},
+    {"wspr_enc_cached",       "msg",     1,                          run_wspr_enc_cached},
+    {"pcm_synth",             "Msample", WSPRSIM_PCM_SAMPLES / 1e6, run_synth},
+    {"tx_pcm",                "Msample", WSYNTH_SYMBOLS * WSYNTH_SYMBOL_SAMPLES / 1e6, run_tx_pcm},
+};
+
+// Soft symbols of the first message alone at the given SNR, on the benchmark's noise
+static void weak_soft_symbols(struct bench_input *in, float snr, unsigned char *soft) {
+    struct wsprsim_signal sig = in->sigs[0];
+    struct wsprsim_rng rng;
+    float f1 = sig.freq, drift1 = 0.0;
+    int shift1 = 375, nblock = 1;
+    long np;
+
+    sig.snr = snr;
+    wsprsim_rng_seed(&rng, BENCH_SEED);
+    wsprsim_pcm(&sig, 1, &rng, in->pcm);
+    np = ReadWavFileEx((unsigned char *) in->pcm, sizeof(short) * WSPRSIM_PCM_SAMPLES, 2,
+                       in->iwork, in->qwork);
+    noncoherent_sequence_detection(in->iwork, in->qwork, np, soft, &f1, &shift1, &drift1, SYMFAC,
+                                   &nblock);
+    deinterleave(soft);
+}
+
+static int setup(struct bench_input *in) {
+    static const char *messages[3] = {"K1ABC FN42 37", "W9XYZ EN61 30", "G4ABC IO91 23"};
+    static const float freqs[3] = {20.0, -47.0, 73.0};
+    struct wsprsim_rng rng;
+    unsigned int metric, cycles, maxnp;
+    int i, nblock = 1;
+
+    memset(in, 0, sizeof(*in));
+    for (i = 0; i < 3; i++) {
+        if (!wsprsim_symbols(messages[i], in->sigs[i].symbols)) return 0;
+        in->sigs[i].snr = -22.0;
+        in->sigs[i].freq = freqs[i];
+        in->sigs[i].dt = 0.5 * i;
+    }
+    in->pcm = malloc(sizeof(short) * WSPRSIM_PCM_SAMPLES);
+    in->idat = calloc(65536, sizeof(float));
+    in->qdat = calloc(65536, sizeof(float));
+    in->iwork = calloc(65536, sizeof(float));
+    in->qwork = calloc(65536, sizeof(float));
+    in->symbol_cache = wcache_alloc(16);
+
+    // Fano needs ~5000 cycles at -29 dB and runs out of cycles at -30 dB
+    weak_soft_symbols(in, -29.0, in->soft[1]);
+    weak_soft_symbols(in, -30.0, in->soft[2]);
+
+    wsprsim_rng_seed(&rng, BENCH_SEED);
+    wsprsim_pcm(in->sigs, 3, &rng, in->pcm);
+    in->np = ReadWavFileEx((unsigned char *) in->pcm, sizeof(short) * WSPRSIM_PCM_SAMPLES, 2,
+                           in->idat, in->qdat);
+
+    in->nffts = 4 * floor(in->np / 512) - 1;
+    in->ps = malloc(sizeof(float) * 512 * in->nffts);
+    in->fftin = fftwf_malloc(sizeof(fftwf_complex) * 512);
+    in->fftout = fftwf_malloc(sizeof(fftwf_complex) * 512);
+    in->plan = fftwf_plan_dft_1d(512, in->fftin, in->fftout, FFTW_FORWARD, FFTW_ESTIMATE);
+    for (i = 0; i < 512; i++) in->w[i] = sin(0.006147931 * i);
+
+    // First signal where the decoder would find it: 1 s + dt into the frame
+    in->f1 = in->sigs[0].freq;
+    in->shift1 = 375;
+    in->drift1 = 0.0;
+    noncoherent_sequence_detection(in->idat, in->qdat, in->np, in->soft[0], &in->f1, &in->shift1,
+                                   &in->drift1, SYMFAC, &nblock);
+    deinterleave(in->soft[0]);
+
+    in->mettab = metric_table(0.45);
+    in->jelinek = jelinek_workspace_alloc(200000);
+    in->ctx = wsprd_context_alloc(8);
+    in->hashtab = calloc(32768 * 13, sizeof(char));
+    {
+        unsigned char symbols[162];
+        memcpy(symbols, in->soft[0], 162);
+        if (fano(&metric, &cycles, &maxnp, in->decdata, symbols, 81, in->mettab, 60, 10000)) {
+            fprintf(stderr, "Reference signal does not decode\n");
+            return 0;
+        }
+    }
+    get_wspr_channel_symbols_from_data(in->decdata, in->channel_symbols);
+    return 1;
+}
+
+static void usage(void) {
+    printf("Usage: wsprbench [options...]\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("       -t x minimum seconds per kernel, default 1\n");
+    printf("       -k name run only kernels whose name contains this\n");
+    printf("       -c CSV output\n");
+    printf("       -l list kernels\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct bench_input in;
+    const char *filter = NULL;
+    double min_seconds = 1.0;
+    int c, csv = 0, i;
+    int nbench = sizeof(benches) / sizeof(benches[0]);
+
+    while ((c = getopt(argc, argv, "chk:lt:")) != -1) {
+        switch (c) {
+            case 'c':
+                csv = 1;
+                break;
+            case 'k':
+                filter = optarg;
+                break;
+            case 'l':
+                for (i = 0; i < nbench; i++) printf("%s\n", benches[i].name);
+                return 0;
+            case 't':
+                min_seconds = strtod(optarg, NULL);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+
+    if (!setup(&in)) return 1;
+
+    if (csv) {
+        printf("abi,kernel,calls,us_per_call,unit,units_per_second,cycles\n");
+    } else {
+        printf("wsprbench %s, %s, seed %d\n\n", BENCH_ABI, __VERSION__, BENCH_SEED);
+        printf("%-22s %8s %12s %16s %10s\n", "Kernel", "Calls", "us/call", "Throughput", "Cycles");
+    }
+    for (i = 0; i < nbench; i++) {
+        const struct bench *b = &benches[i];
+        double t0, elapsed, us, rate;
+        long calls = 0;
+
+        if (filter != NULL && strstr(b->name, filter) == NULL) continue;
+        in.cycles = 0;
+        b->run(&in);  // warm up
+        t0 = wall_seconds();
+        do {
+            b->run(&in);
+            calls++;
+            elapsed = wall_seconds() - t0;
+        } while (elapsed < min_seconds || calls < 3);
+
+        us = 1e6 * elapsed / calls;
+        rate = (b->units > 0 ? b->units : in.cycles / 1e6) * calls / elapsed;
+        if (csv) {
+            printf("%s,%s,%ld,%.3f,%s,%.1f,%llu\n", BENCH_ABI, b->name, calls, us, b->unit, rate,
+                   in.cycles);
+        } else {
+            char throughput[32];
+            snprintf(throughput, sizeof(throughput), "%.1f %s/s", rate, b->unit);
+            printf("%-22s %8ld %12.2f %16s", b->name, calls, us, throughput);
+            if (in.cycles) printf(" %10llu", in.cycles);
+            printf("\n");
+        }
+    }
+
+    fftwf_destroy_plan(in.plan);
+    fftwf_free(in.fftin);
+    fftwf_free(in.fftout);
+    jelinek_workspace_free(in.jelinek);
+    wsprd_context_free(in.ctx);
+    free(in.hashtab);
+    free(in.ps);
+    free(in.pcm);
+    free(in.idat);
+    free(in.qdat);
+    free(in.iwork);
+    free(in.qwork);
+    wcache_free(in.symbol_cache);
+    return 0;
+}
@@ -0,0 +1,430 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprcorpus.c
+
+ Description: Regression and throughput test of the decoder over a
+ corpus of recordings. Decodes every 12 kHz 16-bit mono .wav file in a
+ directory with wsprd_decode(), the path the app uses, and compares the
+ messages with a golden list: decodes found, lost and new, total time
+ and percentiles of the time per file.
+
+ The golden list has one decode per line, "file.wav freq_MHz message",
+ as written by -g with -w; lines starting with '#' are ignored. Only
+ the file and the message are compared.
+
+ With -T the decode of the slowest file is traced, for a timeline viewer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "wsprd_decoder.h"
+#include "wsprd_trace.h"
+
+#define MAX_WAV_BYTES (2 * 12000 * 120)  // longer recordings are truncated
+
+struct corpus_file {
+    char *name;
+    int ndecodes;
+    struct wsprd_decode decodes[WSPRD_MAX_DECODES];
+    double wall_seconds, cpu_seconds;
+    int error;  // not a usable .wav file
+};
+
+struct golden {
+    char *file;
+    char message[23];  // normalized
+    int found;
+};
+
+struct corpus_config {
+    const char *dir;
+    double dialfreq;
+    const char *trace_file;  // trace of the slowest decode, or NULL
+    struct wsprd_options opts;
+
+    struct corpus_file *files;
+    int nfiles;
+
+    pthread_mutex_t lock;
+    int next_file;
+    double slowest;          // decode seconds of the traced file
+};
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// "K1ABC FN42 7" and "K1ABC FN42  7" are the same message
+static void normalize_message(const char *in, char *out) {
+    char call[23] = "", grid[23] = "";
+    int power = 0, n;
+
+    n = sscanf(in, "%22s %22s %d", call, grid, &power);
+    if (n == 3) {
+        snprintf(out, 23, "%s %s %d", call, grid, power);
+    } else if (n == 2) {
+        snprintf(out, 23, "%s %s", call, grid);  // Type 2: CALL/P POWER
+    } else {
+        snprintf(out, 23, "%s", in);
+    }
+}
+
+static unsigned int le16(const unsigned char *p) {
+    return p[0] | p[1] << 8;
+}
+
+static unsigned long le32(const unsigned char *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+/*
+ * Reads the samples of a 12 kHz 16-bit mono .wav file into buf (at most
+ * MAX_WAV_BYTES). Returns their length in bytes, or -1 if the file is
+ * not in that format.
+ */
+static long read_wav(const char *path, unsigned char *buf) {
+    unsigned char hdr[16];
+    unsigned long len;
+    int fmt_ok = 0;
+    long n = -1;
+    FILE *fp;
+
+    if ((fp = fopen(path, "rb")) == NULL) return -1;
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fclose(fp);
+        return -1;
+    }
+    while (fread(hdr, 1, 8, fp) == 8) {
+        len = le32(hdr + 4);
+        if (!memcmp(hdr, "fmt ", 4) && len >= 16) {
+            if (fread(hdr, 1, 16, fp) != 16) break;
+            fmt_ok = le16(hdr) == 1 && le16(hdr + 2) == 1 && le32(hdr + 4) == 12000 &&
+                     le16(hdr + 14) == 16;
+            len -= 16;
+        } else if (!memcmp(hdr, "data", 4)) {
+            if (fmt_ok) {
+                if (len > MAX_WAV_BYTES) len = MAX_WAV_BYTES;
+                n = fread(buf, 1, len, fp) & ~1L;
+            }
+            break;
+        }
+        if (fseek(fp, len + (len & 1), SEEK_CUR)) break;
+    }
+    fclose(fp);
+    return n;
+}
+
+static void *corpus_worker(void *arg) {
+    struct corpus_config *cfg = arg;
+    struct wsprd_options opts = cfg->opts;
+    struct wsprd_stats stats;
+    unsigned char *buf = malloc(MAX_WAV_BYTES);
+    struct wsprd_trace *trace = NULL;
+    char path[4096];
+    struct corpus_file *f;
+    long len;
+    double t0;
+    int i;
+
+    if (cfg->trace_file != NULL) trace = wsprd_trace_alloc(1 << 18);
+    opts.trace = trace;
+    for (;;) {
+        pthread_mutex_lock(&cfg->lock);
+        i = cfg->next_file++;
+        pthread_mutex_unlock(&cfg->lock);
+        if (i >= cfg->nfiles) break;
+        f = &cfg->files[i];
+
+        snprintf(path, sizeof(path), "%s/%s", cfg->dir, f->name);
+        if ((len = read_wav(path, buf)) < 0) {
+            f->error = 1;
+            continue;
+        }
+        if (trace != NULL) wsprd_trace_reset(trace);
+        t0 = wall_seconds();
+        opts.stats = &stats;
+        f->ndecodes = wsprd_decode(buf, len, cfg->dialfreq, 0, &opts, f->decodes,
+                                   WSPRD_MAX_DECODES);
+        f->wall_seconds = wall_seconds() - t0;
+        f->cpu_seconds = stats.total_cpu_seconds;
+
+        if (trace != NULL) {
+            pthread_mutex_lock(&cfg->lock);
+            if (f->wall_seconds > cfg->slowest) {
+                cfg->slowest = f->wall_seconds;
+                if (!wsprd_trace_write(trace, cfg->trace_file)) {
+                    fprintf(stderr, "Cannot write trace %s\n", cfg->trace_file);
+                }
+            }
+            pthread_mutex_unlock(&cfg->lock);
+        }
+    }
+    wsprd_trace_free(trace);
+    free(buf);
+    return NULL;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(((const struct corpus_file *) a)->name, ((const struct corpus_file *) b)->name);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+// Sorted .wav files of the directory; returns their number, or -1
+static int list_wav_files(const char *dir, struct corpus_file **files) {
+    DIR *dp;
+    struct dirent *de;
+    size_t n;
+    int nfiles = 0, size = 0;
+
+    if ((dp = opendir(dir)) == NULL) return -1;
+    *files = NULL;
+    while ((de = readdir(dp)) != NULL) {
+        n = strlen(de->d_name);
+        if (n < 5 || strcmp(de->d_name + n - 4, ".wav")) continue;
+        if (nfiles == size) {
+            size = size ? 2 * size : 256;
+            *files = realloc(*files, sizeof(struct corpus_file) * size);
+        }
+        memset(&(*files)[nfiles], 0, sizeof(struct corpus_file));
+        (*files)[nfiles++].name = strdup(de->d_name);
+    }
+    closedir(dp);
+    if (nfiles > 0) qsort(*files, nfiles, sizeof(struct corpus_file), compare_names);
+    return nfiles;
+}
+
+// Returns the number of entries, or -1 if the file cannot be read
+static int read_golden(const char *filename, struct golden **golden) {
+    char line[256], file[200], message[64];
+    double freq;
+    int n = 0, size = 0;
+    FILE *fp;
+
+    if ((fp = fopen(filename, "r")) == NULL) return -1;
+    *golden = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%199s %lf %63[^\r\n]", file, &freq, message) != 3) continue;
+        if (n == size) {
+            size = size ? 2 * size : 1024;
+            *golden = realloc(*golden, sizeof(struct golden) * size);
+        }
+        (*golden)[n].file = strdup(file);
+        normalize_message(message, (*golden)[n].message);
+        (*golden)[n].found = 0;
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+static int write_golden(const char *filename, const struct corpus_config *cfg) {
+    const struct corpus_file *f;
+    int i, k;
+    FILE *fp;
+
+    if ((fp = fopen(filename, "w")) == NULL) return 0;
+    fprintf(fp, "# file freq_MHz message\n");
+    for (i = 0; i < cfg->nfiles; i++) {
+        f = &cfg->files[i];
+        for (k = 0; k < f->ndecodes; k++) {
+            fprintf(fp, "%s %10.6f %s\n", f->name, f->decodes[k].freq, f->decodes[k].message);
+        }
+    }
+    return fclose(fp) == 0;
+}
+
+// Value below which a fraction p of the sorted values lie
+static double percentile(const double *sorted, int n, double p) {
+    int i = (int) (p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void usage(void) {
+    printf("Usage: wsprcorpus [options...] directory\n");
+    printf("\n");
+    printf("Decodes every .wav file in directory and compares with a golden list.\n");
+    printf("Exits with status 2 if a golden decode was lost.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("       -g file golden list, \"file.wav freq_MHz message\" per line\n");
+    printf("       -w write this run's decodes to the golden list instead of comparing\n");
+    printf("       -f x dial frequency in MHz, default 14.0956\n");
+    printf("       -t worker threads, default 1 (more skew the time per file)\n");
+    printf("       -T file.json write a Chrome trace of the slowest decode\n");
+    printf("       -v list every file and the decodes not in the golden list\n");
+    printf("Decoder options:\n");
+    printf("       -A adaptive cycle budget\n");
+    printf("       -D deep search\n");
+    printf("       -J stack decoder\n");
+    printf("       -o n OSD depth\n");
+    printf("       -p n max passes\n");
+    printf("       -j n decoder threads per decode\n");
+    printf("       -z x Fano metric bias\n");
+}
+
+int main(int argc, char *argv[]) {
+    static struct corpus_config cfg;
+    const char *golden_file = NULL;
+    struct golden *golden = NULL;
+    int nthreads = 1, write = 0, verbose = 0;
+    int ngolden = 0, nfound = 0, nlost = 0, nnew = 0, ndecodes = 0, nerrors = 0;
+    double t0, elapsed, wall = 0, cpu = 0, *times;
+    pthread_t *threads;
+    struct corpus_file *f;
+    char msg[23];
+    int c, i, j, k, is_new;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.dialfreq = 14.0956;
+    wsprd_options_init(&cfg.opts);
+
+    while ((c = getopt(argc, argv, "ADf:g:hj:Jo:p:t:T:vwz:")) != -1) {
+        switch (c) {
+            case 'A':
+                cfg.opts.adaptive_cycles = 1;
+                break;
+            case 'D':
+                cfg.opts.deep_search = 1;
+                break;
+            case 'f':
+                cfg.dialfreq = strtod(optarg, NULL);
+                break;
+            case 'g':
+                golden_file = optarg;
+                break;
+            case 'j':
+                cfg.opts.decode_threads = atoi(optarg);
+                break;
+            case 'J':
+                cfg.opts.stack_decoder = 1;
+                break;
+            case 'o':
+                cfg.opts.osd_depth = atoi(optarg);
+                break;
+            case 'p':
+                cfg.opts.max_passes = atoi(optarg);
+                break;
+            case 't':
+                nthreads = atoi(optarg);
+                break;
+            case 'T':
+                cfg.trace_file = optarg;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            case 'w':
+                write = 1;
+                break;
+            case 'z':
+                cfg.opts.metric_bias = strtof(optarg, NULL);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || (write && golden_file == NULL)) {
+        usage();
+        return 1;
+    }
+    if (nthreads < 1) nthreads = 1;
+    cfg.dir = argv[optind];
+
+    if ((cfg.nfiles = list_wav_files(cfg.dir, &cfg.files)) <= 0) {
+        fprintf(stderr, "No .wav files in %s\n", cfg.dir);
+        return 1;
+    }
+    if (golden_file != NULL && !write && (ngolden = read_golden(golden_file, &golden)) < 0) {
+        fprintf(stderr, "Cannot read golden list %s\n", golden_file);
+        return 1;
+    }
+
+    pthread_mutex_init(&cfg.lock, NULL);
+    threads = malloc(sizeof(pthread_t) * nthreads);
+    t0 = wall_seconds();
+    for (i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, corpus_worker, &cfg);
+    }
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    elapsed = wall_seconds() - t0;
+
+    // Match decodes with the golden list, file by file
+    times = malloc(sizeof(double) * cfg.nfiles);
+    for (i = 0, j = 0; i < cfg.nfiles; i++) {
+        f = &cfg.files[i];
+        if (f->error) {
+            fprintf(stderr, "%s: not a 12 kHz 16-bit mono .wav file\n", f->name);
+            nerrors++;
+            continue;
+        }
+        times[j++] = f->wall_seconds;
+        wall += f->wall_seconds;
+        cpu += f->cpu_seconds;
+        ndecodes += f->ndecodes;
+        if (verbose) {
+            printf("%-24s %8.1f ms %3d decodes\n", f->name, 1e3 * f->wall_seconds, f->ndecodes);
+        }
+        if (golden == NULL) continue;
+        for (k = 0; k < f->ndecodes; k++) {
+            normalize_message(f->decodes[k].message, msg);
+            is_new = 1;
+            for (c = 0; c < ngolden; c++) {
+                if (!strcmp(golden[c].file, f->name) && !strcmp(golden[c].message, msg)) {
+                    if (!golden[c].found) nfound++;
+                    golden[c].found = 1;
+                    is_new = 0;
+                }
+            }
+            if (is_new) {
+                nnew++;
+                if (verbose) printf("  new  %10.6f %s\n", f->decodes[k].freq, msg);
+            }
+        }
+    }
+    for (c = 0; c < ngolden; c++) {
+        if (golden[c].found) continue;
+        nlost++;
+        printf("lost %s %s\n", golden[c].file, golden[c].message);
+    }
+
+    printf("%d files, %d decodes, %.1f s wall, %.1f s decode, %.1f s CPU, %d threads\n",
+           cfg.nfiles - nerrors, ndecodes, elapsed, wall, cpu, nthreads);
+    if (j > 0) {
+        qsort(times, j, sizeof(double), compare_doubles);
+        printf("Per file ms: mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+               1e3 * wall / j, 1e3 * percentile(times, j, 0.5), 1e3 * percentile(times, j, 0.9),
+               1e3 * percentile(times, j, 0.99), 1e3 * times[j - 1]);
+    }
+    if (golden != NULL) {
+        printf("Golden %d: found %d, lost %d, new %d\n", ngolden, nfound, nlost, nnew);
+    }
+    if (write && !write_golden(golden_file, &cfg)) {
+        fprintf(stderr, "Cannot write golden list %s\n", golden_file);
+        return 1;
+    }
+
+    for (i = 0; i < cfg.nfiles; i++) free(cfg.files[i].name);
+    for (c = 0; c < ngolden; c++) free(golden[c].file);
+    free(cfg.files);
+    free(golden);
+    free(times);
+    free(threads);
+    pthread_mutex_destroy(&cfg.lock);
+    return nlost > 0 ? 2 : 0;
+}
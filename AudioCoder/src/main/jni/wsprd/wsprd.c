@@ -34,7 +34,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <time.h>
-#include <jni.h>
+#include <pthread.h>
 #include "fftw3.h"
 
 #include "fano.h"
@@ -42,8 +42,15 @@
 #include "nhash.h"
 #include "wsprd_utils.h"
 #include "wsprsim_utils.h"
+#include "wsprd_decoder.h"
+#include "wsprd_kernels.h"
+#include "osdwspr.h"
+#include "metric_cache.h"
+#include "callhash.h"
+#include "wsprd_trace.h"
 
 #define max(x, y) ((x) > (y) ? (x) : (y))
+#define min(x, y) ((x) < (y) ? (x) : (y))
 #define WSPR_NUMSYMBOLS 162
 
 
@@ -52,6 +59,37 @@
 #define PATIENCE FFTW_ESTIMATE
 fftwf_plan PLAN1, PLAN2, PLAN3;
 
+/*
+ * The FFTW planner is not thread-safe, so wsprd_decode() makes and
+ * destroys its plans under this lock; executing them needs none. With
+ * no other shared state, several decodes can then run at once.
+ */
+static pthread_mutex_t fftw_planner_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static fftwf_plan plan_dft_1d(int n, fftwf_complex *in, fftwf_complex *out, int sign) {
+    fftwf_plan plan;
+
+    pthread_mutex_lock(&fftw_planner_lock);
+    plan = fftwf_plan_dft_1d(n, in, out, sign, PATIENCE);
+    pthread_mutex_unlock(&fftw_planner_lock);
+    return plan;
+}
+
+static fftwf_plan plan_dft_r2c_1d(int n, float *in, fftwf_complex *out) {
+    fftwf_plan plan;
+
+    pthread_mutex_lock(&fftw_planner_lock);
+    plan = fftwf_plan_dft_r2c_1d(n, in, out, PATIENCE);
+    pthread_mutex_unlock(&fftw_planner_lock);
+    return plan;
+}
+
+static void destroy_plan(fftwf_plan plan) {
+    pthread_mutex_lock(&fftw_planner_lock);
+    fftwf_destroy_plan(plan);
+    pthread_mutex_unlock(&fftw_planner_lock);
+}
+
 unsigned char pr3[WSPR_NUMSYMBOLS] =
         {1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0,
          0, 1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1,
@@ -65,6 +103,60 @@ unsigned char pr3[WSPR_NUMSYMBOLS] =
 
 int printdata = 0;
 
+// Block lengths usable by noncoherent block detection, in the order tried
+static const int block_lengths[] = {1, 2, 3, 6, 9};
+#define NBLOCK_LENGTHS (sizeof(block_lengths) / sizeof(block_lengths[0]))
+
+void wsprd_options_init(struct wsprd_options *opts) {
+    memset(opts, 0, sizeof(struct wsprd_options));
+    opts->deep_search = 0;
+    opts->max_passes = 2;
+    opts->deadline_ms = 0;
+    opts->osd_depth = -1;
+    opts->stack_decoder = 0;
+    opts->decode_threads = 1;
+    opts->adaptive_cycles = 0;
+    opts->metric_bias = WSPRD_DEFAULT_BIAS;
+    opts->callhash = NULL;
+    opts->cycle_stats = NULL;
+    opts->stats = NULL;
+    opts->trace = NULL;
+}
+
+// Monotonic wall clock in seconds; clock() counts CPU time, not elapsed time
+static double wsprd_wallclock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// CPU time of the calling thread in seconds
+static double wsprd_cpuclock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Start of a stage timed into wsprd_stats
+struct stage_clock {
+    double wall, cpu;
+};
+
+static void stage_start(struct stage_clock *c) {
+    c->wall = wsprd_wallclock();
+    c->cpu = wsprd_cpuclock();
+}
+
+static void stage_stop(struct wsprd_stats *stats, int stage, const struct stage_clock *c) {
+    stats->wall_seconds[stage] += wsprd_wallclock() - c->wall;
+    stats->cpu_seconds[stage] += wsprd_cpuclock() - c->cpu;
+}
+
+static int wsprd_past_deadline(const struct wsprd_options *opts, double t0) {
+    if (opts->deadline_ms <= 0) return 0;
+    return (wsprd_wallclock() - t0) * 1000.0 >= opts->deadline_ms;
+}
+
 //***************************************************************************
 unsigned long readc2file(char *ptr_to_infile, float *idat, float *qdat,
                          double *freq, int *wspr_type) {
@@ -184,6 +276,94 @@ unsigned long readwavfile(char *ptr_to_infile, int ntrmin, float *idat, float *q
     return nfft2;
 }
 
+/***************************************************************************
+ Spectrogram of the whole recording: windowed 512-point FFTs over 2
+ symbols, stepped by half symbols. ps[j][i] is the power in bin j (256 is
+ 0 Hz) of FFT i, psavg[j] its sum over all FFTs. plan transforms fftin
+ into fftout.
+ ****************************************************************************/
+void compute_spectrogram(float *idat, float *qdat, int nffts, const float *w,
+                         fftwf_complex *fftin, fftwf_complex *fftout, fftwf_plan plan,
+                         float ps[][nffts], float *psavg) {
+    int i, j, k;
+
+    for (i = 0; i < nffts; i++) {
+        for (j = 0; j < 512; j++) {
+            k = i * 128 + j;
+            fftin[j][0] = idat[k] * w[j];
+            fftin[j][1] = qdat[k] * w[j];
+        }
+        fftwf_execute(plan);
+        for (j = 0; j < 512; j++) {
+            k = j + 256;
+            if (k > 511)
+                k = k - 512;
+            ps[j][i] = fftout[k][0] * fftout[k][0] + fftout[k][1] * fftout[k][1];
+        }
+    }
+
+    // Compute average power spectrum across all time windows
+    for (i = 0; i < 512; i++) psavg[i] = 0.0;
+    for (i = 0; i < nffts; i++) {
+        for (j = 0; j < 512; j++) {
+            psavg[j] = psavg[j] + ps[j][i];
+        }
+    }
+}
+
+/***************************************************************************
+ Coarse estimation of time shift (DT), frequency, and drift for each of
+ the npk candidates at frequencies freq0[], from the spectrogram. This
+ narrows down the search space before fine refinement; freq0[] is
+ replaced by the best frequency found.
+ ****************************************************************************/
+void coarse_candidate_search(int nffts, float ps[][nffts], int npk, int maxdrift,
+                             float *freq0, int *shift0, float *drift0, float *sync0) {
+    float df = 375.0 / 256.0 / 2;
+    int idrift, ifr, if0, ifd, j, k, k0;
+    int kindex;
+    float smax, ss, pow, p0, p1, p2, p3, sync1;
+
+    for (j = 0; j < npk; j++) {
+        smax = -1e30;
+        if0 = freq0[j] / df + 256;
+        for (ifr = if0 - 2; ifr <= if0 + 2; ifr++) {
+            for (k0 = -10; k0 < 22; k0++) {
+                for (idrift = -maxdrift; idrift <= maxdrift; idrift++) {
+                    ss = 0.0;
+                    pow = 0.0;
+                    for (k = 0; k < WSPR_NUMSYMBOLS; k++) {
+                        ifd = ifr + ((float) k - 81.0) / 81.0 * ((float) idrift) / (2.0 * df);
+                        kindex = k0 + 2 * k;
+                        if (kindex < nffts) {
+                            p0 = ps[ifd - 3][kindex];
+                            p1 = ps[ifd - 1][kindex];
+                            p2 = ps[ifd + 1][kindex];
+                            p3 = ps[ifd + 3][kindex];
+
+                            p0 = sqrt(p0);
+                            p1 = sqrt(p1);
+                            p2 = sqrt(p2);
+                            p3 = sqrt(p3);
+
+                            ss = ss + (2 * pr3[k] - 1) * ((p1 + p3) - (p0 + p2));
+                            pow = pow + p0 + p1 + p2 + p3;
+                        }
+                    }
+                    sync1 = ss / pow;
+                    if (sync1 > smax) {
+                        smax = sync1;
+                        shift0[j] = 128 * (k0 + 1);
+                        drift0[j] = idrift;
+                        freq0[j] = (ifr - 256) * df;
+                        sync0[j] = sync1;
+                    }
+                }
+            }
+        }
+    }
+}
+
 //***************************************************************************
 void sync_and_demodulate(float *id, float *qd, long np,
                          unsigned char *symbols, float *f1, int ifmin, int ifmax, float fstep,
@@ -196,7 +376,7 @@ void sync_and_demodulate(float *id, float *qd, long np,
      *           symbols using passed frequency and shift.                  *
      ************************************************************************/
 
-    static float fplast = -10000.0;
+    float fplast = -10000.0;
     static float dt = 1.0 / 375.0, df = 375.0 / 256.0;
     static float pi = 3.14159265358979323846;
     float twopidt, df15 = df * 1.5, df05 = df * 0.5;
@@ -354,144 +534,353 @@ void sync_and_demodulate(float *id, float *qd, long np,
     return;
 }
 
-void noncoherent_sequence_detection(float *id, float *qd, long np,
-                                    unsigned char *symbols, float *f1, int *shift1,
-                                    float *drift1, int symfac, int *nblocksize) {
+//***************************************************************************
+#define SYNC_GRID_MAXHYP 8
+#define SYNC_GRID_MAXLAG 64
+
+void sync_search_grid(float *id, float *qd, long np,
+                      float f0, int ifmin, int ifmax, float fstep,
+                      int lagmin, int lagmax, int lagstep,
+                      float *drifts, int ndrift,
+                      float *f1, int *shift1, float *drift1, float *sync,
+                      float *hsync) {
     /************************************************************************
-     *  Noncoherent sequence detection for wspr.                            *
-     *  Allowed block lengths are nblock=1,2,3,6, or 9 symbols.             *
-     *  Longer block lengths require longer channel coherence time.         *
-     *  The whole block is estimated at once.                               *
-     *  nblock=1 corresponds to noncoherent detection of individual symbols *
-     *     like the original wsprd symbol demodulator.                      *
+     * Single-pass evaluation of the sync metric over a grid of             *
+     * (drift, frequency, lag) hypotheses. Frequencies are f0+ifreq*fstep   *
+     * for ifreq=ifmin..ifmax, lags run from lagmin to lagmax in lagstep    *
+     * increments and drifts are taken from drifts[0..ndrift-1].            *
+     *                                                                      *
+     * Each symbol's samples are loaded once per lag and correlated against *
+     * the tone oscillators of every (drift, frequency) hypothesis; the     *
+     * oscillators are generated once per symbol rather than once per lag.  *
+     * Summation order matches sync_and_demodulate() modes 0 and 1, so the  *
+     * metric values are identical.                                         *
+     *                                                                      *
+     * The best hypothesis is returned in f1, shift1, drift1 and sync.      *
+     * Ties go to the first hypothesis in drift, frequency, lag order.      *
+     * If hsync is not NULL it receives every metric value, laid out as     *
+     * hsync[(idrift*nfreq+ifreq)*nlag+ilag].                               *
      ************************************************************************/
-    static float fplast = -10000.0;
     static float dt = 1.0 / 375.0, df = 375.0 / 256.0;
     static float pi = 3.14159265358979323846;
-    float twopidt, df15 = df * 1.5, df05 = df * 0.5;
-
-    int i, j, k, lag, itone, ib, b, nblock, nseq, imask;
-    float xi[512], xq[512];
-    float is[4][WSPR_NUMSYMBOLS], qs[4][WSPR_NUMSYMBOLS], cf[4][WSPR_NUMSYMBOLS], sf[4][WSPR_NUMSYMBOLS], cm, sm, cmp, smp;
-    float p[512], fac, xm1, xm0;
-    float c0[257], s0[257], c1[257], s1[257], c2[257], s2[257], c3[257], s3[257];
-    float dphi0, cdphi0, sdphi0, dphi1, cdphi1, sdphi1, dphi2, cdphi2, sdphi2,
-            dphi3, cdphi3, sdphi3;
-    float f0, fp, fsum = 0.0, f2sum = 0.0, fsymb[WSPR_NUMSYMBOLS];
+    float twopidt = 2 * pi * dt, df15 = df * 1.5, df05 = df * 0.5;
+    float toff[4] = {-df15, -df05, df05, df15};
+
+    float osc_c[SYNC_GRID_MAXHYP][4][256], osc_s[SYNC_GRID_MAXHYP][4][256];
+    float fplast[SYNC_GRID_MAXHYP], fhyp[SYNC_GRID_MAXHYP], dhyp[SYNC_GRID_MAXHYP];
+    float ss[SYNC_GRID_MAXHYP][SYNC_GRID_MAXLAG], totp[SYNC_GRID_MAXHYP][SYNC_GRID_MAXLAG];
+    float is[SYNC_GRID_MAXHYP][4], qs[SYNC_GRID_MAXHYP][4];
+    float fp, dphi, cdphi, sdphi, p[4], cmet, syncmax, s;
+    int nfreq, nlag, nhyp, h, t, i, j, k, l, lag, best_h = 0, best_l = 0;
+
+    nfreq = ifmax - ifmin + 1;
+    nlag = (lagstep > 0) ? (lagmax - lagmin) / lagstep + 1 : 1;
+    nhyp = nfreq * ndrift;
+    if (nhyp < 1 || nhyp > SYNC_GRID_MAXHYP || nlag < 1 || nlag > SYNC_GRID_MAXLAG) {
+        fprintf(stderr, "sync_search_grid: %d hypotheses x %d lags is out of range\n", nhyp, nlag);
+        *sync = -1e30;
+        return;
+    }
 
-    twopidt = 2 * pi * dt;
-    f0 = *f1;
-    lag = *shift1;
-    nblock = *nblocksize;
-    nseq = 1 << nblock;
+    for (h = 0; h < nhyp; h++) {
+        dhyp[h] = drifts[h / nfreq];
+        fhyp[h] = f0 + (ifmin + h % nfreq) * fstep;
+        for (l = 0; l < nlag; l++) {
+            ss[h][l] = 0.0;
+            totp[h][l] = 0.0;
+        }
+    }
 
     for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
-        fp = f0 + (*drift1 / 2.0) * ((float) i - 81.0) / 81.0;
-        if (i == 0 || (fp != fplast)) {  // only calculate sin/cos if necessary
-            dphi0 = twopidt * (fp - df15);
-            cdphi0 = cos(dphi0);
-            sdphi0 = sin(dphi0);
-
-            dphi1 = twopidt * (fp - df05);
-            cdphi1 = cos(dphi1);
-            sdphi1 = sin(dphi1);
-
-            dphi2 = twopidt * (fp + df05);
-            cdphi2 = cos(dphi2);
-            sdphi2 = sin(dphi2);
-
-            dphi3 = twopidt * (fp + df15);
-            cdphi3 = cos(dphi3);
-            sdphi3 = sin(dphi3);
-
-            c0[0] = 1;
-            s0[0] = 0;
-            c1[0] = 1;
-            s1[0] = 0;
-            c2[0] = 1;
-            s2[0] = 0;
-            c3[0] = 1;
-            s3[0] = 0;
-
-            for (j = 1; j < 257; j++) {
-                c0[j] = c0[j - 1] * cdphi0 - s0[j - 1] * sdphi0;
-                s0[j] = c0[j - 1] * sdphi0 + s0[j - 1] * cdphi0;
-                c1[j] = c1[j - 1] * cdphi1 - s1[j - 1] * sdphi1;
-                s1[j] = c1[j - 1] * sdphi1 + s1[j - 1] * cdphi1;
-                c2[j] = c2[j - 1] * cdphi2 - s2[j - 1] * sdphi2;
-                s2[j] = c2[j - 1] * sdphi2 + s2[j - 1] * cdphi2;
-                c3[j] = c3[j - 1] * cdphi3 - s3[j - 1] * sdphi3;
-                s3[j] = c3[j - 1] * sdphi3 + s3[j - 1] * cdphi3;
+        for (h = 0; h < nhyp; h++) {
+            fp = fhyp[h] + (dhyp[h] / 2.0) * ((float) i - 81.0) / 81.0;
+            if (i == 0 || (fp != fplast[h])) {  // only calculate sin/cos if necessary
+                for (t = 0; t < 4; t++) {
+                    dphi = twopidt * (fp + toff[t]);
+                    cdphi = cos(dphi);
+                    sdphi = sin(dphi);
+                    osc_c[h][t][0] = 1;
+                    osc_s[h][t][0] = 0;
+                    for (j = 1; j < 256; j++) {
+                        osc_c[h][t][j] = osc_c[h][t][j - 1] * cdphi - osc_s[h][t][j - 1] * sdphi;
+                        osc_s[h][t][j] = osc_c[h][t][j - 1] * sdphi + osc_s[h][t][j - 1] * cdphi;
+                    }
+                }
+                fplast[h] = fp;
+            }
+        }
+
+        for (l = 0; l < nlag; l++) {
+            lag = lagmin + l * lagstep;
+            memset(is, 0, sizeof(is));
+            memset(qs, 0, sizeof(qs));
+            for (j = 0; j < 256; j++) {
+                k = lag + i * 256 + j;
+                if ((k > 0) && (k < np)) {
+                    float x = id[k], y = qd[k];
+                    for (h = 0; h < nhyp; h++) {
+                        for (t = 0; t < 4; t++) {
+                            is[h][t] = is[h][t] + x * osc_c[h][t][j] + y * osc_s[h][t][j];
+                            qs[h][t] = qs[h][t] - x * osc_s[h][t][j] + y * osc_c[h][t][j];
+                        }
+                    }
+                }
             }
+            for (h = 0; h < nhyp; h++) {
+                for (t = 0; t < 4; t++) {
+                    p[t] = sqrt(is[h][t] * is[h][t] + qs[h][t] * qs[h][t]);
+                }
+                totp[h][l] = totp[h][l] + p[0] + p[1] + p[2] + p[3];
+                cmet = (p[1] + p[3]) - (p[0] + p[2]);
+                ss[h][l] = (pr3[i] == 1) ? ss[h][l] + cmet : ss[h][l] - cmet;
+            }
+        }
+    }
+
+    syncmax = -1e30;
+    for (h = 0; h < nhyp; h++) {
+        for (l = 0; l < nlag; l++) {
+            s = ss[h][l] / totp[h][l];
+            if (hsync) hsync[h * nlag + l] = s;
+            if (s > syncmax) {
+                syncmax = s;
+                best_h = h;
+                best_l = l;
+            }
+        }
+    }
+
+    *sync = syncmax;
+    *shift1 = lagmin + best_l * lagstep;
+    *f1 = fhyp[best_h];
+    *drift1 = dhyp[best_h];
+}
+
+/***************************************************************************
+ Symbol correlation bank for noncoherent block demodulation.
+
+ The block demodulator is run at up to 2*njitter+1 time lags spaced lagstep
+ samples around the refined shift, for each block size. The 4x162 complex
+ tone correlations at the base lag are computed directly; those at the
+ jittered lags are derived from their neighbour by sliding the 256-sample
+ window lagstep samples, which only touches 2*lagstep samples per symbol:
+
+   C(L+d) = osc[d] * (C(L) - sum_{m<d} x[m] osc*[m] + sum_{256<=m<256+d} x[m] osc*[m])
+
+ All jitter lags and all block sizes of a candidate share the bank.
+ ****************************************************************************/
+#define NCS_MAXSTEP 32
+#define NCS_OSCLEN (257 + NCS_MAXSTEP)
+
+struct symbol_corr_bank {
+    int njitter, lagstep, lag0, filled;
+    float f0, drift, fplast;
+    float cf[4][WSPR_NUMSYMBOLS], sf[4][WSPR_NUMSYMBOLS];
+    float oc[4][NCS_OSCLEN], os[4][NCS_OSCLEN];
+    float (*is)[4][WSPR_NUMSYMBOLS], (*qs)[4][WSPR_NUMSYMBOLS];
+};
+
+struct symbol_corr_bank *symbol_corr_bank_alloc(int njitter) {
+    struct symbol_corr_bank *bank;
+    bank = calloc(1, sizeof(struct symbol_corr_bank));
+    bank->njitter = njitter;
+    bank->is = calloc(2 * njitter + 1, sizeof(*bank->is));
+    bank->qs = calloc(2 * njitter + 1, sizeof(*bank->qs));
+    return bank;
+}
+
+void symbol_corr_bank_free(struct symbol_corr_bank *bank) {
+    if (bank == NULL) return;
+    free(bank->is);
+    free(bank->qs);
+    free(bank);
+}
 
-            fplast = fp;
+// Tone oscillators for symbol i, indices 0..256+lagstep
+static void symbol_corr_bank_osc(struct symbol_corr_bank *bank, int i) {
+    static float dt = 1.0 / 375.0, df = 375.0 / 256.0;
+    static float pi = 3.14159265358979323846;
+    float toff[4] = {-df * 1.5f, -df * 0.5f, df * 0.5f, df * 1.5f};
+    float fp, dphi, cdphi, sdphi;
+    int t, j, n = 257 + bank->lagstep;
+
+    fp = bank->f0 + (bank->drift / 2.0) * ((float) i - 81.0) / 81.0;
+    if (i != 0 && fp == bank->fplast) return;  // only calculate sin/cos if necessary
+    for (t = 0; t < 4; t++) {
+        dphi = 2 * pi * dt * (fp + toff[t]);
+        cdphi = cos(dphi);
+        sdphi = sin(dphi);
+        bank->oc[t][0] = 1;
+        bank->os[t][0] = 0;
+        for (j = 1; j < n; j++) {
+            bank->oc[t][j] = bank->oc[t][j - 1] * cdphi - bank->os[t][j - 1] * sdphi;
+            bank->os[t][j] = bank->oc[t][j - 1] * sdphi + bank->os[t][j - 1] * cdphi;
         }
+    }
+    bank->fplast = fp;
+}
 
-        cf[0][i] = c0[256];
-        sf[0][i] = s0[256];
-        cf[1][i] = c1[256];
-        sf[1][i] = s1[256];
-        cf[2][i] = c2[256];
-        sf[2][i] = s2[256];
-        cf[3][i] = c3[256];
-        sf[3][i] = s3[256];
+/*
+ * Point the bank at a new candidate and compute the correlations at the
+ * base lag. The jittered lags are filled in on first use.
+ */
+void symbol_corr_bank_init(struct symbol_corr_bank *bank, float *id, float *qd, long np,
+                           float f0, int lag0, float drift, int lagstep) {
+    int i, j, k, t;
+    float (*is)[WSPR_NUMSYMBOLS], (*qs)[WSPR_NUMSYMBOLS];
+
+    bank->f0 = f0;
+    bank->lag0 = lag0;
+    bank->drift = drift;
+    bank->lagstep = (lagstep > 0 && lagstep <= NCS_MAXSTEP) ? lagstep : 0;
+    bank->filled = 0;
+    is = bank->is[bank->njitter];
+    qs = bank->qs[bank->njitter];
 
-        is[0][i] = 0.0;
-        qs[0][i] = 0.0;
-        is[1][i] = 0.0;
-        qs[1][i] = 0.0;
-        is[2][i] = 0.0;
-        qs[2][i] = 0.0;
-        is[3][i] = 0.0;
-        qs[3][i] = 0.0;
+    for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
+        float ai[4] = {0.0, 0.0, 0.0, 0.0}, aq[4] = {0.0, 0.0, 0.0, 0.0};
+        const float (*oc)[NCS_OSCLEN] = bank->oc, (*os)[NCS_OSCLEN] = bank->os;
 
+        symbol_corr_bank_osc(bank, i);
         for (j = 0; j < 256; j++) {
-            k = lag + i * 256 + j;
+            k = lag0 + i * 256 + j;
             if ((k > 0) && (k < np)) {
-                is[0][i] = is[0][i] + id[k] * c0[j] + qd[k] * s0[j];
-                qs[0][i] = qs[0][i] - id[k] * s0[j] + qd[k] * c0[j];
-                is[1][i] = is[1][i] + id[k] * c1[j] + qd[k] * s1[j];
-                qs[1][i] = qs[1][i] - id[k] * s1[j] + qd[k] * c1[j];
-                is[2][i] = is[2][i] + id[k] * c2[j] + qd[k] * s2[j];
-                qs[2][i] = qs[2][i] - id[k] * s2[j] + qd[k] * c2[j];
-                is[3][i] = is[3][i] + id[k] * c3[j] + qd[k] * s3[j];
-                qs[3][i] = qs[3][i] - id[k] * s3[j] + qd[k] * c3[j];
+                float x = id[k], y = qd[k];
+                for (t = 0; t < 4; t++) {
+                    ai[t] = ai[t] + x * oc[t][j] + y * os[t][j];
+                    aq[t] = aq[t] - x * os[t][j] + y * oc[t][j];
+                }
+            }
+        }
+        for (t = 0; t < 4; t++) {
+            bank->cf[t][i] = oc[t][256];
+            bank->sf[t][i] = os[t][256];
+            is[t][i] = ai[t];
+            qs[t][i] = aq[t];
+        }
+    }
+}
+
+// Derive all jittered lags from the base lag by sliding the symbol windows
+static void symbol_corr_bank_fill(struct symbol_corr_bank *bank, float *id, float *qd, long np) {
+    int i, j, k, m, t, e, dir, nj = bank->njitter, d = bank->lagstep;
+    float xi, xq, ai, aq, c, s;
+
+    for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
+        symbol_corr_bank_osc(bank, i);
+        for (t = 0; t < 4; t++) {
+            float *oc = bank->oc[t], *os = bank->os[t];
+            for (dir = -1; dir <= 1; dir += 2) {
+                for (j = 1; j <= nj; j++) {
+                    e = nj + dir * j;
+                    ai = bank->is[e - dir][t][i];
+                    aq = bank->qs[e - dir][t][i];
+                    // window of the neighbouring lag starts at sample k
+                    k = bank->lag0 + dir * (j - 1) * d + i * 256;
+                    for (m = 0; m < d; m++) {
+                        // leaving and entering samples, osc*[m] at the leading edge
+                        int kl = (dir > 0) ? k + m : k + 256 - d + m;
+                        int ke = (dir > 0) ? k + 256 + m : k - d + m;
+                        int ml = (dir > 0) ? m : 256 - d + m;
+                        int me = (dir > 0) ? 256 + m : d - m;
+                        if ((kl > 0) && (kl < np)) {
+                            xi = id[kl];
+                            xq = qd[kl];
+                            ai = ai - (xi * oc[ml] + xq * os[ml]);
+                            aq = aq - (xq * oc[ml] - xi * os[ml]);
+                        }
+                        if ((ke > 0) && (ke < np)) {
+                            xi = id[ke];
+                            xq = qd[ke];
+                            if (dir > 0) {
+                                ai = ai + (xi * oc[me] + xq * os[me]);
+                                aq = aq + (xq * oc[me] - xi * os[me]);
+                            } else {
+                                // osc*[-n] = osc[n]
+                                ai = ai + (xi * oc[me] - xq * os[me]);
+                                aq = aq + (xq * oc[me] + xi * os[me]);
+                            }
+                        }
+                    }
+                    // rotate by osc[d] (right) or osc*[d] (left)
+                    c = oc[d];
+                    s = dir * os[d];
+                    bank->is[e][t][i] = ai * c - aq * s;
+                    bank->qs[e][t][i] = ai * s + aq * c;
+                }
             }
         }
     }
+    bank->filled = 1;
+}
+
+/*
+ * Block detection on one set of tone correlations: estimate each block of
+ * nblock symbols jointly and produce normalized soft symbols. Allowed block
+ * lengths are 1, 2, 3, 6 and 9.
+ *
+ * The 2^nblock candidate sequences are enumerated as a binary tree, one
+ * level per symbol, so sequences sharing a prefix share its partial sum and
+ * phasor; each level costs one complex update per node instead of one per
+ * sequence and symbol. Per-bit maxima are taken over squared magnitudes and
+ * only the two winners are square-rooted.
+ */
+void noncoherent_block_detection(float is[4][WSPR_NUMSYMBOLS], float qs[4][WSPR_NUMSYMBOLS],
+                                 float cf[4][WSPR_NUMSYMBOLS], float sf[4][WSPR_NUMSYMBOLS],
+                                 int nblock, int symfac, unsigned char *symbols) {
+    int i, j, ib, b, itone, nb, nseq, imask;
+    float xi[2][512], xq[2][512], cm[2][512], sm[2][512], p[512];
+    float cmp, smp, fac, xm1, xm0, isv, qsv, cfv, sfv;
+    float fsum = 0.0, f2sum = 0.0, fsymb[WSPR_NUMSYMBOLS];
+
+    if (nblock < 1) nblock = 1;
+    if (nblock > 9) nblock = 9;
 
     for (i = 0; i < WSPR_NUMSYMBOLS; i = i + nblock) {
-        for (j = 0; j < nseq; j++) {
-            xi[j] = 0.0;
-            xq[j] = 0.0;
-            cm = 1;
-            sm = 0;
-            for (ib = 0; ib < nblock; ib++) {
-                b = (j & (1 << (nblock - 1 - ib))) >> (nblock - 1 - ib);
+        nb = (i + nblock <= WSPR_NUMSYMBOLS) ? nblock : WSPR_NUMSYMBOLS - i;
+        nseq = 1 << nb;
+
+        // Level 0 is the empty prefix; level ib+1 appends symbol i+ib
+        int cur = 0, nxt;
+        xi[0][0] = 0.0;
+        xq[0][0] = 0.0;
+        cm[0][0] = 1;
+        sm[0][0] = 0;
+        for (ib = 0; ib < nb; ib++) {
+            nxt = cur ^ 1;
+            for (b = 0; b < 2; b++) {
                 itone = pr3[i + ib] + 2 * b;
-                xi[j] = xi[j] + is[itone][i + ib] * cm + qs[itone][i + ib] * sm;
-                xq[j] = xq[j] + qs[itone][i + ib] * cm - is[itone][i + ib] * sm;
-                cmp = cf[itone][i + ib] * cm - sf[itone][i + ib] * sm;
-                smp = sf[itone][i + ib] * cm + cf[itone][i + ib] * sm;
-                cm = cmp;
-                sm = smp;
+                isv = is[itone][i + ib];
+                qsv = qs[itone][i + ib];
+                cfv = cf[itone][i + ib];
+                sfv = sf[itone][i + ib];
+                for (j = 0; j < (1 << ib); j++) {
+                    float c = cm[cur][j], s = sm[cur][j];
+                    xi[nxt][2 * j + b] = xi[cur][j] + isv * c + qsv * s;
+                    xq[nxt][2 * j + b] = xq[cur][j] + qsv * c - isv * s;
+                    cmp = cfv * c - sfv * s;
+                    smp = sfv * c + cfv * s;
+                    cm[nxt][2 * j + b] = cmp;
+                    sm[nxt][2 * j + b] = smp;
+                }
             }
-            p[j] = xi[j] * xi[j] + xq[j] * xq[j];
-            p[j] = sqrt(p[j]);
+            cur = nxt;
+        }
+        for (j = 0; j < nseq; j++) {
+            p[j] = xi[cur][j] * xi[cur][j] + xq[cur][j] * xq[cur][j];
         }
-        for (ib = 0; ib < nblock; ib++) {
-            imask = 1 << (nblock - 1 - ib);
+        for (ib = 0; ib < nb; ib++) {
+            imask = 1 << (nb - 1 - ib);
             xm1 = 0.0;
             xm0 = 0.0;
             for (j = 0; j < nseq; j++) {
                 if ((j & imask) != 0) {
                     if (p[j] > xm1) xm1 = p[j];
-                }
-                if ((j & imask) == 0) {
+                } else {
                     if (p[j] > xm0) xm0 = p[j];
                 }
             }
-            fsymb[i + ib] = xm1 - xm0;
+            fsymb[i + ib] = sqrtf(xm1) - sqrtf(xm0);
         }
     }
     for (i = 0; i < WSPR_NUMSYMBOLS; i++) {              //Normalize the soft symbols
@@ -505,7 +894,56 @@ void noncoherent_sequence_detection(float *id, float *qd, long np,
         if (fsymb[i] < -128) fsymb[i] = -128.0;
         symbols[i] = fsymb[i] + 128;
     }
-    return;
+}
+
+/*
+ * Soft symbols for the candidate in the bank at the given lag. Lags that
+ * are not on the bank's jitter grid are correlated directly.
+ */
+void symbol_corr_bank_detect(struct symbol_corr_bank *bank, float *id, float *qd, long np,
+                             int lag, int nblock, int symfac, unsigned char *symbols) {
+    int e = bank->njitter, off = lag - bank->lag0;
+
+    if (off != 0) {
+        if (bank->lagstep == 0 || off % bank->lagstep != 0 ||
+            abs(off / bank->lagstep) > bank->njitter) {
+            struct symbol_corr_bank *tmp = symbol_corr_bank_alloc(0);
+            symbol_corr_bank_init(tmp, id, qd, np, bank->f0, lag, bank->drift, 0);
+            noncoherent_block_detection(tmp->is[0], tmp->qs[0], tmp->cf, tmp->sf,
+                                        nblock, symfac, symbols);
+            symbol_corr_bank_free(tmp);
+            return;
+        }
+        if (!bank->filled) symbol_corr_bank_fill(bank, id, qd, np);
+        e += off / bank->lagstep;
+    }
+    noncoherent_block_detection(bank->is[e], bank->qs[e], bank->cf, bank->sf,
+                                nblock, symfac, symbols);
+}
+
+// Slide out every jittered lag now, so later detects only read the bank
+void symbol_corr_bank_prepare(struct symbol_corr_bank *bank, float *id, float *qd, long np) {
+    if (bank->lagstep != 0 && !bank->filled) symbol_corr_bank_fill(bank, id, qd, np);
+}
+
+void noncoherent_sequence_detection(float *id, float *qd, long np,
+                                    unsigned char *symbols, float *f1, int *shift1,
+                                    float *drift1, int symfac, int *nblocksize) {
+    /************************************************************************
+     *  Noncoherent sequence detection for wspr.                            *
+     *  Allowed block lengths are nblock=1,2,3,6, or 9 symbols.             *
+     *  Longer block lengths require longer channel coherence time.         *
+     *  The whole block is estimated at once.                               *
+     *  nblock=1 corresponds to noncoherent detection of individual symbols *
+     *     like the original wsprd symbol demodulator.                      *
+     *  Callers trying several lags around one shift should use a          *
+     *  symbol_corr_bank instead.                                           *
+     ************************************************************************/
+    struct symbol_corr_bank *bank = symbol_corr_bank_alloc(0);
+    symbol_corr_bank_init(bank, id, qd, np, *f1, *shift1, *drift1, 0);
+    noncoherent_block_detection(bank->is[0], bank->qs[0], bank->cf, bank->sf,
+                                *nblocksize, symfac, symbols);
+    symbol_corr_bank_free(bank);
 }
 
 /***************************************************************************
@@ -680,7 +1118,618 @@ void subtract_signal2(float *id, float *qd, long np,
     free(cfi);
     free(cfq);
 
-    return;
+    return;
+}
+
+/***************************************************************************
+ Per-decode context: scratch memory and FFT plans used by the candidate
+ loop, allocated once per decoder call instead of once per signal.
+ ****************************************************************************/
+#define SUBTRACT_NFILT 256                           // must be even
+#define SUBTRACT_NFFT 2048                           // overlap-save block size
+#define SUBTRACT_NSTEP (SUBTRACT_NFFT - SUBTRACT_NFILT + 1)
+#define SUBTRACT_NSIG (WSPR_NUMSYMBOLS * 256)
+
+struct wsprd_context {
+    struct symbol_corr_bank *corrbank;
+    float *refi, *refq;              // reference signal r(t)
+    float *ci, *cq;                  // s(t)*conjugate(r(t))
+    float *cfi, *cfq;                // low-pass filtered complex amplitude c(t)
+    fftwf_complex *fbuf, *hfilt;     // overlap-save block, filter response
+    fftwf_plan pfwd, pinv;
+    float partialsum[SUBTRACT_NFILT];
+    struct fano_arena *fano;         // nodes for every Fano decode of the run
+    struct jelinek_workspace *jelinek;  // stack decoder state, when selected
+};
+
+struct wsprd_context *wsprd_context_alloc(int njitter) {
+    struct wsprd_context *ctx;
+    float pi = 4. * atan(1.0), w[SUBTRACT_NFILT], norm = 0;
+    int i, nfilt = SUBTRACT_NFILT;
+
+    ctx = calloc(1, sizeof(struct wsprd_context));
+    ctx->corrbank = symbol_corr_bank_alloc(njitter);
+    ctx->fano = fano_arena_alloc(81);
+    ctx->refi = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->refq = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->ci = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->cq = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->cfi = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->cfq = calloc(SUBTRACT_NSIG, sizeof(float));
+    ctx->fbuf = fftwf_malloc(sizeof(fftwf_complex) * SUBTRACT_NFFT);
+    ctx->hfilt = fftwf_malloc(sizeof(fftwf_complex) * SUBTRACT_NFFT);
+    ctx->pfwd = plan_dft_1d(SUBTRACT_NFFT, ctx->fbuf, ctx->fbuf, FFTW_FORWARD);
+    ctx->pinv = plan_dft_1d(SUBTRACT_NFFT, ctx->fbuf, ctx->fbuf, FFTW_BACKWARD);
+
+    // Sine-window lowpass, same taps as subtract_signal2()
+    for (i = 0; i < nfilt; i++) {
+        w[i] = sin(pi * (float) i / (float) (nfilt - 1));
+        norm = norm + w[i];
+    }
+    for (i = 0; i < nfilt; i++) {
+        w[i] = w[i] / norm;
+    }
+    ctx->partialsum[0] = 0.0;
+    for (i = 1; i < nfilt; i++) {
+        ctx->partialsum[i] = ctx->partialsum[i - 1] + w[i];
+    }
+
+    // Frequency response of the time-reversed taps, with the 1/N of the inverse FFT folded in
+    memset(ctx->fbuf, 0, sizeof(fftwf_complex) * SUBTRACT_NFFT);
+    for (i = 0; i < nfilt; i++) {
+        ctx->fbuf[i][0] = w[nfilt - 1 - i] / SUBTRACT_NFFT;
+    }
+    fftwf_execute(ctx->pfwd);
+    memcpy(ctx->hfilt, ctx->fbuf, sizeof(fftwf_complex) * SUBTRACT_NFFT);
+
+    return ctx;
+}
+
+void wsprd_context_free(struct wsprd_context *ctx) {
+    if (ctx == NULL) return;
+    symbol_corr_bank_free(ctx->corrbank);
+    fano_arena_free(ctx->fano);
+    jelinek_workspace_free(ctx->jelinek);
+    free(ctx->refi);
+    free(ctx->refq);
+    free(ctx->ci);
+    free(ctx->cq);
+    free(ctx->cfi);
+    free(ctx->cfq);
+    destroy_plan(ctx->pfwd);
+    destroy_plan(ctx->pinv);
+    fftwf_free(ctx->fbuf);
+    fftwf_free(ctx->hfilt);
+    free(ctx);
+}
+
+// Memory held by a context, for wsprd_stats
+static unsigned long wsprd_context_bytes(const struct wsprd_context *ctx) {
+    unsigned long bytes = sizeof(*ctx) + sizeof(*ctx->corrbank);
+
+    bytes += 2 * (2 * ctx->corrbank->njitter + 1) * sizeof(*ctx->corrbank->is);
+    bytes += 6 * SUBTRACT_NSIG * sizeof(float) + 2 * SUBTRACT_NFFT * sizeof(fftwf_complex);
+    return bytes + fano_arena_bytes(ctx->fano) + jelinek_workspace_bytes(ctx->jelinek);
+}
+
+/***************************************************************************
+ Signal subtraction with the same model as subtract_signal2(), using the
+ context's scratch memory. The reference is generated by a phase-
+ accumulating oscillator (renormalized every symbol) rather than a cos/sin
+ call per sample, and the 256-tap lowpass runs as an overlap-save FFT
+ convolution.
+ ****************************************************************************/
+void subtract_signal_fft(struct wsprd_context *ctx, float *id, float *qd, long np,
+                         float f0, int shift0, float drift0, unsigned char *channel_symbols) {
+    float dt = 1.0 / 375.0, df = 375.0 / 256.0;
+    float pi = 4. * atan(1.0), twopidt, dphi, cs, norm;
+    int i, j, k, n, n0, nsym = WSPR_NUMSYMBOLS, nspersym = 256, nfilt = SUBTRACT_NFILT;
+    int nsig = SUBTRACT_NSIG;
+    double rc = 1.0, rs = 0.0, cd, sd, tmp, mag;
+    float *refi = ctx->refi, *refq = ctx->refq, *ci = ctx->ci, *cq = ctx->cq;
+    float *cfi = ctx->cfi, *cfq = ctx->cfq;
+    fftwf_complex *fbuf = ctx->fbuf, *hfilt = ctx->hfilt;
+
+    twopidt = 2.0 * pi * dt;
+
+    // create reference wspr signal vector, centered on f0.
+    for (i = 0; i < nsym; i++) {
+        cs = (float) channel_symbols[i];
+        dphi = twopidt *
+               (
+                       f0 + (drift0 / 2.0) * ((float) i - (float) nsym / 2.0) / ((float) nsym / 2.0)
+                       + (cs - 1.5) * df
+               );
+        cd = cos(dphi);
+        sd = sin(dphi);
+        for (j = 0; j < nspersym; j++) {
+            n = nspersym * i + j;
+            refi[n] = rc;
+            refq[n] = rs;
+            tmp = rc * cd - rs * sd;
+            rs = rc * sd + rs * cd;
+            rc = tmp;
+        }
+        mag = sqrt(rc * rc + rs * rs);
+        rc = rc / mag;
+        rs = rs / mag;
+    }
+
+    // s(t) * conjugate(r(t)); samples outside the data are zero
+    for (i = 0; i < nsig; i++) {
+        k = shift0 + i;
+        if ((k > 0) && (k < np)) {
+            ci[i] = id[k] * refi[i] + qd[k] * refq[i];
+            cq[i] = qd[k] * refi[i] - id[k] * refq[i];
+        } else {
+            ci[i] = 0.0;
+            cq[i] = 0.0;
+        }
+    }
+
+    // LPF: cf(i) = sum_j w(j) c(i+j-nfilt/2), computed by overlap-save.
+    // Each block yields SUBTRACT_NSTEP outputs; the first nfilt-1 points of
+    // the circular convolution are discarded.
+    for (n0 = 0; n0 < nsig; n0 += SUBTRACT_NSTEP) {
+        for (j = 0; j < SUBTRACT_NFFT; j++) {
+            n = n0 - nfilt / 2 + j;
+            if ((n >= 0) && (n < nsig)) {
+                fbuf[j][0] = ci[n];
+                fbuf[j][1] = cq[n];
+            } else {
+                fbuf[j][0] = 0.0;
+                fbuf[j][1] = 0.0;
+            }
+        }
+        fftwf_execute(ctx->pfwd);
+        for (j = 0; j < SUBTRACT_NFFT; j++) {
+            tmp = fbuf[j][0] * hfilt[j][0] - fbuf[j][1] * hfilt[j][1];
+            fbuf[j][1] = fbuf[j][0] * hfilt[j][1] + fbuf[j][1] * hfilt[j][0];
+            fbuf[j][0] = tmp;
+        }
+        fftwf_execute(ctx->pinv);
+        for (j = nfilt - 1; j < SUBTRACT_NFFT && n0 + j - (nfilt - 1) < nsig; j++) {
+            i = n0 + j - (nfilt - 1);
+            cfi[i] = fbuf[j][0];
+            cfq[i] = fbuf[j][1];
+        }
+    }
+
+    // subtract c(t)*r(t), correcting for the LPF step response at the ends
+    for (i = 0; i < nsig; i++) {
+        if (i < nfilt / 2) {
+            norm = ctx->partialsum[nfilt / 2 + i];
+        } else if (i > (nsig - 1 - nfilt / 2)) {
+            norm = ctx->partialsum[nfilt / 2 + nsig - 1 - i];
+        } else {
+            norm = 1.0;
+        }
+        k = shift0 + i;
+        if ((k > 0) && (k < np)) {
+            id[k] = id[k] - (cfi[i] * refi[i] - cfq[i] * refq[i]) / norm;
+            qd[k] = qd[k] - (cfi[i] * refq[i] + cfq[i] * refi[i]) / norm;
+        }
+    }
+}
+
+/*
+ * Ordered-statistics fallback for deinterleaved symbols the sequential
+ * decoder gave up on. The most likely codeword is run through fano()
+ * once more to recover the message bits. OSD always returns a codeword,
+ * so it is accepted only for a Type 1 message from a callsign already in
+ * the hash table. Returns 0 (like fano) on success, with decdata, metric
+ * and cycles describing the recovered message.
+ */
+int osd_decode_symbols(struct fano_arena *arena, unsigned char *symbols, unsigned char *apmask,
+                       int ndepth, unsigned char *cw, char *hashtab, unsigned int *metric,
+                       unsigned int *cycles, unsigned char *decdata, const int mettab[2][256],
+                       int delta, unsigned int maxcycles) {
+    float fsymbs[162], dmin;
+    unsigned char hardsymbs[162];
+    unsigned int maxnp;
+    signed char message[11];
+    char callsign[13];
+    int32_t n1, n2;
+    int i, nhardmin, ntype, nu, ihash;
+
+    for (i = 0; i < 162; i++) {
+        fsymbs[i] = symbols[i] - 128.0;
+    }
+    osdwspr(fsymbs, apmask, ndepth, cw, &nhardmin, &dmin);
+    for (i = 0; i < 162; i++) {
+        hardsymbs[i] = 255 * cw[i];
+    }
+    if (fano_arena_decode(arena, metric, cycles, &maxnp, decdata, hardsymbs, 81, mettab, delta,
+                          maxcycles)) {
+        return 1;
+    }
+
+    for (i = 0; i < 11; i++) {
+        if (decdata[i] > 127) {
+            message[i] = decdata[i] - 256;
+        } else {
+            message[i] = decdata[i];
+        }
+    }
+    unpack50(message, &n1, &n2);
+    if (!unpackcall(n1, callsign)) return 1;
+    callsign[12] = 0;
+    ntype = (n2 & 127) - 64;
+    if ((ntype < 0) || (ntype > 62)) return 1;
+    nu = ntype % 10;
+    if (nu != 0 && nu != 3 && nu != 7) return 1;
+
+    ihash = nhash(callsign, strlen(callsign), (uint32_t) 146);
+    return strcmp(hashtab + ihash * 13, callsign) != 0;
+}
+
+/***************************************************************************
+ Adaptive cycle budget. Nearly every successful Fano decode finishes in a
+ few cycles per bit, while each attempt that fails burns the whole
+ budget, so most of the decoder time goes into timeouts. The sum over
+ all symbols of the better of the two branch metrics bounds the metric
+ any path, the correct one included, can reach; when it is low the
+ decoder is unlikely to succeed within any reasonable budget, and the
+ attempt gets a smaller share unless the candidate's sync is strong.
+ The breakpoints come from the outcome table written by wsprd (see
+ wspr_timer.out) and can be re-tuned from it.
+ ****************************************************************************/
+#define BUDGET_QUALITY_LOW   3.0   // per-symbol hard metric at or below: minimum budget
+#define BUDGET_QUALITY_FULL  3.4   // at or above: full budget
+#define BUDGET_SYNC_FULL     0.25  // sync at or above: full budget
+#define BUDGET_MIN_SHIFT     4     // minimum budget is maxcycles >> 4
+
+// Hard-decision path metric of 162 deinterleaved soft symbols
+static long hard_decision_metric(const unsigned char *symbols, const int (*mettab)[256]) {
+    long sum = 0;
+    int i;
+
+    for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
+        sum += max(mettab[0][symbols[i]], mettab[1][symbols[i]]);
+    }
+    return sum;
+}
+
+static unsigned int cycle_budget(unsigned int maxcycles, float sync1, long hardmetric) {
+    float quality = (float) hardmetric / WSPR_NUMSYMBOLS;
+    unsigned int minimum = max(maxcycles >> BUDGET_MIN_SHIFT, 1);
+    float scale;
+
+    if (sync1 >= BUDGET_SYNC_FULL || quality >= BUDGET_QUALITY_FULL) return maxcycles;
+    if (quality <= BUDGET_QUALITY_LOW) return minimum;
+    scale = (quality - BUDGET_QUALITY_LOW) / (BUDGET_QUALITY_FULL - BUDGET_QUALITY_LOW);
+    return max(minimum, (unsigned int) (scale * maxcycles));
+}
+
+static void cycle_stats_add(struct wsprd_cycle_stats *stats, long hardmetric, int decoded,
+                            unsigned int cycles, unsigned int budget, unsigned int nbits) {
+    int bin = (int) floor(((float) hardmetric / WSPR_NUMSYMBOLS - 2.0) / 0.25);
+
+    if (stats == NULL) return;
+    bin = min(max(bin, 0), WSPRD_QUALITY_BINS - 1);
+    stats->attempts[bin]++;
+    if (decoded) {
+        stats->decodes[bin]++;
+    } else if (cycles >= budget * nbits) {
+        stats->timeouts[bin]++;
+    }
+    stats->cycles[bin] += cycles;
+    stats->budget[bin] += (unsigned long long) budget * nbits;
+}
+
+
+/***************************************************************************
+ Decoding of one candidate's (block size, jitter) hypotheses. They are
+ tried in a fixed order and the first that decodes wins; with worker
+ threads several are evaluated at once, but the winner is still the
+ lowest-numbered hypothesis that decodes, so the output does not depend
+ on the number of threads or on scheduling.
+ ****************************************************************************/
+struct hypothesis_params {
+    struct symbol_corr_bank *bank;   // filled before workers start; read-only
+    float *idat, *qdat;
+    long npoints;
+    int shift1, symfac, lsb_mode, stackdecoder, ndepth, delta, adaptive_cycles;
+    float sync1, minsync2, minrms;
+    unsigned int nbits, maxcycles;
+    const int (*mettab)[256];
+    char *hashtab;
+    unsigned char *apmask;
+    struct wsprd_trace *trace;       // NULL unless the decode is traced
+};
+
+struct hypothesis_result {
+    int decoded, osd_decode;
+    int attempted;                   // the sequential decoder was run
+    long hardmetric;
+    unsigned int budget;             // cycles per bit allowed
+    unsigned int decoder_cycles;     // spent by Fano/Jelinek, before OSD
+    unsigned int metric, cycles;
+    unsigned char decdata[11];
+};
+
+struct hypothesis_scratch {
+    unsigned char symbols[2 * 81];
+    unsigned char cw[WSPR_NUMSYMBOLS];
+    struct fano_arena *fano;
+    struct jelinek_workspace *jelinek;
+    int tid;                         // trace thread: 0 for the caller, k for worker k
+};
+
+/*
+ * Demodulate at lag shift1+jitter with the given block length and run
+ * the sequential decoder (and OSD, if enabled) on the result. Returns
+ * nonzero when the hypothesis did not decode.
+ */
+static int decode_hypothesis(const struct hypothesis_params *p, int blocksize, int jitter,
+                             struct hypothesis_scratch *w, struct hypothesis_result *r) {
+    unsigned char *symbols = w->symbols;
+    unsigned int maxnp;
+    float y, sq = 0.0, rms;
+    int i, not_decoded = 1;
+
+    r->osd_decode = 0;
+    r->attempted = 0;
+    symbol_corr_bank_detect(p->bank, p->idat, p->qdat, p->npoints, p->shift1 + jitter,
+                            blocksize, p->symfac, symbols);
+
+    // Calculate RMS of soft symbols
+    for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
+        y = (float) symbols[i] - 128.0;
+        sq += y * y;
+    }
+    rms = sqrt(sq / (float) WSPR_NUMSYMBOLS);
+
+    // Attempt decode if sync and RMS are good enough
+    if ((p->sync1 > p->minsync2) && (rms > p->minrms)) {
+        deinterleave(symbols);
+
+        // Apply LSB mode inversion if requested
+        if (p->lsb_mode) {
+            for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
+                symbols[i] = (unsigned char) 4 - symbols[i];
+            }
+        }
+
+        r->attempted = 1;
+        r->hardmetric = hard_decision_metric(symbols, p->mettab);
+        r->budget = p->maxcycles;
+        if (p->adaptive_cycles) {
+            r->budget = cycle_budget(p->maxcycles, p->sync1, r->hardmetric);
+        }
+
+        // Try Fano or Jelinek decoder
+        double tr0 = wsprd_trace_clock(p->trace);
+        if (p->stackdecoder) {
+            not_decoded = jelinek_decode(w->jelinek, &r->metric, &r->cycles, r->decdata,
+                                         symbols, p->nbits, p->mettab, r->budget);
+        } else {
+            not_decoded = fano_arena_decode(w->fano, &r->metric, &r->cycles, &maxnp,
+                                            r->decdata, symbols, p->nbits, p->mettab,
+                                            p->delta, r->budget);
+        }
+        r->decoder_cycles = r->cycles;
+        if (p->trace != NULL) {
+            struct wsprd_trace_event *e = wsprd_trace_span(p->trace, w->tid,
+                                                           p->stackdecoder ? "jelinek" : "fano", tr0);
+            wsprd_trace_arg(e, "blocksize", blocksize);
+            wsprd_trace_arg(e, "jitter", jitter);
+            wsprd_trace_arg(e, "cycles", r->cycles);
+            wsprd_trace_arg(e, "decoded", !not_decoded);
+        }
+
+        if (not_decoded && p->ndepth >= 0) {
+            tr0 = wsprd_trace_clock(p->trace);
+            not_decoded = osd_decode_symbols(w->fano, symbols, p->apmask, p->ndepth,
+                                             w->cw, p->hashtab, &r->metric, &r->cycles,
+                                             r->decdata, p->mettab, p->delta, p->maxcycles);
+            r->osd_decode = !not_decoded;
+            wsprd_trace_arg(wsprd_trace_span(p->trace, w->tid, "osd", tr0), "decoded",
+                            r->osd_decode);
+        }
+    }
+    r->decoded = !not_decoded;
+    return not_decoded;
+}
+
+struct decode_worker {
+    struct decode_pool *pool;
+    pthread_t thread;
+    struct hypothesis_scratch scratch;
+    int hyp;                         // hypothesis being evaluated, -1 if none
+    int cancel;                      // set when a lower hypothesis has decoded
+};
+
+/*
+ * Worker threads that evaluate the hypotheses of one candidate at a
+ * time. The calling thread takes part as worker 0.
+ */
+struct decode_pool {
+    int nworkers;
+    struct decode_worker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start, finished;
+    int generation, shutdown, busy;
+
+    // Current job
+    const struct hypothesis_params *params;
+    const int *blocksize, *jitter;
+    struct hypothesis_result *results;
+    int nhyp, next, best;
+
+    double worker_cpu;               // CPU seconds of the threads other than the caller
+};
+
+static void decode_pool_work(struct decode_pool *pool, struct decode_worker *w) {
+    for (;;) {
+        int h;
+
+        pthread_mutex_lock(&pool->lock);
+        h = pool->next++;
+        if (h >= pool->nhyp || h > pool->best) {
+            w->hyp = -1;
+            pthread_mutex_unlock(&pool->lock);
+            return;
+        }
+        w->hyp = h;
+        __atomic_store_n(&w->cancel, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&pool->lock);
+
+        if (!decode_hypothesis(pool->params, pool->blocksize[h], pool->jitter[h],
+                               &w->scratch, &pool->results[h])) {
+            int k;
+
+            pthread_mutex_lock(&pool->lock);
+            if (h < pool->best) {
+                pool->best = h;
+                // Stop the workers still on later hypotheses
+                for (k = 0; k < pool->nworkers; k++) {
+                    if (pool->workers[k].hyp > h) {
+                        __atomic_store_n(&pool->workers[k].cancel, 1, __ATOMIC_RELAXED);
+                    }
+                }
+            }
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+static void *decode_pool_thread(void *arg) {
+    struct decode_worker *w = arg;
+    struct decode_pool *pool = w->pool;
+    int seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        double cpu0 = wsprd_cpuclock();
+        decode_pool_work(pool, w);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->worker_cpu += wsprd_cpuclock() - cpu0;
+        if (--pool->busy == 0) pthread_cond_signal(&pool->finished);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void decode_pool_free(struct decode_pool *pool) {
+    int k;
+
+    if (pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (k = 0; k < pool->nworkers; k++) {
+        if (k > 0) pthread_join(pool->workers[k].thread, NULL);
+        fano_arena_free(pool->workers[k].scratch.fano);
+        jelinek_workspace_free(pool->workers[k].scratch.jelinek);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->finished);
+    free(pool->workers);
+    free(pool);
+}
+
+/*
+ * Returns NULL if the pool or a worker's scratch could not be allocated;
+ * the caller then decodes on its own thread.
+ */
+struct decode_pool *decode_pool_create(int nworkers, int stackdecoder, unsigned int stacksize) {
+    struct decode_pool *pool = calloc(1, sizeof(struct decode_pool));
+    int k;
+
+    if (pool == NULL) return NULL;
+    pool->nworkers = nworkers;
+    pool->workers = calloc(nworkers, sizeof(struct decode_worker));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    for (k = 0; k < nworkers; k++) {
+        struct decode_worker *w = &pool->workers[k];
+        w->pool = pool;
+        w->hyp = -1;
+        w->scratch.tid = k;
+        w->scratch.fano = fano_arena_alloc(81);
+        if (stackdecoder) w->scratch.jelinek = jelinek_workspace_alloc(stacksize);
+        if (w->scratch.fano == NULL || (stackdecoder && w->scratch.jelinek == NULL)) {
+            fano_arena_free(w->scratch.fano);
+            jelinek_workspace_free(w->scratch.jelinek);
+            pool->nworkers = k;      // stop and free the workers already started
+            decode_pool_free(pool);
+            return NULL;
+        }
+        w->scratch.fano->cancel = &w->cancel;
+        if (stackdecoder) w->scratch.jelinek->cancel = &w->cancel;
+        if (k > 0 && pthread_create(&w->thread, NULL, decode_pool_thread, w) != 0) {
+            pool->nworkers = k;      // run with the threads we got
+            fano_arena_free(w->scratch.fano);
+            jelinek_workspace_free(w->scratch.jelinek);
+            break;
+        }
+    }
+    return pool;
+}
+
+static unsigned long decode_pool_bytes(const struct decode_pool *pool) {
+    unsigned long bytes;
+    int k;
+
+    if (pool == NULL) return 0;
+    bytes = sizeof(*pool) + pool->nworkers * sizeof(struct decode_worker);
+    for (k = 0; k < pool->nworkers; k++) {
+        bytes += fano_arena_bytes(pool->workers[k].scratch.fano);
+        bytes += jelinek_workspace_bytes(pool->workers[k].scratch.jelinek);
+    }
+    return bytes;
+}
+
+/*
+ * Evaluate hypotheses 0..nhyp-1 and return the index of the first that
+ * decodes (its result in results[]), or -1.
+ */
+int decode_pool_run(struct decode_pool *pool, const struct hypothesis_params *params,
+                    const int *blocksize, const int *jitter, int nhyp,
+                    struct hypothesis_result *results) {
+    int best;
+
+    symbol_corr_bank_prepare(params->bank, params->idat, params->qdat, params->npoints);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->params = params;
+    pool->blocksize = blocksize;
+    pool->jitter = jitter;
+    pool->results = results;
+    pool->nhyp = nhyp;
+    pool->next = 0;
+    pool->best = nhyp;
+    pool->busy = pool->nworkers - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    decode_pool_work(pool, &pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    best = pool->best;
+    pthread_mutex_unlock(&pool->lock);
+
+    return best < nhyp ? best : -1;
 }
 
 unsigned long writec2file(char *c2filename, int trmin, double freq, float *idat, float *qdat) {
@@ -712,16 +1761,19 @@ unsigned long writec2file(char *c2filename, int trmin, double freq, float *idat,
 }
 
 //***************************************************************************
+#ifndef WSPRD_NO_MAIN  // wsprmc and other host tools link the decoder without the CLI
 void usage(void) {
     printf("Usage: wsprd [options...] infile\n");
     printf("       infile must have suffix .wav or .c2\n");
     printf("\n");
     printf("Options:\n");
     printf("       -a <path> path to writeable data files, default=\".\"\n");
+    printf("       -A adapt the decoder cycle budget to each candidate's quality\n");
     printf("       -B disable block demodulation - use single-symbol noncoherent demod\n");
     printf("       -c write .c2 file at the end of the first pass\n");
     printf("       -C maximum number of decoder cycles per bit, default 10000\n");
     printf("       -d deeper search. Slower, a few more decodes\n");
+    printf("       -D add a pass with 6- and 9-symbol block demodulation\n");
     printf("       -e x (x is transceiver dial frequency error in Hz)\n");
     printf("       -f x (x is transceiver dial frequency in MHz)\n");
     printf("       -H do not use (or update) the hash table\n");
@@ -735,6 +1787,20 @@ void usage(void) {
     printf("       -z x (x is fano metric table bias, default is 0.45)\n");
 }
 
+static void cycle_stats_print(FILE *fp, const struct wsprd_cycle_stats *stats) {
+    int i;
+
+    fprintf(fp, "Quality  Attempts  Decodes  Timeouts        Cycles  Budget used\n");
+    for (i = 0; i < WSPRD_QUALITY_BINS; i++) {
+        if (stats->attempts[i] == 0) continue;
+        fprintf(fp, "%c%4.2f %9lu %8lu %9lu %13llu %11.2f\n", i == 0 ? '<' : ' ',
+                2.0 + 0.25 * (i + (i == 0)), stats->attempts[i], stats->decodes[i],
+                stats->timeouts[i], stats->cycles[i],
+                (double) stats->cycles[i] / (double) stats->budget[i]);
+    }
+}
+#endif
+
 //***************************************************************************
 
 
@@ -765,19 +1831,19 @@ ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, floa
 
     float *realin;
     fftwf_complex *fftin, *fftout;
+    fftwf_plan plan1, plan2;
 
 
     short *buf2;
 
 
     buf2 = malloc((npoints + 2) * sizeof(short)); // fatality?
-    printf("MEMCPY: %d -> %d", sarlen, npoints + 2 * sizeof(short));
     memcpy(buf2, soundarr, (size_t) sarlen);
 
 
     realin = (float *) fftwf_malloc(sizeof(float) * nfft1);
     fftout = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * (nfft1 / 2 + 1));
-    PLAN1 = fftwf_plan_dft_r2c_1d(nfft1, realin, fftout, PATIENCE);
+    plan1 = plan_dft_r2c_1d(nfft1, realin, fftout);
 
     for (i = 0; i < npoints; i++) {
         realin[i] = buf2[i] / 32768.0;
@@ -788,7 +1854,8 @@ ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, floa
     }
     free(buf2);
 
-    fftwf_execute(PLAN1);
+    fftwf_execute(plan1);
+    destroy_plan(plan1);
     fftwf_free(realin);
 
     fftin = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * nfft2);
@@ -802,8 +1869,9 @@ ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, floa
 
     fftwf_free(fftout);
     fftout = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * nfft2);
-    PLAN2 = fftwf_plan_dft_1d(nfft2, fftin, fftout, FFTW_BACKWARD, PATIENCE);
-    fftwf_execute(PLAN2);
+    plan2 = plan_dft_1d(nfft2, fftin, fftout, FFTW_BACKWARD);
+    fftwf_execute(plan2);
+    destroy_plan(plan2);
 
     for (i = 0; i < (size_t) nfft2; i++) {
         idat[i] = fftout[i][0] / 1000.0;
@@ -815,23 +1883,30 @@ ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, floa
     return nfft2;
 }
 
+// Largest working set of ReadWavFileEx(): the PCM copy, FFT input and spectrum
+static unsigned long readwav_scratch_bytes(void) {
+    unsigned long nfft1 = 46080 * 32, npoints = 114 * 12000;
+
+    return (npoints + 2) * sizeof(short) + nfft1 * sizeof(float) +
+           (nfft1 / 2 + 1) * sizeof(fftwf_complex);
+}
+
 
 /**
- * jani_do_process - Main WSPR decoding function called from Java via JNI
+ * wsprd_decode - Main WSPR decoding function (called from Java via jani_do_process)
  *
  * This function takes raw PCM audio data and decodes any WSPR messages present.
  * It performs FFT analysis, candidate detection, sync refinement, and Fano/Jelinek
  * decoding to extract callsign, grid square, and power from WSPR transmissions.
  *
- * @param env         JNI environment pointer for Java interop
- * @param clazz       Java class reference (unused but required by JNI)
  * @param soundarr    Raw PCM audio data as unsigned char array (16-bit samples, little-endian)
  * @param sarlen      Length of soundarr in bytes
- * @param jdialfreq   Dial frequency in MHz (e.g., 14.0956 for 20m WSPR)
+ * @param dialfreq_cmdline  Dial frequency in MHz (e.g., 14.0956 for 20m WSPR)
  * @param lsb_mode    If true, inverts symbol order for lower sideband reception
+ * @param opts        Decoder options, or NULL for the defaults
+ * @param decodes     Receives up to maxdecodes results, sorted by frequency
  *
- * @return jobjectArray of WSPRMessage objects containing decoded messages,
- *         or empty array if no messages decoded
+ * @return Number of decodes stored
  *
  * Audio Requirements:
  *   - Sample rate: 12000 Hz (12 kHz)
@@ -844,69 +1919,36 @@ ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, floa
  *   - Messages contain: callsign (up to 6 chars), grid (4 chars), power (0-60 dBm)
  *   - Signal bandwidth is ~6 Hz, centered around 1500 Hz audio frequency
  */
-jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
-                             unsigned char *soundarr, int sarlen, double jdialfreq,
-                             jboolean lsb_mode) {
-    extern char *optarg;
-    extern int optind;
+int wsprd_decode(unsigned char *soundarr, int sarlen, double dialfreq_cmdline, int lsb_mode,
+                 const struct wsprd_options *opts, struct wsprd_decode *decodes, int maxdecodes) {
     int i, j, k;
     unsigned char *symbols, *decdata, *channel_symbols, *apmask, *cw;
     signed char message[] = {-9, 13, -35, 123, 57, -39, 64, 0, 0, 0, 0};
     char *callsign, *call_loc_pow;
-    char *ptr_to_infile, *ptr_to_infile_suffix;
-    char *data_dir = NULL;
-    char wisdom_fname[200], all_fname[200], spots_fname[200];
-    char timer_fname[200], hash_fname[200];
     char uttime[5], date[7];
-    int c, delta, maxpts = 65536, verbose = 0, quickmode = 0, more_candidates = 0, stackdecoder = 0;
-    int writenoise = 0, usehashtable = 1, wspr_type = 2, ipass, nblocksize;
-    int nhardmin, ihash;
-    int writec2 = 0, maxdrift;
-    int shift1, lagmin, lagmax, lagstep, ifmin, ifmax, worth_a_try, not_decoded;
+    int delta, maxpts = 65536, verbose = 0, quickmode = 0, more_candidates = 0, stackdecoder = 0;
+    int wspr_type = 2, ipass, nblocksize;
+    int maxdrift;
+    int shift1, worth_a_try, not_decoded;
     unsigned int nbits = 81, stacksize = 200000;
-    unsigned int npoints, metric, cycles, maxnp;
+    unsigned int npoints, metric, cycles;
     float df = 375.0 / 256.0 / 2;
     float freq0[200], snr0[200], drift0[200], sync0[200];
-    float fsymbs[WSPR_NUMSYMBOLS];
     int shift0[200];
     float dt = 1.0 / 375.0, dt_print;
-    double dialfreq_cmdline = jdialfreq, dialfreq, freq_print;
+    double dialfreq, freq_print;
     double dialfreq_error = 0.0;
     float fmin = -110, fmax = 110;
-    float f1, fstep, sync1, drift1;
-    float dmin;
+    float f1, sync1, drift1;
     float psavg[512];
     float *idat, *qdat;
-    clock_t t0, t00;
-    float tfano = 0.0, treadwav = 0.0, tcandidates = 0.0, tsync0 = 0.0;
-    float tsync1 = 0.0, tsync2 = 0.0, ttotal = 0.0;
-
-    /*
-     * Structure to hold decoded WSPR message results.
-     * Each successful decode populates one of these with timing,
-     * frequency, SNR, and the decoded message content.
-     */
-    struct result {
-        char date[7];
-        char time[5];
-        float sync;
-        float snr;
-        float dt;
-        double freq;
-        char message[23];  // Contains "CALLSIGN GRID POWER"
-        float drift;
-        unsigned int cycles;
-        int jitter;
-        int blocksize;
-        unsigned int metric;
-        unsigned char osd_decode;
-    };
-    struct result decodes[50];  // Max 50 unique decodes per processing run
+    struct stage_clock sc, sc_total;
+    struct wsprd_stats stats;
+    unsigned long base_bytes;
 
     // Hash table for callsign lookup (used for Type 2/3 messages with hashed calls)
     char *hashtab;
     hashtab = calloc(32768 * 13, sizeof(char));
-    int nh;
 
     // Allocate working buffers for the decoder
     symbols = calloc(nbits * 2, sizeof(unsigned char));
@@ -936,82 +1978,128 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
     int symfac = 50;                   // Soft-symbol normalizing factor
     int block_demod = 1;               // Use block demodulation on pass 2
     int subtraction = 1;               // Subtract decoded signals for multi-decode
-    int npasses = 2;                   // Number of decoding passes
-    int ndepth = -1;                   // OSD depth (disabled)
+    int npasses = 2;                   // Passes always run (more with deep search)
+    int maxpasses;                     // Further passes run while they find new signals
+    int ndepth;                        // OSD depth (-1 disables the fallback)
 
     float minrms = 52.0 * (symfac / 64.0);  // Minimum RMS for plausible decode
     delta = 60;                              // Fano threshold step
-    float bias = 0.45;                       // Fano metric bias
 
-    t00 = clock();
+    struct wsprd_options default_opts;
+    if (opts == NULL) {
+        wsprd_options_init(&default_opts);
+        opts = &default_opts;
+    }
+    if (opts->deep_search) npasses++;  // Pass with long blocks
+    ndepth = opts->osd_depth;
+    if (opts->callhash != NULL) callhash_fill(opts->callhash, hashtab);
+    stackdecoder = opts->stack_decoder;
+    maxpasses = max(npasses, opts->max_passes);
+    if (maxpasses > WSPRD_MAX_PASSES) maxpasses = WSPRD_MAX_PASSES;
+
+    // Frequencies of signals already subtracted; later passes skip candidates there
+    float subfreqs[WSPRD_MAX_DECODES];
+    int nsubtracted = 0;
+    int uniques_prev = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    stage_start(&sc_total);
+    double twall0 = sc_total.wall;
     fftwf_complex *fftin, *fftout;
+    fftwf_plan plan3;
 
-    // Load metric tables for Fano decoder (included from separate file)
-#include "./metric_tables.c"
-
-    int mettab[2][256];
+    // Fano/Jelinek metric table, shared with every other decoder instance
+    const int (*mettab)[256] = metric_table(opts->metric_bias);
 
     // Allocate I/Q data buffers for FFT processing
     idat = calloc(maxpts, sizeof(float));
     qdat = calloc(maxpts, sizeof(float));
 
-    if (stackdecoder) {
-        stack = calloc(stacksize, sizeof(struct snode));
-    }
-
-    // Initialize metric table for Fano decoder
-    for (i = 0; i < 256; i++) {
-        mettab[0][i] = round(10 * (metric_tables[2][i] - bias));
-        mettab[1][i] = round(10 * (metric_tables[2][255 - i] - bias));
-    }
 
-    // Set up file paths (not used in Android JNI version, but kept for compatibility)
-    FILE *fp_fftwf_wisdom_file, *fall_wspr, *fwsprd, *fhash, *ftimer;
-    strcpy(wisdom_fname, ".");
-    strcpy(all_fname, ".");
-    strcpy(spots_fname, ".");
-    strcpy(timer_fname, ".");
-    strcpy(hash_fname, ".");
-    if (data_dir != NULL) {
-        strcpy(wisdom_fname, data_dir);
-        strcpy(all_fname, data_dir);
-        strcpy(spots_fname, data_dir);
-        strcpy(timer_fname, data_dir);
-        strcpy(hash_fname, data_dir);
+    // Scratch memory for demodulation and subtraction, reused for every candidate
+    struct wsprd_context *ctx = wsprd_context_alloc((128 / iifac + 1) / 2);
+    if (stackdecoder) {
+        ctx->jelinek = jelinek_workspace_alloc(stacksize);
     }
 
-    strncat(wisdom_fname, "/wspr_wisdom.dat", 20);
-    strncat(all_fname, "/ALL_WSPR.TXT", 20);
-    strncat(spots_fname, "/wspr_spots.txt", 20);
-    strncat(timer_fname, "/wspr_timer.out", 20);
-    strncat(hash_fname, "/hashtable.txt", 20);
-
     /*
-     * Get reference to Java WSPRMessage class for creating return objects.
-     * This is done early so we can return an empty array on error.
+     * Per-candidate hypothesis evaluation. With decode_threads > 1 the
+     * hypotheses are decoded speculatively on a pool of worker threads.
      */
-    jclass cls = (*env)->FindClass(env, "org/operatorfoundation/audiocoder/WSPRMessage");
+    int hyp_blocksize[NBLOCK_LENGTHS * 129], hyp_jitter[NBLOCK_LENGTHS * 129];
+    struct hypothesis_result hyp_results[NBLOCK_LENGTHS * 129];
+    struct hypothesis_params hparams;
+    struct hypothesis_scratch hscratch;
+    struct decode_pool *pool = NULL;
+
+    memset(&hparams, 0, sizeof(hparams));
+    hparams.bank = ctx->corrbank;
+    hparams.idat = idat;
+    hparams.qdat = qdat;
+    hparams.symfac = symfac;
+    hparams.lsb_mode = lsb_mode;
+    hparams.stackdecoder = stackdecoder;
+    hparams.ndepth = ndepth;
+    hparams.delta = delta;
+    hparams.minrms = minrms;
+    hparams.nbits = nbits;
+    hparams.maxcycles = maxcycles;
+    hparams.adaptive_cycles = opts->adaptive_cycles;
+    hparams.mettab = mettab;
+    hparams.hashtab = hashtab;
+    hparams.apmask = apmask;
+    hparams.trace = opts->trace;
+    memset(&hscratch, 0, sizeof(hscratch));
+    hscratch.fano = ctx->fano;
+    hscratch.jelinek = ctx->jelinek;
+    if (opts->decode_threads > 1) {
+        pool = decode_pool_create(min(opts->decode_threads, WSPRD_MAX_THREADS), stackdecoder,
+                                  stacksize);
+    }
+    base_bytes = 2 * maxpts * sizeof(float) + 32768 * 13 + wsprd_context_bytes(ctx) +
+                 decode_pool_bytes(pool);
+    stats.peak_scratch_bytes = base_bytes + readwav_scratch_bytes();
 
     /*
      * Read and process the audio data from the byte array.
      * This performs initial FFT to convert to I/Q baseband representation.
      */
-    t0 = clock();
+    struct wsprd_trace *trace = opts->trace;
+    double tr0, trpass, trcand;
+
+    tr0 = wsprd_trace_clock(trace);
+    stage_start(&sc);
     npoints = ReadWavFileEx(soundarr, sarlen, wspr_type, idat, qdat);
-    treadwav += (float) (clock() - t0) / CLOCKS_PER_SEC;
+    stage_stop(&stats, WSPRD_STAGE_READWAV, &sc);
+    wsprd_trace_span(trace, 0, "readwav", tr0);
 
-    // Return empty array if audio read failed
+    // Return no decodes if audio read failed
     if (npoints == 1) {
-        return (*env)->NewObjectArray(env, 0, cls, 0);
+        free(hashtab);
+        free(symbols);
+        free(apmask);
+        free(cw);
+        free(decdata);
+        free(channel_symbols);
+        free(callsign);
+        free(call_loc_pow);
+        free(idat);
+        free(qdat);
+        decode_pool_free(pool);
+        wsprd_context_free(ctx);
+        if (opts->stats != NULL) {
+            stats.total_wall_seconds = wsprd_wallclock() - sc_total.wall;
+            stats.total_cpu_seconds = wsprd_cpuclock() - sc_total.cpu;
+            *opts->stats = stats;
+        }
+        return 0;
     }
 
     dialfreq = dialfreq_cmdline - (dialfreq_error * 1.0e-06);
 
     // Use placeholder date/time (not available in real-time decode)
-    strncpy(date, "987654", 6);
-    strncpy(uttime, "6543", 4);
-    date[6] = '\0';
-    uttime[4] = '\0';
+    strcpy(date, "987654");
+    strcpy(uttime, "6543");
 
     /*
      * Perform windowed FFTs over 2 symbols, stepped by half symbols.
@@ -1020,10 +2108,12 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
     int nffts = 4 * floor(npoints / 512) - 1;
     fftin = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * 512);
     fftout = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * 512);
-    PLAN3 = fftwf_plan_dft_1d(512, fftin, fftout, FFTW_FORWARD, PATIENCE);
+    plan3 = plan_dft_1d(512, fftin, fftout, FFTW_FORWARD);
 
     float ps[512][nffts];
     float w[512];
+    stats.peak_scratch_bytes = max(stats.peak_scratch_bytes,
+                                   base_bytes + sizeof(ps) + 2 * 512 * sizeof(fftwf_complex));
 
     // Sine window for FFT (reduces spectral leakage)
     for (i = 0; i < 512; i++) {
@@ -1031,11 +2121,22 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
     }
 
     /*
-     * Main decoding loop - runs multiple passes.
+     * Main decoding loop - runs multiple passes, each on the residual left
+     * after subtracting everything decoded so far.
      * Pass 0: Initial decode with standard parameters
      * Pass 1: Re-decode with block demodulation after subtracting found signals
+     * Pass 2: (deep search only) block lengths up to 9 on the remaining signal
+     * Further passes, up to opts->max_passes, repeat the last pass's settings
+     * as long as the previous pass produced a new message and the deadline
+     * (if any) has not passed.
      */
-    for (ipass = 0; ipass < npasses; ipass++) {
+    for (ipass = 0; ipass < maxpasses; ipass++) {
+        if (ipass >= npasses && uniques == uniques_prev) break;
+        if (ipass > 0 && wsprd_past_deadline(opts, twall0)) break;
+        uniques_prev = uniques;
+        stats.passes = ipass + 1;
+        trpass = wsprd_trace_clock(trace);
+
         if (ipass == 0) {
             nblocksize = 1;
             maxdrift = 4;
@@ -1052,31 +2153,17 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
                 minsync2 = 0.12;
             }
         }
+        if (ipass >= 2 && opts->deep_search) {
+            nblocksize = 9;  // 6- and 9-symbol blocks need a stable channel
+            maxdrift = 0;
+            minsync2 = 0.10;
+        }
         ndecodes_pass = 0;
 
         // Compute windowed FFTs across the entire recording
-        for (i = 0; i < nffts; i++) {
-            for (j = 0; j < 512; j++) {
-                k = i * 128 + j;
-                fftin[j][0] = idat[k] * w[j];
-                fftin[j][1] = qdat[k] * w[j];
-            }
-            fftwf_execute(PLAN3);
-            for (j = 0; j < 512; j++) {
-                k = j + 256;
-                if (k > 511)
-                    k = k - 512;
-                ps[j][i] = fftout[k][0] * fftout[k][0] + fftout[k][1] * fftout[k][1];
-            }
-        }
-
-        // Compute average power spectrum across all time windows
-        for (i = 0; i < 512; i++) psavg[i] = 0.0;
-        for (i = 0; i < nffts; i++) {
-            for (j = 0; j < 512; j++) {
-                psavg[j] = psavg[j] + ps[j][i];
-            }
-        }
+        tr0 = wsprd_trace_clock(trace);
+        stage_start(&sc);
+        compute_spectrogram(idat, qdat, nffts, w, fftin, fftout, plan3, ps, psavg);
 
         // Smooth spectrum with 7-point window and limit to +/-150 Hz
         int window[7] = {1, 1, 1, 1, 1, 1, 1};
@@ -1151,12 +2238,17 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
             }
         }
 
-        // Apply frequency range filter
+        // Apply frequency range filter, and drop candidates left over from
+        // signals that were decoded and subtracted on an earlier pass
         fmin += dialfreq_error;
         fmax += dialfreq_error;
         i = 0;
         for (j = 0; j < npk; j++) {
-            if (freq0[j] >= fmin && freq0[j] <= fmax) {
+            int decoded = 0;
+            for (k = 0; k < nsubtracted; k++) {
+                if (fabs(freq0[j] - subfreqs[k]) < 1.5 * df) decoded = 1;
+            }
+            if (freq0[j] >= fmin && freq0[j] <= fmax && !decoded) {
                 freq0[i] = freq0[j];
                 snr0[i] = snr0[j];
                 i++;
@@ -1180,61 +2272,26 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
             }
         }
 
-        t0 = clock();
-
-        /*
-         * Coarse estimation of time shift (DT), frequency, and drift for each candidate.
-         * This narrows down the search space before fine refinement.
-         */
-        int idrift, ifr, if0, ifd, k0;
-        int kindex;
-        float smax, ss, pow, p0, p1, p2, p3;
-        for (j = 0; j < npk; j++) {
-            smax = -1e30;
-            if0 = freq0[j] / df + 256;
-            for (ifr = if0 - 2; ifr <= if0 + 2; ifr++) {
-                for (k0 = -10; k0 < 22; k0++) {
-                    for (idrift = -maxdrift; idrift <= maxdrift; idrift++) {
-                        ss = 0.0;
-                        pow = 0.0;
-                        for (k = 0; k < WSPR_NUMSYMBOLS; k++) {
-                            ifd = ifr + ((float) k - 81.0) / 81.0 * ((float) idrift) / (2.0 * df);
-                            kindex = k0 + 2 * k;
-                            if (kindex < nffts) {
-                                p0 = ps[ifd - 3][kindex];
-                                p1 = ps[ifd - 1][kindex];
-                                p2 = ps[ifd + 1][kindex];
-                                p3 = ps[ifd + 3][kindex];
+        stats.candidates[ipass] = npk;
+        stage_stop(&stats, WSPRD_STAGE_SPECTRUM, &sc);
+        wsprd_trace_span(trace, 0, "spectrum", tr0);
 
-                                p0 = sqrt(p0);
-                                p1 = sqrt(p1);
-                                p2 = sqrt(p2);
-                                p3 = sqrt(p3);
+        tr0 = wsprd_trace_clock(trace);
+        stage_start(&sc);
 
-                                ss = ss + (2 * pr3[k] - 1) * ((p1 + p3) - (p0 + p2));
-                                pow = pow + p0 + p1 + p2 + p3;
-                            }
-                        }
-                        sync1 = ss / pow;
-                        if (sync1 > smax) {
-                            smax = sync1;
-                            shift0[j] = 128 * (k0 + 1);
-                            drift0[j] = idrift;
-                            freq0[j] = (ifr - 256) * df;
-                            sync0[j] = sync1;
-                        }
-                    }
-                }
-            }
-        }
-        tcandidates += (float) (clock() - t0) / CLOCKS_PER_SEC;
+        // Coarse estimation of time shift (DT), frequency, and drift for each candidate
+        coarse_candidate_search(nffts, ps, npk, maxdrift, freq0, shift0, drift0, sync0);
+        stage_stop(&stats, WSPRD_STAGE_CANDIDATES, &sc);
+        wsprd_trace_arg(wsprd_trace_span(trace, 0, "coarse search", tr0), "candidates", npk);
 
         /*
          * Fine refinement and decoding for each candidate.
-         * Uses sync_and_demodulate() to refine frequency/time estimates,
+         * Uses sync_search_grid() to refine frequency/time/drift estimates,
          * then attempts Fano or Jelinek decoding.
          */
         for (j = 0; j < npk; j++) {
+            if (ipass > 0 && wsprd_past_deadline(opts, twall0)) break;
+
             memset(symbols, 0, sizeof(char) * nbits * 2);
             memset(callsign, 0, sizeof(char) * 13);
             memset(call_loc_pow, 0, sizeof(char) * 23);
@@ -1243,132 +2300,139 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
             drift1 = drift0[j];
             shift1 = shift0[j];
             sync1 = sync0[j];
-
-            // Coarse grid search
-            fstep = 0.0;
-            ifmin = 0;
-            ifmax = 0;
-            lagmin = shift1 - 128;
-            lagmax = shift1 + 128;
-            lagstep = 64;
-            t0 = clock();
-            sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 0);
-            tsync0 += (float) (clock() - t0) / CLOCKS_PER_SEC;
-
-            fstep = 0.25;
-            ifmin = -2;
-            ifmax = 2;
-            t0 = clock();
-            sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 1);
-
-            // Refine drift estimate on first pass
+            trcand = wsprd_trace_clock(trace);
+
+            // Coarse grid search over lag, then frequency
+            tr0 = trcand;
+            stage_start(&sc);
+            sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1 - 128, shift1 + 128, 64,
+                             &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
+            stage_stop(&stats, WSPRD_STAGE_SYNC0, &sc);
+            wsprd_trace_arg(wsprd_trace_span(trace, 0, "sync lag", tr0), "sync", sync1);
+
+            tr0 = wsprd_trace_clock(trace);
+            stage_start(&sc);
+            sync_search_grid(idat, qdat, npoints, f1, -2, 2, 0.25, shift1, shift1, 0,
+                             &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
+            wsprd_trace_arg(wsprd_trace_span(trace, 0, "sync freq", tr0), "sync", sync1);
+
+            // Refine drift estimate on first pass; both offsets share one sweep
             if (ipass == 0) {
-                fstep = 0.0;
-                ifmin = 0;
-                ifmax = 0;
-                float driftp, driftm, syncp, syncm;
-                driftp = drift1 + 0.5;
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &driftp, symfac, &syncp, 1);
-
-                driftm = drift1 - 0.5;
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &driftm, symfac, &syncm, 1);
-
-                if (syncp > sync1) {
-                    drift1 = driftp;
-                    sync1 = syncp;
-                } else if (syncm > sync1) {
-                    drift1 = driftm;
-                    sync1 = syncm;
+                float drifts[2], hsync[2], fd, dd, sd;
+                int shiftd;
+                drifts[0] = drift1 + 0.5;
+                drifts[1] = drift1 - 0.5;
+                tr0 = wsprd_trace_clock(trace);
+                sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1, shift1, 0,
+                                 drifts, 2, &fd, &shiftd, &dd, &sd, hsync);
+                wsprd_trace_span(trace, 0, "sync drift", tr0);
+
+                if (hsync[0] > sync1) {
+                    drift1 = drifts[0];
+                    sync1 = hsync[0];
+                } else if (hsync[1] > sync1) {
+                    drift1 = drifts[1];
+                    sync1 = hsync[1];
                 }
             }
-            tsync1 += (float) (clock() - t0) / CLOCKS_PER_SEC;
+            stage_stop(&stats, WSPRD_STAGE_SYNC1, &sc);
 
             // Fine grid search if coarse sync is good enough
             if (sync1 > minsync1) {
-                lagmin = shift1 - 32;
-                lagmax = shift1 + 32;
-                lagstep = 16;
-                t0 = clock();
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 0);
-                tsync0 += (float) (clock() - t0) / CLOCKS_PER_SEC;
-
-                fstep = 0.05;
-                ifmin = -2;
-                ifmax = 2;
-                t0 = clock();
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 1);
-                tsync1 += (float) (clock() - t0) / CLOCKS_PER_SEC;
+                tr0 = wsprd_trace_clock(trace);
+                stage_start(&sc);
+                sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1 - 32, shift1 + 32, 16,
+                                 &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
+                stage_stop(&stats, WSPRD_STAGE_SYNC0, &sc);
+                wsprd_trace_arg(wsprd_trace_span(trace, 0, "sync lag fine", tr0), "sync", sync1);
+
+                tr0 = wsprd_trace_clock(trace);
+                stage_start(&sc);
+                sync_search_grid(idat, qdat, npoints, f1, -2, 2, 0.05, shift1, shift1, 0,
+                                 &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
+                stage_stop(&stats, WSPRD_STAGE_SYNC1, &sc);
+                wsprd_trace_arg(wsprd_trace_span(trace, 0, "sync freq fine", tr0), "sync", sync1);
 
                 worth_a_try = 1;
             } else {
                 worth_a_try = 0;
             }
 
-            int idt, ii, jittered_shift;
-            float y, sq, rms;
+            int idt, ii = 0;
             not_decoded = 1;
             int osd_decode = 0;
-            int ib = 1, blocksize;
-            int n1, n2, n3, nadd, nu, ntype;
-
-            // Try different block sizes for demodulation
-            while (ib <= nblocksize && not_decoded) {
-                blocksize = ib;
-                idt = 0;
-                ii = 0;
+            int ib = 0, blocksize = 1;
+
+            // Correlate once at the refined shift; jittered lags slide from it
+            if (worth_a_try) {
+                tr0 = wsprd_trace_clock(trace);
+                stage_start(&sc);
+                symbol_corr_bank_init(ctx->corrbank, idat, qdat, npoints, f1, shift1, drift1, iifac);
+                stage_stop(&stats, WSPRD_STAGE_SYNC2, &sc);
+                wsprd_trace_span(trace, 0, "symbol correlation", tr0);
+            }
 
-                // Try different time jitter values
-                while (worth_a_try && not_decoded && idt <= (128 / iifac)) {
+            /*
+             * Hypotheses in the order they are tried: block sizes, and for
+             * each the time jitters 0, -iifac, +iifac, -2*iifac, ...
+             */
+            int nhyp = 0;
+            while (worth_a_try && ib < NBLOCK_LENGTHS && block_lengths[ib] <= nblocksize) {
+                for (idt = 0; idt <= (128 / iifac); idt++) {
                     ii = (idt + 1) / 2;
                     if (idt % 2 == 1) ii = -ii;
-                    ii = iifac * ii;
-                    jittered_shift = shift1 + ii;
+                    hyp_blocksize[nhyp] = block_lengths[ib];
+                    hyp_jitter[nhyp] = iifac * ii;
+                    nhyp++;
+                    if (quickmode) break;
+                }
+                ib++;
+            }
 
-                    t0 = clock();
-                    noncoherent_sequence_detection(idat, qdat, npoints, symbols, &f1,
-                                                   &jittered_shift, &drift1, symfac, &blocksize);
-                    tsync2 += (float) (clock() - t0) / CLOCKS_PER_SEC;
+            hparams.npoints = npoints;
+            hparams.shift1 = shift1;
+            hparams.sync1 = sync1;
+            hparams.minsync2 = minsync2;
 
-                    // Calculate RMS of soft symbols
-                    sq = 0.0;
-                    for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
-                        y = (float) symbols[i] - 128.0;
-                        sq += y * y;
+            int winner = -1;
+            stage_start(&sc);
+            if (pool != NULL && nhyp > 1) {
+                winner = decode_pool_run(pool, &hparams, hyp_blocksize, hyp_jitter, nhyp,
+                                         hyp_results);
+            } else {
+                for (k = 0; k < nhyp && winner < 0; k++) {
+                    if (!decode_hypothesis(&hparams, hyp_blocksize[k], hyp_jitter[k], &hscratch,
+                                           &hyp_results[k])) {
+                        winner = k;
                     }
-                    rms = sqrt(sq / (float) WSPR_NUMSYMBOLS);
-
-                    // Attempt decode if sync and RMS are good enough
-                    if ((sync1 > minsync2) && (rms > minrms)) {
-                        deinterleave(symbols);
-
-                        // Apply LSB mode inversion if requested
-                        if (lsb_mode) {
-                            for (i = 0; i < WSPR_NUMSYMBOLS; i++) {
-                                symbols[i] = (unsigned char) 4 - symbols[i];
-                            }
-                        }
-
-                        t0 = clock();
-
-                        // Try Fano or Jelinek decoder
-                        if (stackdecoder) {
-                            not_decoded = jelinek(&metric, &cycles, decdata, symbols, nbits,
-                                                  stacksize, stack, mettab, maxcycles);
-                        } else {
-                            not_decoded = fano(&metric, &cycles, &maxnp, decdata, symbols, nbits,
-                                               mettab, delta, maxcycles);
-                        }
+                }
+            }
+            // Hypotheses after the winner count as not tried, whatever the threads did
+            for (k = 0; k < (winner >= 0 ? winner + 1 : nhyp); k++) {
+                if (hyp_results[k].attempted) {
+                    cycle_stats_add(opts->cycle_stats, hyp_results[k].hardmetric,
+                                    hyp_results[k].decoded && !hyp_results[k].osd_decode,
+                                    hyp_results[k].decoder_cycles, hyp_results[k].budget, nbits);
+                    stats.decoder_attempts++;
+                    stats.decoder_cycles += hyp_results[k].decoder_cycles;
+                    if (hyp_results[k].decoder_cycles >= hyp_results[k].budget * nbits) {
+                        stats.decoder_timeouts++;
                     }
-                    idt++;
-                    if (quickmode) break;
+                    if (ndepth >= 0 && (!hyp_results[k].decoded || hyp_results[k].osd_decode)) {
+                        stats.osd_attempts++;
+                    }
+                    stats.osd_decodes += hyp_results[k].osd_decode;
                 }
-                ib++;
+            }
+            stage_stop(&stats, WSPRD_STAGE_DECODE, &sc);
+            if (winner >= 0) {
+                not_decoded = 0;
+                blocksize = hyp_blocksize[winner];
+                ii = hyp_jitter[winner];
+                metric = hyp_results[winner].metric;
+                cycles = hyp_results[winner].cycles;
+                osd_decode = hyp_results[winner].osd_decode;
+                memcpy(decdata, hyp_results[winner].decdata, 11);
             }
 
             // Process successful decode
@@ -1390,13 +2454,22 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
                  */
                 noprint = unpk_(message, hashtab, call_loc_pow, callsign);
 
-                // Subtract decoded signal for multi-signal decoding
-                if (subtraction && (ipass < npasses) && !noprint) {
-                    if (get_wspr_channel_symbols(call_loc_pow, hashtab, channel_symbols)) {
-                        subtract_signal2(idat, qdat, npoints, f1, shift1, drift1, channel_symbols);
-                    } else {
-                        break;
-                    }
+                // Type 1 and 2 calls are remembered for the hashed calls of later decodes
+                if (opts->callhash != NULL && !noprint && callsign[0] != '<' && callsign[0] != '#') {
+                    callhash_insert(opts->callhash, callsign);
+                }
+
+                // Subtract decoded signal for multi-signal decoding; no pass
+                // follows the last one (deep search included in maxpasses)
+                if (subtraction && (ipass < maxpasses - 1) && !noprint) {
+                    tr0 = wsprd_trace_clock(trace);
+                    stage_start(&sc);
+                    get_wspr_channel_symbols_from_data(decdata, channel_symbols);
+                    subtract_signal_fft(ctx, idat, qdat, npoints, f1, shift1, drift1, channel_symbols);
+                    if (nsubtracted < WSPRD_MAX_DECODES) subfreqs[nsubtracted++] = f1;
+                    stats.subtractions++;
+                    stage_stop(&stats, WSPRD_STAGE_SUBTRACT, &sc);
+                    wsprd_trace_arg(wsprd_trace_span(trace, 0, "subtract", tr0), "freq", f1);
                 }
 
                 // Check for duplicate decodes (same callsign within 3 Hz)
@@ -1408,7 +2481,7 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
                 }
 
                 // Store unique decode
-                if ((verbose || !dupe) && !noprint) {
+                if ((verbose || !dupe) && !noprint && uniques < maxdecodes && uniques < 100) {
                     strcpy(allcalls[uniques], callsign);
                     allfreqs[uniques] = f1;
                     uniques++;
@@ -1438,11 +2511,25 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
                     decodes[uniques - 1].osd_decode = osd_decode;
                 }
             }
+            if (trace != NULL) {
+                struct wsprd_trace_event *e = wsprd_trace_span(trace, 0, "candidate", trcand);
+                wsprd_trace_arg(e, "freq", freq0[j]);
+                wsprd_trace_arg(e, "sync", sync1);
+                wsprd_trace_arg(e, "hypotheses", nhyp);
+                wsprd_trace_arg(e, "decoded", !not_decoded);
+            }
+        }
+        stats.pass_decodes[ipass] = ndecodes_pass;
+        if (trace != NULL) {
+            struct wsprd_trace_event *e = wsprd_trace_span(trace, 0, "pass", trpass);
+            wsprd_trace_arg(e, "pass", ipass);
+            wsprd_trace_arg(e, "candidates", npk);
+            wsprd_trace_arg(e, "decodes", ndecodes_pass);
         }
     }
 
     // Sort results by increasing frequency
-    struct result temp;
+    struct wsprd_decode temp;
     for (j = 1; j <= uniques - 1; j++) {
         for (k = 0; k < uniques - j; k++) {
             if (decodes[k].freq > decodes[k + 1].freq) {
@@ -1453,83 +2540,6 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
         }
     }
 
-    /*
-     * ============================================================
-     * BUILD JAVA RETURN ARRAY
-     * ============================================================
-     * Create array of WSPRMessage objects to return to Java.
-     * Each object contains the decoded callsign, grid, power, SNR, etc.
-     */
-    jobjectArray retn = (*env)->NewObjectArray(env, uniques, cls, 0);
-
-    // Get constructor: WSPRMessage(float snr, double freq, float dt, float drift, String message)
-    jmethodID constructor = (*env)->GetMethodID(env, cls, "<init>", "(FDFFLjava/lang/String;)V");
-
-    /*
-     * Get field IDs for setting call, loc, power fields.
-     * These fields exist in WSPRMessage.java but are not set by the constructor.
-     * The decoded message string contains "CALLSIGN GRID POWER" which we parse
-     * and set into these fields for convenient access from Java.
-     */
-    jfieldID callField = (*env)->GetFieldID(env, cls, "call", "Ljava/lang/String;");
-    jfieldID locField = (*env)->GetFieldID(env, cls, "loc", "Ljava/lang/String;");
-    jfieldID powerField = (*env)->GetFieldID(env, cls, "power", "I");
-
-    for (i = 0; i < uniques; i++) {
-        // Create the message string for the constructor
-        jstring jmessage = (*env)->NewStringUTF(env, decodes[i].message);
-
-        // Create WSPRMessage object via constructor
-        jobject object = (*env)->NewObject(
-                env, cls, constructor,
-                (jfloat) decodes[i].snr,
-                (jdouble) decodes[i].freq,
-                (jfloat) decodes[i].dt,
-                (jfloat) decodes[i].drift,
-                jmessage);
-
-        /*
-         * Parse the message string to extract individual fields.
-         * Format is "CALLSIGN GRID POWER", e.g., "N5HIM EM89 37"
-         *
-         * Note: Some messages may have different formats:
-         *   - Type 1: "CALL GRID POWER" (standard)
-         *   - Type 2: "<CALL> GRID POWER" (hashed call with <>)
-         *   - Type 3: "CALL/P GRID POWER" (portable suffix)
-         *
-         * sscanf handles these reasonably well, but edge cases may need
-         * additional parsing logic.
-         */
-        char parsed_call[13] = {0};
-        char parsed_loc[7] = {0};
-        int parsed_power = 0;
-
-        int parse_result = sscanf(decodes[i].message, "%12s %6s %d",
-                                  parsed_call, parsed_loc, &parsed_power);
-
-        if (parse_result >= 2) {
-            // Successfully parsed at least callsign and grid
-            jstring jcall = (*env)->NewStringUTF(env, parsed_call);
-            jstring jloc = (*env)->NewStringUTF(env, parsed_loc);
-
-            (*env)->SetObjectField(env, object, callField, jcall);
-            (*env)->SetObjectField(env, object, locField, jloc);
-            (*env)->SetIntField(env, object, powerField, parsed_power);
-
-            // Clean up local references to avoid JNI reference table overflow
-            (*env)->DeleteLocalRef(env, jcall);
-            (*env)->DeleteLocalRef(env, jloc);
-        }
-        // If parsing failed, fields remain null/0 (as initialized by constructor)
-
-        // Add object to return array
-        (*env)->SetObjectArrayElement(env, retn, i, object);
-
-        // Clean up local references
-        (*env)->DeleteLocalRef(env, jmessage);
-        (*env)->DeleteLocalRef(env, object);
-    }
-
     /*
      * ============================================================
      * CLEANUP
@@ -1538,11 +2548,7 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
     fftwf_free(fftin);
     fftwf_free(fftout);
 
-    ttotal += (float) (clock() - t00) / CLOCKS_PER_SEC;
-
-    fftwf_destroy_plan(PLAN1);
-    fftwf_destroy_plan(PLAN2);
-    fftwf_destroy_plan(PLAN3);
+    destroy_plan(plan3);
 
     free(hashtab);
     free(symbols);
@@ -1552,14 +2558,21 @@ jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
     free(call_loc_pow);
     free(idat);
     free(qdat);
-    if (stackdecoder) {
-        free(stack);
-    }
-
-    return retn;
+    free(apmask);
+    free(cw);
+    if (pool != NULL) stats.cpu_seconds[WSPRD_STAGE_DECODE] += pool->worker_cpu;
+    stats.total_wall_seconds = wsprd_wallclock() - sc_total.wall;
+    stats.total_cpu_seconds = wsprd_cpuclock() - sc_total.cpu;
+    if (pool != NULL) stats.total_cpu_seconds += pool->worker_cpu;
+    if (opts->stats != NULL) *opts->stats = stats;
+    decode_pool_free(pool);
+    wsprd_context_free(ctx);
+
+    return uniques;
 }
 
 
+#ifndef WSPRD_NO_MAIN
 int main(int argc, char *argv[]) {
     char cr[] = "(C) 2018, Steven Franke - K9AN";
     (void) cr;
@@ -1576,21 +2589,18 @@ int main(int argc, char *argv[]) {
     char uttime[5], date[7];
     int c, delta, maxpts = 65536, verbose = 0, quickmode = 0, more_candidates = 0, stackdecoder = 0;
     int writenoise = 0, usehashtable = 1, wspr_type = 2, ipass, nblocksize;
-    int nhardmin, ihash;
     int writec2 = 0, maxdrift;
-    int shift1, lagmin, lagmax, lagstep, ifmin, ifmax, worth_a_try, not_decoded;
+    int shift1, worth_a_try, not_decoded;
     unsigned int nbits = 81, stacksize = 200000;
     unsigned int npoints, metric, cycles, maxnp;
     float df = 375.0 / 256.0 / 2;
     float freq0[200], snr0[200], drift0[200], sync0[200];
-    float fsymbs[WSPR_NUMSYMBOLS];
     int shift0[200];
     float dt = 1.0 / 375.0, dt_print;
     double dialfreq_cmdline = 0.0, dialfreq, freq_print;
     double dialfreq_error = 0.0;
     float fmin = -110, fmax = 110;
-    float f1, fstep, sync1, drift1;
-    float dmin;
+    float f1, sync1, drift1;
     float psavg[512];
     float *idat, *qdat;
     clock_t t0, t00;
@@ -1640,27 +2650,32 @@ int main(int argc, char *argv[]) {
     int block_demod = 1;                       //Default is to use block demod on pass 2
     int subtraction = 1;
     int npasses = 2;
+    int deep_search = 0;                       //Extra pass with long blocks
     int ndepth = -1;                            //Depth for OSD
+    int adaptive_cycles = 0;                   //Scale maxcycles by candidate quality
+    struct wsprd_cycle_stats cycle_stats;
+    memset(&cycle_stats, 0, sizeof(cycle_stats));
 
     float minrms = 52.0 * (symfac / 64.0);      //Final test for plausible decoding
     delta = 60;                                //Fano threshold step
-    float bias = 0.45;                        //Fano metric bias (used for both Fano and stack algorithms)
+    float bias = WSPRD_DEFAULT_BIAS;           //Fano metric bias (used for both Fano and stack algorithms)
 
     t00 = clock();
     fftwf_complex *fftin, *fftout;
 
-#include "./metric_tables.c"
-
-    int mettab[2][256];
+    const int (*mettab)[256];
 
     idat = calloc(maxpts, sizeof(float));
     qdat = calloc(maxpts, sizeof(float));
 
-    while ((c = getopt(argc, argv, "a:BcC:de:f:HJmo:qstwvz:")) != -1) {
+    while ((c = getopt(argc, argv, "a:ABcC:dDe:f:HJmo:qstwvz:")) != -1) {
         switch (c) {
             case 'a':
                 data_dir = optarg;
                 break;
+            case 'A':  //adaptive decoder cycle budget
+                adaptive_cycles = 1;
+                break;
             case 'B':
                 block_demod = 0;
                 break;
@@ -1673,6 +2688,9 @@ int main(int argc, char *argv[]) {
             case 'd':
                 more_candidates = 1;
                 break;
+            case 'D':  //extra pass with 6- and 9-symbol blocks
+                deep_search = 1;
+                break;
             case 'e':
                 dialfreq_error = strtod(optarg, NULL);   // units of Hz
                 // dialfreq_error = dial reading - actual, correct frequency
@@ -1715,8 +2733,13 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (deep_search && npasses == 2) npasses = 3;
+
+
+    // Scratch memory for demodulation and subtraction, reused for every candidate
+    struct wsprd_context *ctx = wsprd_context_alloc((128 / iifac + 1) / 2);
     if (stackdecoder) {
-        stack = calloc(stacksize, sizeof(struct snode));
+        ctx->jelinek = jelinek_workspace_alloc(stacksize);
     }
 
     if (optind + 1 > argc) {
@@ -1726,11 +2749,8 @@ int main(int argc, char *argv[]) {
         ptr_to_infile = argv[optind];
     }
 
-    // setup metric table
-    for (i = 0; i < 256; i++) {
-        mettab[0][i] = round(10 * (metric_tables[2][i] - bias));
-        mettab[1][i] = round(10 * (metric_tables[2][255 - i] - bias));
-    }
+    // metric table for the chosen bias, built once and cached
+    mettab = metric_table(bias);
 
     FILE *fp_fftwf_wisdom_file, *fall_wspr, *fwsprd, *fhash, *ftimer;
     strcpy(wisdom_fname, ".");
@@ -1842,6 +2862,11 @@ int main(int argc, char *argv[]) {
                 minsync2 = 0.12;
             }
         }
+        if (ipass == 2) {      // -D: add 6- and 9-symbol blocks
+            nblocksize = 9;
+            maxdrift = 0;
+            minsync2 = 0.10;
+        }
         ndecodes_pass = 0;   // still needed?
 
         for (i = 0; i < nffts; i++) {
@@ -2042,13 +3067,11 @@ int main(int argc, char *argv[]) {
          Sync is calculated such that it is a float taking values in the range
          [0.0,1.0].
 
-         Function sync_and_demodulate has three modes of operation
-         mode is the last argument:
-
-         0 = no frequency or drift search. find best time lag.
-         1 = no time lag or drift search. find best frequency.
-         2 = no frequency or time lag search. Calculate soft-decision
-         symbols using passed frequency and shift.
+         Function sync_search_grid evaluates every (drift, frequency, lag)
+         hypothesis of the requested grid in a single pass and returns the
+         best one. The lag-only and frequency-only sweeps below replace the
+         old sync_and_demodulate modes 0 and 1; the two drift offsets tried
+         on the first pass share one sweep.
 
          NB: best possibility for OpenMP may be here: several worker threads
          could each work on one candidate at a time.
@@ -2064,44 +3087,30 @@ int main(int argc, char *argv[]) {
             sync1 = sync0[j];
 
             // coarse-grid lag and freq search, then if sync>minsync1 continue
-            fstep = 0.0;
-            ifmin = 0;
-            ifmax = 0;
-            lagmin = shift1 - 128;
-            lagmax = shift1 + 128;
-            lagstep = 64;
             t0 = clock();
-            sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 0);
+            sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1 - 128, shift1 + 128, 64,
+                             &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
             tsync0 += (float) (clock() - t0) / CLOCKS_PER_SEC;
 
-            fstep = 0.25;
-            ifmin = -2;
-            ifmax = 2;
             t0 = clock();
-            sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 1);
+            sync_search_grid(idat, qdat, npoints, f1, -2, 2, 0.25, shift1, shift1, 0,
+                             &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
 
             if (ipass == 0) {
-                // refine drift estimate
-                fstep = 0.0;
-                ifmin = 0;
-                ifmax = 0;
-                float driftp, driftm, syncp, syncm;
-                driftp = drift1 + 0.5;
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &driftp, symfac, &syncp, 1);
-
-                driftm = drift1 - 0.5;
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &driftm, symfac, &syncm, 1);
-
-                if (syncp > sync1) {
-                    drift1 = driftp;
-                    sync1 = syncp;
-                } else if (syncm > sync1) {
-                    drift1 = driftm;
-                    sync1 = syncm;
+                // refine drift estimate, both offsets in one sweep
+                float drifts[2], hsync[2], fd, dd, sd;
+                int shiftd;
+                drifts[0] = drift1 + 0.5;
+                drifts[1] = drift1 - 0.5;
+                sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1, shift1, 0,
+                                 drifts, 2, &fd, &shiftd, &dd, &sd, hsync);
+
+                if (hsync[0] > sync1) {
+                    drift1 = drifts[0];
+                    sync1 = hsync[0];
+                } else if (hsync[1] > sync1) {
+                    drift1 = drifts[1];
+                    sync1 = hsync[1];
                 }
             }
             tsync1 += (float) (clock() - t0) / CLOCKS_PER_SEC;
@@ -2109,21 +3118,15 @@ int main(int argc, char *argv[]) {
             // fine-grid lag and freq search
             if (sync1 > minsync1) {
 
-                lagmin = shift1 - 32;
-                lagmax = shift1 + 32;
-                lagstep = 16;
                 t0 = clock();
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 0);
+                sync_search_grid(idat, qdat, npoints, f1, 0, 0, 0.0, shift1 - 32, shift1 + 32, 16,
+                                 &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
                 tsync0 += (float) (clock() - t0) / CLOCKS_PER_SEC;
 
                 // fine search over frequency
-                fstep = 0.05;
-                ifmin = -2;
-                ifmax = 2;
                 t0 = clock();
-                sync_and_demodulate(idat, qdat, npoints, symbols, &f1, ifmin, ifmax, fstep, &shift1,
-                                    lagmin, lagmax, lagstep, &drift1, symfac, &sync1, 1);
+                sync_search_grid(idat, qdat, npoints, f1, -2, 2, 0.05, shift1, shift1, 0,
+                                 &drift1, 1, &f1, &shift1, &drift1, &sync1, NULL);
                 tsync1 += (float) (clock() - t0) / CLOCKS_PER_SEC;
 
                 worth_a_try = 1;
@@ -2131,14 +3134,20 @@ int main(int argc, char *argv[]) {
                 worth_a_try = 0;
             }
 
-            int idt, ii, jittered_shift;
+            int idt, ii = 0, jittered_shift;
             float y, sq, rms;
+            long hardmetric;
+            unsigned int budget;
             not_decoded = 1;
             int osd_decode = 0;
-            int ib = 1, blocksize;
-            int n1, n2, n3, nadd, nu, ntype;
-            while (ib <= nblocksize && not_decoded) {
-                blocksize = ib;
+            int ib = 0, blocksize = 1;
+            if (worth_a_try) {
+                t0 = clock();
+                symbol_corr_bank_init(ctx->corrbank, idat, qdat, npoints, f1, shift1, drift1, iifac);
+                tsync2 += (float) (clock() - t0) / CLOCKS_PER_SEC;
+            }
+            while (ib < NBLOCK_LENGTHS && block_lengths[ib] <= nblocksize && not_decoded) {
+                blocksize = block_lengths[ib];
                 idt = 0;
                 ii = 0;
                 while (worth_a_try && not_decoded && idt <= (128 / iifac)) {
@@ -2147,10 +3156,10 @@ int main(int argc, char *argv[]) {
                     ii = iifac * ii;
                     jittered_shift = shift1 + ii;
 
-                    // Use mode 2 to get soft-decision symbols
+                    // Soft-decision symbols from the shared correlation bank
                     t0 = clock();
-                    noncoherent_sequence_detection(idat, qdat, npoints, symbols, &f1,
-                                                   &jittered_shift, &drift1, symfac, &blocksize);
+                    symbol_corr_bank_detect(ctx->corrbank, idat, qdat, npoints, jittered_shift,
+                                            blocksize, symfac, symbols);
                     tsync2 += (float) (clock() - t0) / CLOCKS_PER_SEC;
 
                     sq = 0.0;
@@ -2164,15 +3173,26 @@ int main(int argc, char *argv[]) {
                         deinterleave(symbols);
                         t0 = clock();
 
+                        hardmetric = hard_decision_metric(symbols, mettab);
+                        budget = maxcycles;
+                        if (adaptive_cycles) budget = cycle_budget(maxcycles, sync1, hardmetric);
                         if (stackdecoder) {
-                            not_decoded = jelinek(&metric, &cycles, decdata, symbols, nbits,
-                                                  stacksize, stack, mettab, maxcycles);
+                            not_decoded = jelinek_decode(ctx->jelinek, &metric, &cycles, decdata,
+                                                         symbols, nbits, mettab, budget);
                         } else {
-                            not_decoded = fano(&metric, &cycles, &maxnp, decdata, symbols, nbits,
-                                               mettab, delta, maxcycles);
+                            not_decoded = fano_arena_decode(ctx->fano, &metric, &cycles, &maxnp,
+                                                            decdata, symbols, nbits, mettab,
+                                                            delta, budget);
+                        }
+                        cycle_stats_add(&cycle_stats, hardmetric, !not_decoded, cycles, budget,
+                                        nbits);
+
+                        if (not_decoded && ndepth >= 0) {
+                            not_decoded = osd_decode_symbols(ctx->fano, symbols, apmask, ndepth,
+                                                             cw, hashtab, &metric, &cycles,
+                                                             decdata, mettab, delta, maxcycles);
+                            osd_decode = !not_decoded;
                         }
-
-
                     }
                     idt++;
                     if (quickmode) break;
@@ -2200,11 +3220,8 @@ int main(int argc, char *argv[]) {
 
                 // subtract even on last pass
                 if (subtraction && (ipass < npasses) && !noprint) {
-                    if (get_wspr_channel_symbols(call_loc_pow, hashtab, channel_symbols)) {
-                        subtract_signal2(idat, qdat, npoints, f1, shift1, drift1, channel_symbols);
-                    } else {
-                        break;
-                    }
+                    get_wspr_channel_symbols_from_data(decdata, channel_symbols);
+                    subtract_signal_fft(ctx, idat, qdat, npoints, f1, shift1, drift1, channel_symbols);
                 }
 
                 // Remove dupes (same callsign and freq within 3 Hz)
@@ -2313,6 +3330,13 @@ int main(int argc, char *argv[]) {
     fprintf(ftimer, "Stack/Fano decoder %7.2f %7.2f\n", tfano, tfano / ttotal);
     fprintf(ftimer, "-----------------------------------\n");
     fprintf(ftimer, "Total              %7.2f %7.2f\n", ttotal, 1.0);
+    fprintf(ftimer, "Fano decodes %lu, cycles %llu\n", ctx->fano->ncalls, ctx->fano->cycles);
+    if (ctx->jelinek) {
+        fprintf(ftimer, "Stack decodes %lu, cycles %llu\n", ctx->jelinek->ncalls,
+                ctx->jelinek->cycles);
+    }
+    fprintf(ftimer, "\n");
+    cycle_stats_print(ftimer, &cycle_stats);
 
     fclose(fall_wspr);
     fclose(fwsprd);
@@ -2340,10 +3364,9 @@ int main(int argc, char *argv[]) {
     free(call_loc_pow);
     free(idat);
     free(qdat);
-    if (stackdecoder) {
-        free(stack);
-    }
+    wsprd_context_free(ctx);
 
     if (writenoise == 999) return -1;  //Silence compiler warning
     return 0;
 }
+#endif
@@ -0,0 +1,139 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprd_decoder.h
+
+ Description: Options, results and entry point of the decoder core.
+ The JNI wrapper (jani_do_process) lives in wsprd_jni.c.
+ */
+
+#ifndef WSPRD_DECODER_H
+#define WSPRD_DECODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WSPRD_MAX_DECODES 50   // Max unique decodes per processing run
+#define WSPRD_MAX_PASSES  8    // Upper bound on max_passes
+#define WSPRD_MAX_THREADS 8    // Upper bound on decode_threads
+#define WSPRD_QUALITY_BINS 12  // Soft-symbol quality bins in wsprd_cycle_stats
+
+struct callhash;
+struct wsprd_trace;
+
+/*
+ * Outcome of sequential-decoder attempts by soft-symbol quality, for
+ * tuning the adaptive cycle budget. Quality is the hard-decision path
+ * metric per symbol (metric table units); bin b covers
+ * [2.0 + 0.25 b, 2.25 + 0.25 b), the first and last bins are open-ended.
+ */
+struct wsprd_cycle_stats {
+    unsigned long attempts[WSPRD_QUALITY_BINS];
+    unsigned long decodes[WSPRD_QUALITY_BINS];   // by Fano/Jelinek, not OSD
+    unsigned long timeouts[WSPRD_QUALITY_BINS];  // budget exhausted
+    unsigned long long cycles[WSPRD_QUALITY_BINS];
+    unsigned long long budget[WSPRD_QUALITY_BINS];
+};
+
+/*
+ * Stages of a decode, for the per-stage times in wsprd_stats.
+ */
+enum wsprd_stage {
+    WSPRD_STAGE_READWAV,     // PCM to 375 Hz baseband
+    WSPRD_STAGE_SPECTRUM,    // spectrogram and spectral peaks, every pass
+    WSPRD_STAGE_CANDIDATES,  // coarse time, frequency and drift of each peak
+    WSPRD_STAGE_SYNC0,       // lag searches
+    WSPRD_STAGE_SYNC1,       // frequency and drift refinement
+    WSPRD_STAGE_SYNC2,       // symbol correlation at the refined lag
+    WSPRD_STAGE_DECODE,      // demodulation, Fano/Jelinek and OSD
+    WSPRD_STAGE_SUBTRACT,    // subtraction of decoded signals
+    WSPRD_STAGES
+};
+
+/*
+ * Where one decode spent its time and memory. CPU time is that of the
+ * calling thread, plus that of the decode_threads workers in the decode
+ * stage, so it stays meaningful when several decodes run at once.
+ * Decoder attempts count hypotheses up to the one that decoded, as in
+ * wsprd_cycle_stats.
+ */
+struct wsprd_stats {
+    double wall_seconds[WSPRD_STAGES];
+    double cpu_seconds[WSPRD_STAGES];
+    double total_wall_seconds;
+    double total_cpu_seconds;
+    int passes;                               // passes run
+    int candidates[WSPRD_MAX_PASSES];         // spectral peaks tried per pass
+    int pass_decodes[WSPRD_MAX_PASSES];       // messages decoded per pass
+    unsigned long decoder_attempts;           // Fano/Jelinek runs
+    unsigned long decoder_timeouts;           // runs that exhausted the cycle budget
+    unsigned long long decoder_cycles;
+    unsigned long osd_attempts;
+    unsigned long osd_decodes;
+    int subtractions;
+    unsigned long peak_scratch_bytes;         // largest working set, excluding the input PCM
+};
+
+/*
+ * Decoder options. wsprd_options_init() fills in the defaults, which
+ * reproduce the behaviour of WSPRDecodeFromPcm without options.
+ */
+struct wsprd_options {
+    int deep_search;    // extra pass that also tries 6- and 9-symbol blocks
+    int max_passes;     // keep running passes on the residual while they find
+                        // new messages, up to this many (at least 2)
+    int deadline_ms;    // no new pass or candidate is started after this many
+                        // milliseconds; 0 for no limit. Pass 0 always completes.
+    int osd_depth;      // ordered-statistics fallback after Fano fails,
+                        // depth 0..5; -1 disables it
+    int stack_decoder;  // decode with the Jelinek stack decoder instead of Fano
+    int decode_threads; // threads (including the caller's) that try a
+                        // candidate's jitter/block hypotheses speculatively;
+                        // results do not depend on it. 1 = sequential.
+    int adaptive_cycles;  // scale the per-bit cycle budget by candidate quality
+                          // instead of spending the full budget on every attempt
+    struct wsprd_cycle_stats *cycle_stats;  // if not NULL, attempts are added here
+    float metric_bias;    // Fano/Jelinek metric bias; tables are cached per value
+    struct callhash *callhash;  // persistent callsign store, see callhash.h; NULL
+                                // keeps hashed calls to this decode only
+    struct wsprd_stats *stats;  // if not NULL, overwritten with this decode's statistics
+    struct wsprd_trace *trace;  // if not NULL, spans of this decode are added to it;
+                                // see wsprd_trace.h
+};
+
+void wsprd_options_init(struct wsprd_options *opts);
+
+/*
+ * One decoded WSPR message with timing, frequency, SNR and the
+ * decoder statistics that produced it.
+ */
+struct wsprd_decode {
+    char date[7];
+    char time[5];
+    float sync;
+    float snr;
+    float dt;
+    double freq;
+    char message[23];  // Contains "CALLSIGN GRID POWER"
+    float drift;
+    unsigned int cycles;
+    int jitter;
+    int blocksize;
+    unsigned int metric;
+    unsigned char osd_decode;
+};
+
+/*
+ * Decode 114 s of 12 kHz 16-bit mono PCM. opts may be NULL for defaults.
+ * Stores at most maxdecodes results, sorted by frequency, and returns
+ * their number.
+ */
+int wsprd_decode(unsigned char *soundarr, int sarlen, double dialfreq, int lsb_mode,
+                 const struct wsprd_options *opts, struct wsprd_decode *decodes, int maxdecodes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprd_jni.c
+
+ Description: JNI wrapper around wsprd_decode(). Converts the decoder's
+ results into org.operatorfoundation.audiocoder.WSPRMessage objects.
+ */
+
+#include <stdio.h>
+#include <jni.h>
+#include "wsprd_decoder.h"
+
+/**
+ * jani_do_process - Main WSPR decoding function called from Java via JNI
+ *
+ * @param env         JNI environment pointer for Java interop
+ * @param clazz       Java class reference (unused but required by JNI)
+ * @param soundarr    Raw PCM audio data as unsigned char array (16-bit samples, little-endian)
+ * @param sarlen      Length of soundarr in bytes
+ * @param jdialfreq   Dial frequency in MHz (e.g., 14.0956 for 20m WSPR)
+ * @param lsb_mode    If true, inverts symbol order for lower sideband reception
+ * @param opts        Decoder options, or NULL for the defaults
+ *
+ * @return jobjectArray of WSPRMessage objects containing decoded messages,
+ *         or empty array if no messages decoded
+ */
+jobjectArray jani_do_process(JNIEnv *env, jclass clazz,
+                             unsigned char *soundarr, int sarlen, double jdialfreq,
+                             jboolean lsb_mode, const struct wsprd_options *opts) {
+    struct wsprd_decode decodes[WSPRD_MAX_DECODES];
+    int uniques, i;
+
+    jclass cls = (*env)->FindClass(env, "org/operatorfoundation/audiocoder/WSPRMessage");
+
+    uniques = wsprd_decode(soundarr, sarlen, jdialfreq, lsb_mode, opts,
+                           decodes, WSPRD_MAX_DECODES);
+
+    /*
+     * ============================================================
+     * BUILD JAVA RETURN ARRAY
+     * ============================================================
+     * Create array of WSPRMessage objects to return to Java.
+     * Each object contains the decoded callsign, grid, power, SNR, etc.
+     */
+    jobjectArray retn = (*env)->NewObjectArray(env, uniques, cls, 0);
+
+    // Get constructor: WSPRMessage(float snr, double freq, float dt, float drift, String message)
+    jmethodID constructor = (*env)->GetMethodID(env, cls, "<init>", "(FDFFLjava/lang/String;)V");
+
+    /*
+     * Get field IDs for setting call, loc, power fields.
+     * These fields exist in WSPRMessage.java but are not set by the constructor.
+     * The decoded message string contains "CALLSIGN GRID POWER" which we parse
+     * and set into these fields for convenient access from Java.
+     */
+    jfieldID callField = (*env)->GetFieldID(env, cls, "call", "Ljava/lang/String;");
+    jfieldID locField = (*env)->GetFieldID(env, cls, "loc", "Ljava/lang/String;");
+    jfieldID powerField = (*env)->GetFieldID(env, cls, "power", "I");
+
+    for (i = 0; i < uniques; i++) {
+        // Create the message string for the constructor
+        jstring jmessage = (*env)->NewStringUTF(env, decodes[i].message);
+
+        // Create WSPRMessage object via constructor
+        jobject object = (*env)->NewObject(
+                env, cls, constructor,
+                (jfloat) decodes[i].snr,
+                (jdouble) decodes[i].freq,
+                (jfloat) decodes[i].dt,
+                (jfloat) decodes[i].drift,
+                jmessage);
+
+        /*
+         * Parse the message string to extract individual fields.
+         * Format is "CALLSIGN GRID POWER", e.g., "N5HIM EM89 37"
+         *
+         * Note: Some messages may have different formats:
+         *   - Type 1: "CALL GRID POWER" (standard)
+         *   - Type 2: "<CALL> GRID POWER" (hashed call with <>)
+         *   - Type 3: "CALL/P GRID POWER" (portable suffix)
+         *
+         * sscanf handles these reasonably well, but edge cases may need
+         * additional parsing logic.
+         */
+        char parsed_call[13] = {0};
+        char parsed_loc[7] = {0};
+        int parsed_power = 0;
+
+        int parse_result = sscanf(decodes[i].message, "%12s %6s %d",
+                                  parsed_call, parsed_loc, &parsed_power);
+
+        if (parse_result >= 2) {
+            // Successfully parsed at least callsign and grid
+            jstring jcall = (*env)->NewStringUTF(env, parsed_call);
+            jstring jloc = (*env)->NewStringUTF(env, parsed_loc);
+
+            (*env)->SetObjectField(env, object, callField, jcall);
+            (*env)->SetObjectField(env, object, locField, jloc);
+            (*env)->SetIntField(env, object, powerField, parsed_power);
+
+            // Clean up local references to avoid JNI reference table overflow
+            (*env)->DeleteLocalRef(env, jcall);
+            (*env)->DeleteLocalRef(env, jloc);
+        }
+        // If parsing failed, fields remain null/0 (as initialized by constructor)
+
+        // Add object to return array
+        (*env)->SetObjectArrayElement(env, retn, i, object);
+
+        // Clean up local references
+        (*env)->DeleteLocalRef(env, jmessage);
+        (*env)->DeleteLocalRef(env, object);
+    }
+
+    return retn;
+}
@@ -0,0 +1,55 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprd_kernels.h
+
+ Description: Internal signal-processing stages of wsprd.c, exposed for
+ the host benchmark (wsprbench). Decoder users want wsprd_decoder.h.
+ All of them work on the 375 Hz complex baseband that ReadWavFileEx()
+ produces (np samples in id/qd).
+ */
+
+#ifndef WSPRD_KERNELS_H
+#define WSPRD_KERNELS_H
+
+#include "fftw3.h"
+
+// C only: the spectrogram is passed as a variably modified array
+
+struct wsprd_context;
+
+// 114 s of 12 kHz 16-bit PCM to baseband; returns the number of samples, 1 on failure
+unsigned long ReadWavFileEx(unsigned char *soundarr, int sarlen, int ntrmin, float *idat, float *qdat);
+
+void compute_spectrogram(float *idat, float *qdat, int nffts, const float *w,
+                         fftwf_complex *fftin, fftwf_complex *fftout, fftwf_plan plan,
+                         float ps[][nffts], float *psavg);
+
+void coarse_candidate_search(int nffts, float ps[][nffts], int npk, int maxdrift,
+                             float *freq0, int *shift0, float *drift0, float *sync0);
+
+void sync_and_demodulate(float *id, float *qd, long np,
+                         unsigned char *symbols, float *f1, int ifmin, int ifmax, float fstep,
+                         int *shift1, int lagmin, int lagmax, int lagstep,
+                         float *drift1, int symfac, float *sync, int mode);
+
+void sync_search_grid(float *id, float *qd, long np,
+                      float f0, int ifmin, int ifmax, float fstep,
+                      int lagmin, int lagmax, int lagstep,
+                      float *drifts, int ndrift,
+                      float *f1, int *shift1, float *drift1, float *sync,
+                      float *hsync);
+
+void noncoherent_sequence_detection(float *id, float *qd, long np,
+                                    unsigned char *symbols, float *f1, int *shift1,
+                                    float *drift1, int symfac, int *nblocksize);
+
+void subtract_signal2(float *id, float *qd, long np,
+                      float f0, int shift0, float drift0, unsigned char *channel_symbols);
+
+struct wsprd_context *wsprd_context_alloc(int njitter);
+void wsprd_context_free(struct wsprd_context *ctx);
+void subtract_signal_fft(struct wsprd_context *ctx, float *id, float *qd, long np,
+                         float f0, int shift0, float drift0, unsigned char *channel_symbols);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprd_trace.c
+
+ Description: Span recorder and Chrome trace JSON writer.
+
+ Spans are kept in a fixed array and claimed with an atomic counter, so
+ decode workers record without taking a lock. Each span is one complete
+ ("ph":"X") event, written when it ends; the viewer nests spans of a
+ thread by time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "wsprd_trace.h"
+
+#define WSPRD_TRACE_MAX_TIDS 64
+
+struct wsprd_trace {
+    struct wsprd_trace_event *events;
+    int capacity;
+    int count;              // spans claimed, may exceed capacity
+    double t0;              // CLOCK_MONOTONIC seconds at the last reset
+};
+
+static double trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct wsprd_trace *wsprd_trace_alloc(int capacity) {
+    struct wsprd_trace *trace = calloc(1, sizeof(struct wsprd_trace));
+
+    if (trace == NULL) return NULL;
+    trace->events = malloc(sizeof(struct wsprd_trace_event) * capacity);
+    if (trace->events == NULL) {
+        free(trace);
+        return NULL;
+    }
+    trace->capacity = capacity;
+    trace->t0 = trace_now();
+    return trace;
+}
+
+void wsprd_trace_free(struct wsprd_trace *trace) {
+    if (trace == NULL) return;
+    free(trace->events);
+    free(trace);
+}
+
+void wsprd_trace_reset(struct wsprd_trace *trace) {
+    trace->count = 0;
+    trace->t0 = trace_now();
+}
+
+double wsprd_trace_clock(const struct wsprd_trace *trace) {
+    if (trace == NULL) return 0.0;
+    return trace_now() - trace->t0;
+}
+
+struct wsprd_trace_event *wsprd_trace_span(struct wsprd_trace *trace, int tid, const char *name,
+                                           double start) {
+    struct wsprd_trace_event *e;
+    int i;
+
+    if (trace == NULL) return NULL;
+    i = __atomic_fetch_add(&trace->count, 1, __ATOMIC_RELAXED);
+    if (i >= trace->capacity) return NULL;
+    e = &trace->events[i];
+    e->name = name;
+    e->start = start;
+    e->duration = trace_now() - trace->t0 - start;
+    e->tid = tid;
+    e->nargs = 0;
+    return e;
+}
+
+void wsprd_trace_arg(struct wsprd_trace_event *e, const char *key, double value) {
+    if (e == NULL || e->nargs == WSPRD_TRACE_ARGS) return;
+    e->key[e->nargs] = key;
+    e->value[e->nargs] = value;
+    e->nargs++;
+}
+
+int wsprd_trace_write(const struct wsprd_trace *trace, const char *path) {
+    const struct wsprd_trace_event *e;
+    char seen[WSPRD_TRACE_MAX_TIDS] = {0}, num[32];
+    int n = trace->count < trace->capacity ? trace->count : trace->capacity;
+    int i, k;
+    FILE *fp;
+
+    if ((fp = fopen(path, "w")) == NULL) return 0;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%d},\"traceEvents\":[\n",
+            trace->count - n);
+    for (i = 0; i < n; i++) {
+        e = &trace->events[i];
+        if (e->tid >= 0 && e->tid < WSPRD_TRACE_MAX_TIDS && !seen[e->tid]) {
+            seen[e->tid] = 1;
+            if (e->tid == 0) {
+                fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                            "\"args\":{\"name\":\"wsprd\"}},\n");
+            } else {
+                fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"name\":\"decode worker %d\"}},\n", e->tid, e->tid);
+            }
+        }
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"wsprd\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":1,\"tid\":%d,\"args\":{",
+                e->name, 1e6 * e->start, 1e6 * e->duration, e->tid);
+        for (k = 0; k < e->nargs; k++) {
+            // JSON has no inf or nan; tested on the text, as -ffast-math folds isfinite()
+            snprintf(num, sizeof(num), "%.9g", e->value[k]);
+            fprintf(fp, "%s\"%s\":%s", k ? "," : "", e->key[k], strchr(num, 'n') ? "null" : num);
+        }
+        fprintf(fp, "}}%s\n", i < n - 1 ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,60 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprd_trace.h
+
+ Description: Span trace of a decode (passes, candidates, sync searches,
+ Fano/Jelinek attempts, subtractions) in Chrome trace JSON, which
+ chrome://tracing and ui.perfetto.dev open as a timeline. Set
+ wsprd_options.trace to record one; with it NULL every call below
+ returns at once.
+ */
+
+#ifndef WSPRD_TRACE_H
+#define WSPRD_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WSPRD_TRACE_ARGS 4  // numeric arguments per span
+
+struct wsprd_trace;
+
+struct wsprd_trace_event {
+    const char *name;       // string literal, written without escaping
+    double start, duration; // seconds since the trace was reset
+    int tid;                // 0 for the decoding thread, k for decode worker k
+    int nargs;
+    const char *key[WSPRD_TRACE_ARGS];
+    double value[WSPRD_TRACE_ARGS];
+};
+
+// Room for capacity spans; later spans are counted as dropped. NULL if out of memory.
+struct wsprd_trace *wsprd_trace_alloc(int capacity);
+void wsprd_trace_free(struct wsprd_trace *trace);
+
+// Drops every span and restarts the clock
+void wsprd_trace_reset(struct wsprd_trace *trace);
+
+// Seconds since the trace was reset, as the start of a span; 0 if trace is NULL
+double wsprd_trace_clock(const struct wsprd_trace *trace);
+
+/*
+ * Records a span from start to now. Safe to call from several threads.
+ * Returns the span to add arguments to, or NULL if trace is NULL or full.
+ */
+struct wsprd_trace_event *wsprd_trace_span(struct wsprd_trace *trace, int tid, const char *name,
+                                           double start);
+
+// Adds key: value to the span's arguments; does nothing if e is NULL
+void wsprd_trace_arg(struct wsprd_trace_event *e, const char *key, double value);
+
+// Writes the spans as Chrome trace JSON; returns 0 on failure
+int wsprd_trace_write(const struct wsprd_trace *trace, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
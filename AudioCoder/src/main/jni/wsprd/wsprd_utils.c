@@ -303,12 +303,11 @@ int unpk_(signed char *message, char *hashtab, char *call_loc_pow, char *callsig
         }
 
         ihash = (n2 - ntype - 64) / 128;
-        sprintf(callsign,"#%d",ihash);
-        /*if (strncmp(hashtab + ihash * 13, "\0", 1) != 0) {
-            sprintf(callsign, "<%s>", hashtab + ihash * 13);
+        if (strncmp(hashtab + ihash * 13, "\0", 1) != 0) {
+            snprintf(callsign, 13, "<%s>", hashtab + ihash * 13);
         } else {
-            sprintf(callsign, "%5s", "<...>");
-        }*/
+            sprintf(callsign, "#%d", ihash);  // call not heard yet
+        }
 
         memset(call_loc_pow, 0, sizeof(char) * 23);
         sprintf(cdbm, "%2d", ndbm);
@@ -0,0 +1,396 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprmc.c
+
+ Description: Monte Carlo sensitivity test for the decoder. For every
+ SNR of a sweep it synthesizes many frames holding one known message
+ (plus optional interferers) at random frequency, time offset and
+ drift, decodes them with wsprd_decode() on a pool of threads and
+ reports the decode probability, false decodes and time spent, the
+ latter also broken down by decoder stage.
+
+ Trials are seeded from (seed, SNR step, trial), so a run gives the same
+ counts for any number of threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "wsprd_decoder.h"
+#include "wsprsim_channel.h"
+
+#define MAX_SNRS 128
+#define MAX_INTERFERERS 8
+
+// Interferers are drawn from these; none collides with the default message
+static const char *interferer_msgs[MAX_INTERFERERS] = {
+    "W9XYZ EN61 30", "G4ABC IO91 23", "JA1ZZZ PM95 40", "VK2ABC QF56 33",
+    "N0CALL EM10 10", "DL1AAA JO62 20", "PY2XX GG66 27", "ZL1ZZ RF70 37"
+};
+
+struct snr_result {
+    unsigned long trials, decoded, false_decodes;
+    double synth_seconds, decode_seconds, decode_cpu_seconds;
+};
+
+static const char *stage_names[WSPRD_STAGES] = {
+    "readwav", "spectrum", "candidates", "sync0", "sync1", "sync2", "decode", "subtract"
+};
+
+struct mc_config {
+    const char *message;
+    int ntrials, nsnr, ninterferers;
+    float snr[MAX_SNRS];
+    float freq_spread, dt_spread, max_drift;
+    uint64_t seed;
+    struct wsprd_options opts;
+
+    unsigned char symbols[1 + MAX_INTERFERERS][162];
+    char expected[1 + MAX_INTERFERERS][23];  // normalized messages
+
+    pthread_mutex_t lock;
+    long next_job;
+    struct snr_result results[MAX_SNRS];
+    struct wsprd_stats totals;        // summed over every decode
+    unsigned long max_scratch_bytes;
+};
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void stats_add(struct wsprd_stats *sum, const struct wsprd_stats *s) {
+    int i;
+
+    for (i = 0; i < WSPRD_STAGES; i++) {
+        sum->wall_seconds[i] += s->wall_seconds[i];
+        sum->cpu_seconds[i] += s->cpu_seconds[i];
+    }
+    sum->total_wall_seconds += s->total_wall_seconds;
+    sum->total_cpu_seconds += s->total_cpu_seconds;
+    sum->passes += s->passes;
+    for (i = 0; i < WSPRD_MAX_PASSES; i++) {
+        sum->candidates[i] += s->candidates[i];
+        sum->pass_decodes[i] += s->pass_decodes[i];
+    }
+    sum->decoder_attempts += s->decoder_attempts;
+    sum->decoder_timeouts += s->decoder_timeouts;
+    sum->decoder_cycles += s->decoder_cycles;
+    sum->osd_attempts += s->osd_attempts;
+    sum->osd_decodes += s->osd_decodes;
+    sum->subtractions += s->subtractions;
+}
+
+static void print_stage_stats(const struct mc_config *cfg, long ndecodes) {
+    const struct wsprd_stats *t = &cfg->totals;
+    int i;
+
+    printf("\nStage         Wall ms    CPU ms  (mean per decode)\n");
+    for (i = 0; i < WSPRD_STAGES; i++) {
+        printf("%-10s %10.1f %9.1f\n", stage_names[i], 1e3 * t->wall_seconds[i] / ndecodes,
+               1e3 * t->cpu_seconds[i] / ndecodes);
+    }
+    printf("%-10s %10.1f %9.1f\n", "total", 1e3 * t->total_wall_seconds / ndecodes,
+           1e3 * t->total_cpu_seconds / ndecodes);
+    printf("\nPass  Candidates  Decodes  (mean per decode)\n");
+    for (i = 0; i < WSPRD_MAX_PASSES && t->candidates[i] > 0; i++) {
+        printf("%4d %11.1f %8.2f\n", i, (double) t->candidates[i] / ndecodes,
+               (double) t->pass_decodes[i] / ndecodes);
+    }
+    printf("\nDecoder attempts %.1f, timeouts %.1f, cycles %.0f, OSD %.1f/%.2f, "
+           "subtractions %.2f per decode\n",
+           (double) t->decoder_attempts / ndecodes, (double) t->decoder_timeouts / ndecodes,
+           (double) t->decoder_cycles / ndecodes, (double) t->osd_attempts / ndecodes,
+           (double) t->osd_decodes / ndecodes, (double) t->subtractions / ndecodes);
+    printf("Peak scratch %.1f MB\n", cfg->max_scratch_bytes / 1048576.0);
+}
+
+// "K1ABC FN42 7" and "K1ABC FN42  7" are the same message
+static void normalize_message(const char *in, char *out) {
+    char call[23] = "", grid[23] = "";
+    int power = 0, n;
+
+    n = sscanf(in, "%22s %22s %d", call, grid, &power);
+    if (n == 3) {
+        snprintf(out, 23, "%s %s %d", call, grid, power);
+    } else if (n == 2) {
+        snprintf(out, 23, "%s %s", call, grid);  // Type 2: CALL/P POWER
+    } else {
+        snprintf(out, 23, "%s", in);
+    }
+}
+
+static void make_frame(const struct mc_config *cfg, int isnr, int trial, short *pcm) {
+    struct wsprsim_signal sigs[1 + MAX_INTERFERERS];
+    struct wsprsim_rng rng;
+    int k;
+
+    wsprsim_rng_seed(&rng, cfg->seed * 0x100000001B3ULL ^ ((uint64_t) isnr << 32) ^ trial);
+    for (k = 0; k <= cfg->ninterferers; k++) {
+        memcpy(sigs[k].symbols, cfg->symbols[k], 162);
+        sigs[k].snr = cfg->snr[isnr];
+        sigs[k].freq = cfg->freq_spread * (2.0 * wsprsim_uniform(&rng) - 1.0);
+        sigs[k].dt = cfg->dt_spread * (2.0 * wsprsim_uniform(&rng) - 1.0);
+        sigs[k].drift = cfg->max_drift * (2.0 * wsprsim_uniform(&rng) - 1.0);
+    }
+    wsprsim_pcm(sigs, cfg->ninterferers + 1, &rng, pcm);
+}
+
+static void *mc_worker(void *arg) {
+    struct mc_config *cfg = arg;
+    struct wsprd_decode decodes[WSPRD_MAX_DECODES];
+    struct wsprd_options opts = cfg->opts;
+    struct wsprd_stats stats;
+    short *pcm = malloc(sizeof(short) * WSPRSIM_PCM_SAMPLES);
+    char msg[23];
+    long job;
+    int i, k, ndec, isnr, trial, found, bogus;
+    double t0, t1;
+
+    for (;;) {
+        pthread_mutex_lock(&cfg->lock);
+        job = cfg->next_job++;
+        pthread_mutex_unlock(&cfg->lock);
+        if (job >= (long) cfg->nsnr * cfg->ntrials) break;
+        isnr = job / cfg->ntrials;
+        trial = job % cfg->ntrials;
+
+        t0 = wall_seconds();
+        make_frame(cfg, isnr, trial, pcm);
+        t1 = wall_seconds();
+        opts.stats = &stats;
+        ndec = wsprd_decode((unsigned char *) pcm, sizeof(short) * WSPRSIM_PCM_SAMPLES, 14.0956,
+                            0, &opts, decodes, WSPRD_MAX_DECODES);
+
+        found = bogus = 0;
+        for (i = 0; i < ndec; i++) {
+            normalize_message(decodes[i].message, msg);
+            for (k = 0; k <= cfg->ninterferers; k++) {
+                if (!strcmp(msg, cfg->expected[k])) break;
+            }
+            if (k == 0) found = 1;
+            if (k > cfg->ninterferers) bogus++;
+        }
+
+        pthread_mutex_lock(&cfg->lock);
+        cfg->results[isnr].trials++;
+        cfg->results[isnr].decoded += found;
+        cfg->results[isnr].false_decodes += bogus;
+        cfg->results[isnr].synth_seconds += t1 - t0;
+        cfg->results[isnr].decode_seconds += wall_seconds() - t1;
+        cfg->results[isnr].decode_cpu_seconds += stats.total_cpu_seconds;
+        stats_add(&cfg->totals, &stats);
+        if (stats.peak_scratch_bytes > cfg->max_scratch_bytes) {
+            cfg->max_scratch_bytes = stats.peak_scratch_bytes;
+        }
+        pthread_mutex_unlock(&cfg->lock);
+    }
+    free(pcm);
+    return NULL;
+}
+
+static void usage(void) {
+    printf("Usage: wsprmc [options...]\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("       -m \"msg\" message to send, default \"K1ABC FN42 37\"\n");
+    printf("       -s lo:hi:step SNR sweep in dB, default -32:-22:1\n");
+    printf("       -n trials per SNR, default 100\n");
+    printf("       -t worker threads, default one per CPU\n");
+    printf("       -x seed, default 1\n");
+    printf("       -k n add n interferers at the same SNR (0..%d)\n", MAX_INTERFERERS);
+    printf("       -f x frequencies uniform in +/- x Hz, default 90\n");
+    printf("       -T x time offsets uniform in +/- x s, default 1\n");
+    printf("       -r x drifts uniform in +/- x Hz, default 0\n");
+    printf("       -w file.wav write the first frame of the sweep and exit\n");
+    printf("       -c file.c2 write it as a .c2 file and exit\n");
+    printf("Decoder options:\n");
+    printf("       -A adaptive cycle budget\n");
+    printf("       -D deep search\n");
+    printf("       -J stack decoder\n");
+    printf("       -o n OSD depth\n");
+    printf("       -p n max passes\n");
+    printf("       -j n decoder threads per decode\n");
+    printf("       -z x Fano metric bias\n");
+}
+
+static int write_c2(const char *filename, const struct mc_config *cfg) {
+    struct wsprsim_signal sig;
+    struct wsprsim_rng rng;
+    static double idat[WSPRSIM_C2_SAMPLES], qdat[WSPRSIM_C2_SAMPLES];
+    float buffer[2 * WSPRSIM_C2_SAMPLES];
+    char name[14];
+    int trmin = 2, i;
+    double freq = 10.1387;
+    FILE *fp;
+
+    memcpy(sig.symbols, cfg->symbols[0], 162);
+    sig.snr = cfg->snr[0];
+    sig.freq = sig.dt = sig.drift = 0.0;
+    wsprsim_rng_seed(&rng, cfg->seed);
+    wsprsim_c2(&sig, 1, &rng, idat, qdat);
+
+    // Same layout as wsprsim's writec2file()
+    if ((fp = fopen(filename, "wb")) == NULL) return 0;
+    memset(name, 0, sizeof(name));
+    strncpy(name, filename, sizeof(name) - 1);
+    fwrite(name, sizeof(char), 14, fp);
+    fwrite(&trmin, sizeof(int), 1, fp);
+    fwrite(&freq, sizeof(double), 1, fp);
+    for (i = 0; i < WSPRSIM_C2_SAMPLES; i++) {
+        buffer[2 * i] = idat[i];
+        buffer[2 * i + 1] = -qdat[i];
+    }
+    fwrite(buffer, sizeof(float), 2 * WSPRSIM_C2_SAMPLES, fp);
+    return fclose(fp) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    static struct mc_config cfg;
+    float lo = -32, hi = -22, step = 1;
+    int nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    const char *wavfile = NULL, *c2file = NULL;
+    pthread_t *threads;
+    double t0, elapsed;
+    int c, i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.message = "K1ABC FN42 37";
+    cfg.ntrials = 100;
+    cfg.seed = 1;
+    cfg.freq_spread = 90.0;
+    cfg.dt_spread = 1.0;
+    wsprd_options_init(&cfg.opts);
+
+    while ((c = getopt(argc, argv, "Ac:Df:hj:Jk:m:n:o:p:r:s:t:T:w:x:z:")) != -1) {
+        switch (c) {
+            case 'A':
+                cfg.opts.adaptive_cycles = 1;
+                break;
+            case 'c':
+                c2file = optarg;
+                break;
+            case 'D':
+                cfg.opts.deep_search = 1;
+                break;
+            case 'f':
+                cfg.freq_spread = strtof(optarg, NULL);
+                break;
+            case 'j':
+                cfg.opts.decode_threads = atoi(optarg);
+                break;
+            case 'J':
+                cfg.opts.stack_decoder = 1;
+                break;
+            case 'k':
+                cfg.ninterferers = atoi(optarg);
+                if (cfg.ninterferers < 0 || cfg.ninterferers > MAX_INTERFERERS) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'm':
+                cfg.message = optarg;
+                break;
+            case 'n':
+                cfg.ntrials = atoi(optarg);
+                break;
+            case 'o':
+                cfg.opts.osd_depth = atoi(optarg);
+                break;
+            case 'p':
+                cfg.opts.max_passes = atoi(optarg);
+                break;
+            case 'r':
+                cfg.max_drift = strtof(optarg, NULL);
+                break;
+            case 's':
+                if (sscanf(optarg, "%f:%f:%f", &lo, &hi, &step) != 3 || step <= 0) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 't':
+                nthreads = atoi(optarg);
+                break;
+            case 'T':
+                cfg.dt_spread = strtof(optarg, NULL);
+                break;
+            case 'w':
+                wavfile = optarg;
+                break;
+            case 'x':
+                cfg.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'z':
+                cfg.opts.metric_bias = strtof(optarg, NULL);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (nthreads < 1) nthreads = 1;
+
+    for (cfg.nsnr = 0; lo + cfg.nsnr * step <= hi + 1e-3 && cfg.nsnr < MAX_SNRS; cfg.nsnr++) {
+        cfg.snr[cfg.nsnr] = lo + cfg.nsnr * step;
+    }
+
+    // The message parser is not thread-safe: encode everything up front
+    if (!wsprsim_symbols(cfg.message, cfg.symbols[0])) {
+        fprintf(stderr, "Cannot encode message '%s'\n", cfg.message);
+        return 1;
+    }
+    normalize_message(cfg.message, cfg.expected[0]);
+    for (i = 1; i <= cfg.ninterferers; i++) {
+        wsprsim_symbols(interferer_msgs[i - 1], cfg.symbols[i]);
+        normalize_message(interferer_msgs[i - 1], cfg.expected[i]);
+    }
+
+    if (wavfile != NULL || c2file != NULL) {
+        short *pcm = malloc(sizeof(short) * WSPRSIM_PCM_SAMPLES);
+        int ok = 1;
+
+        if (wavfile != NULL) {
+            make_frame(&cfg, 0, 0, pcm);
+            ok = wsprsim_write_wav(wavfile, pcm, WSPRSIM_PCM_SAMPLES);
+        }
+        if (c2file != NULL) ok = ok && write_c2(c2file, &cfg);
+        free(pcm);
+        return ok ? 0 : 1;
+    }
+
+    pthread_mutex_init(&cfg.lock, NULL);
+    threads = malloc(sizeof(pthread_t) * nthreads);
+    t0 = wall_seconds();
+    for (i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, mc_worker, &cfg);
+    }
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    elapsed = wall_seconds() - t0;
+
+    printf("Message \"%s\", %d interferers, %d trials per SNR, %d threads, seed %llu\n",
+           cfg.message, cfg.ninterferers, cfg.ntrials, nthreads, (unsigned long long) cfg.seed);
+    printf("  SNR  Trials  Decoded  P(decode)  False   Synth ms  Decode ms    CPU ms\n");
+    for (i = 0; i < cfg.nsnr; i++) {
+        struct snr_result *r = &cfg.results[i];
+        printf("%5.1f %7lu %8lu %10.3f %6lu %10.1f %10.1f %9.1f\n", cfg.snr[i], r->trials,
+               r->decoded, (double) r->decoded / r->trials, r->false_decodes,
+               1e3 * r->synth_seconds / r->trials, 1e3 * r->decode_seconds / r->trials,
+               1e3 * r->decode_cpu_seconds / r->trials);
+    }
+    print_stage_stats(&cfg, (long) cfg.nsnr * cfg.ntrials);
+    printf("\nTotal %.1f s\n", elapsed);
+
+    free(threads);
+    pthread_mutex_destroy(&cfg.lock);
+    return 0;
+}
@@ -169,7 +169,10 @@ int main(int argc, char *argv[])
     }
     
     unsigned char channel_symbols[162];
-    get_wspr_channel_symbols(message, hashtab, channel_symbols);
+    if( !get_wspr_channel_symbols(message, hashtab, channel_symbols) ) {
+        fprintf(stderr, "Cannot encode message '%s'\n", message);
+        return 1;
+    }
     
     if( printchannel ) {
         printf("Channel symbols:\n");
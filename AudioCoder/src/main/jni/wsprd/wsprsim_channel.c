@@ -0,0 +1,158 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprsim_channel.c
+
+ Description: WSPR channel simulator, see wsprsim_channel.h. The c2
+ synthesis is add_signal_vector() from wsprsim.c with drift added.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "wsprsim_channel.h"
+#include "wsprsim_utils.h"
+
+#define WSPR_SYMBOL_SECONDS (8192.0 / 12000.0)
+
+// splitmix64: small, fast and good enough for noise
+static uint64_t rng_next(struct wsprsim_rng *rng) {
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void wsprsim_rng_seed(struct wsprsim_rng *rng, uint64_t seed) {
+    rng->state = seed;
+    rng->have_spare = 0;
+    rng->spare = 0.0;
+}
+
+double wsprsim_uniform(struct wsprsim_rng *rng) {
+    return (rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Marsaglia polar method, as in gran.c and wsprsim.c's gaussrand()
+double wsprsim_gauss(struct wsprsim_rng *rng) {
+    double v1, v2, s;
+
+    if (rng->have_spare) {
+        rng->have_spare = 0;
+        return rng->spare;
+    }
+    do {
+        v1 = 2.0 * wsprsim_uniform(rng) - 1.0;
+        v2 = 2.0 * wsprsim_uniform(rng) - 1.0;
+        s = v1 * v1 + v2 * v2;
+    } while (s >= 1.0 || s == 0.0);
+    s = sqrt(-2.0 * log(s) / s);
+    rng->spare = v2 * s;
+    rng->have_spare = 1;
+    return v1 * s;
+}
+
+int wsprsim_symbols(const char *message, unsigned char *symbols) {
+    char *hashtab = calloc(32768 * 13, sizeof(char));
+    char msg[23];
+    int ok;
+
+    if (hashtab == NULL) return 0;
+    memset(msg, 0, sizeof(msg));
+    strncpy(msg, message, 22);
+    ok = get_wspr_channel_symbols(msg, hashtab, symbols);
+    free(hashtab);
+    return ok;
+}
+
+void wsprsim_pcm(const struct wsprsim_signal *sigs, int nsig, struct wsprsim_rng *rng, short *pcm) {
+    double *x = calloc(WSPRSIM_PCM_SAMPLES, sizeof(double));
+    double twopi = 8.0 * atan(1.0), df = 1.0 / WSPR_SYMBOL_SECONDS;
+    int nsym = (int) (WSPR_SYMBOL_SECONDS * WSPRSIM_PCM_RATE);
+    int i, j, k, start;
+
+    for (k = 0; k < nsig; k++) {
+        const struct wsprsim_signal *s = &sigs[k];
+        // Signal power relative to the noise power in 2500 Hz
+        double amp = sqrt(2.0 * pow(10.0, s->snr / 10.0) * 2500.0 / (WSPRSIM_PCM_RATE / 2.0)) *
+                     WSPRSIM_PCM_NOISE;
+        double phi = 0.0, t, f;
+
+        start = (int) lround((1.0 + s->dt) * WSPRSIM_PCM_RATE);
+        for (i = 0; i < 162 * nsym; i++) {
+            j = start + i;
+            t = (double) i / (162 * nsym) - 0.5;
+            f = 1500.0 + s->freq + s->drift * t + ((double) s->symbols[i / nsym] - 1.5) * df;
+            phi += twopi * f / WSPRSIM_PCM_RATE;
+            if (phi > twopi) phi -= twopi;
+            if (j >= 0 && j < WSPRSIM_PCM_SAMPLES) x[j] += amp * sin(phi);
+        }
+    }
+    for (i = 0; i < WSPRSIM_PCM_SAMPLES; i++) {
+        double v = x[i] + (rng != NULL ? WSPRSIM_PCM_NOISE * wsprsim_gauss(rng) : 0.0);
+        pcm[i] = v > 32767.0 ? 32767 : v < -32768.0 ? -32768 : (short) lround(v);
+    }
+    free(x);
+}
+
+void wsprsim_c2(const struct wsprsim_signal *sigs, int nsig, struct wsprsim_rng *rng,
+                double *idat, double *qdat) {
+    double twopidt = 8.0 * atan(1.0) / 375.0, df = 375.0 / 256.0, dt = 1.0 / 375.0;
+    int i, j, k, ii, idelay;
+
+    for (i = 0; i < WSPRSIM_C2_SAMPLES; i++) {
+        idat[i] = rng != NULL ? wsprsim_gauss(rng) : 0.0;
+        qdat[i] = rng != NULL ? wsprsim_gauss(rng) : 0.0;
+    }
+    for (k = 0; k < nsig; k++) {
+        const struct wsprsim_signal *s = &sigs[k];
+        // snr in 375 Hz is 8.2 dB higher than in 2500 Hz
+        double amp = pow(10.0, (s->snr + 8.2) / 20.0) * sqrt(2.0);
+        double phi = 0.0, dphi, f;
+
+        idelay = (int) lround((1.0 + s->dt) / dt);
+        for (i = 0; i < 162; i++) {
+            for (j = 0; j < 256; j++) {
+                f = s->freq + s->drift * ((256.0 * i + j) / (162.0 * 256.0) - 0.5);
+                dphi = twopidt * (f + ((double) s->symbols[i] - 1.5) * df);
+                ii = idelay + 256 * i + j;
+                if (ii >= 0 && ii < WSPRSIM_C2_SAMPLES) {
+                    idat[ii] += amp * cos(phi);
+                    qdat[ii] += amp * sin(phi);
+                }
+                phi += dphi;
+            }
+        }
+    }
+}
+
+static void put_le(FILE *fp, uint32_t v, int nbytes) {
+    while (nbytes-- > 0) {
+        fputc(v & 0xff, fp);
+        v >>= 8;
+    }
+}
+
+int wsprsim_write_wav(const char *filename, const short *pcm, int nsamples) {
+    FILE *fp = fopen(filename, "wb");
+    int i;
+
+    if (fp == NULL) return 0;
+    fwrite("RIFF", 1, 4, fp);
+    put_le(fp, 36 + 2 * nsamples, 4);
+    fwrite("WAVEfmt ", 1, 8, fp);
+    put_le(fp, 16, 4);                        // fmt chunk size
+    put_le(fp, 1, 2);                         // PCM
+    put_le(fp, 1, 2);                         // mono
+    put_le(fp, WSPRSIM_PCM_RATE, 4);
+    put_le(fp, 2 * WSPRSIM_PCM_RATE, 4);      // byte rate
+    put_le(fp, 2, 2);                         // block align
+    put_le(fp, 16, 2);                        // bits per sample
+    fwrite("data", 1, 4, fp);
+    put_le(fp, 2 * nsamples, 4);
+    for (i = 0; i < nsamples; i++) {
+        put_le(fp, (uint16_t) pcm[i], 2);
+    }
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,70 @@
+/*
+ This file is part of wsprd.
+
+ File name: wsprsim_channel.h
+
+ Description: WSPR channel simulator. Synthesizes any number of WSPR
+ signals with chosen SNR, time offset, frequency and drift plus white
+ Gaussian noise, as 12 kHz PCM (what wsprd_decode() takes) or as the
+ 375 Hz complex baseband of a .c2 file. Synthesis is thread-safe: every
+ caller owns its random number generator.
+ */
+
+#ifndef WSPRSIM_CHANNEL_H
+#define WSPRSIM_CHANNEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WSPRSIM_PCM_RATE    12000
+#define WSPRSIM_PCM_SAMPLES (114 * WSPRSIM_PCM_RATE)  // one 114 s decode window
+#define WSPRSIM_C2_SAMPLES  45000                     // 120 s at 375 Hz
+
+struct wsprsim_signal {
+    unsigned char symbols[162];  // channel symbols 0..3, see wsprsim_symbols()
+    float snr;                   // dB in 2500 Hz, as wsprd reports it
+    float dt;                    // seconds after the nominal start, 1 s into the window
+    float freq;                  // Hz from 1500 Hz, centre of the four tones
+    float drift;                 // Hz change over the whole transmission
+};
+
+struct wsprsim_rng {
+    uint64_t state;
+    int have_spare;
+    double spare;
+};
+
+void wsprsim_rng_seed(struct wsprsim_rng *rng, uint64_t seed);
+double wsprsim_uniform(struct wsprsim_rng *rng);  // [0, 1)
+double wsprsim_gauss(struct wsprsim_rng *rng);    // mean 0, variance 1
+
+// Channel symbols for a message such as "K1ABC FN42 37"; returns 0 if it cannot
+// be packed. Not thread-safe: the message parser uses strtok().
+int wsprsim_symbols(const char *message, unsigned char *symbols);
+
+/*
+ * WSPRSIM_PCM_SAMPLES 16-bit samples holding the signals plus noise of
+ * rms WSPRSIM_PCM_NOISE. With rng NULL no noise is added and snr only
+ * sets the amplitudes.
+ */
+#define WSPRSIM_PCM_NOISE 1000.0
+void wsprsim_pcm(const struct wsprsim_signal *sigs, int nsig, struct wsprsim_rng *rng, short *pcm);
+
+/*
+ * WSPRSIM_C2_SAMPLES complex baseband samples centred on 1500 Hz, with
+ * unit-variance noise in each of i and q (none if rng is NULL).
+ */
+void wsprsim_c2(const struct wsprsim_signal *sigs, int nsig, struct wsprsim_rng *rng,
+                double *idat, double *qdat);
+
+// Writes mono 16-bit PCM as a .wav file; returns 0 on failure
+int wsprsim_write_wav(const char *filename, const short *pcm, int nsamples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,4 +13,7 @@ extern int printdata;
 
 int get_wspr_channel_symbols(char* message, char* hashtab, unsigned char* symbols);
 
+// Channel symbols for the 50 message bits in data[0..6], as decoded by fano()
+void get_wspr_channel_symbols_from_data(const unsigned char* data, unsigned char* symbols);
+
 #endif